@@ -0,0 +1,53 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ASTArena.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+thread_local ASTArena* currentArena = nullptr;
+}
+
+std::string_view ASTArena::copy(std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+    auto* characters = static_cast<char*>(allocate(text.size(), 1));
+    std::memcpy(characters, text.data(), text.size());
+    return {characters, text.size()};
+}
+
+ASTArena& ASTArena::current() {
+    if (currentArena == nullptr) {
+        throw std::logic_error("No AST arena is in use on this thread");
+    }
+    return *currentArena;
+}
+
+ASTArena::Scope::Scope(ASTArena& arena) : _previous(currentArena) {
+    currentArena = &arena;
+}
+
+ASTArena::Scope::~Scope() {
+    currentArena = _previous;
+}
+
+void* ASTArena::allocateChunk(size_t size, size_t alignment) {
+    // Chunk memory is aligned for any node, big requests get a chunk of their own
+    auto capacity = std::max(chunkSize, size + alignment);
+    _chunks.push_back(std::make_unique_for_overwrite<std::byte[]>(capacity));
+    _allocatedBytes += capacity;
+
+    auto* chunk = _chunks.back().get();
+    // Keeps filling the current chunk when the new one only holds this request
+    if (capacity - size - alignment >= _capacity - _used) {
+        _chunk = chunk;
+        _capacity = capacity;
+        _used = 0;
+        return allocate(size, alignment);
+    }
+    return chunk;
+}
@@ -0,0 +1,163 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_ASTARENA_HPP
+#define VUG_ASTARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator holding every node of a compilation, laid out in the order they are created.
+// Nothing in it is ever destroyed: nodes keep no memory outside the arena, and dropping the arena
+// frees its chunks at once instead of walking the tree.
+class ASTArena {
+public:
+    static constexpr size_t chunkSize = 64 * 1024;
+
+    ASTArena() = default;
+
+    ASTArena(const ASTArena&) = delete;
+    ASTArena& operator=(const ASTArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment) {
+        auto offset = (_used + alignment - 1) & ~(alignment - 1);
+        if (offset + size > _capacity) {
+            return allocateChunk(size, alignment);
+        }
+        _used = offset + size;
+        return _chunk + offset;
+    }
+
+    std::string_view copy(std::string_view text);
+
+    [[nodiscard]] size_t getAllocatedBytes() const {
+        return _allocatedBytes;
+    }
+
+    // The arena nodes and node lists come from on this thread
+    static ASTArena& current();
+
+    // Makes an arena the current one on this thread while it lives
+    class Scope {
+    public:
+        explicit Scope(ASTArena& arena);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ASTArena* _previous;
+    };
+
+private:
+    std::vector<std::unique_ptr<std::byte[]>> _chunks;
+    std::byte* _chunk{nullptr};
+    size_t _used{0};
+    size_t _capacity{0};
+    size_t _allocatedBytes{0};
+
+    void* allocateChunk(size_t size, size_t alignment);
+};
+
+// Lets standard containers of the AST allocate from the current arena, freeing leaves the memory there
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() : _arena(&ASTArena::current()) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other.getArena()) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) {}
+
+    [[nodiscard]] ASTArena* getArena() const {
+        return _arena;
+    }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return _arena == other.getArena();
+    }
+
+private:
+    ASTArena* _arena;
+};
+
+// Owns a node the way unique_ptr would: moving it transfers the node and leaves null behind.
+// Destroying it leaves the node to the arena.
+template<typename T>
+class NodePtr {
+public:
+    NodePtr() = default;
+    NodePtr(std::nullptr_t) {}
+    explicit NodePtr(T* node) : _node(node) {}
+
+    NodePtr(NodePtr&& other) noexcept : _node(other.release()) {}
+    template<typename U> requires std::is_convertible_v<U*, T*>
+    NodePtr(NodePtr<U>&& other) noexcept : _node(other.release()) {}
+
+    NodePtr& operator=(NodePtr&& other) noexcept {
+        _node = other.release();
+        return *this;
+    }
+    template<typename U> requires std::is_convertible_v<U*, T*>
+    NodePtr& operator=(NodePtr<U>&& other) noexcept {
+        _node = other.release();
+        return *this;
+    }
+    NodePtr& operator=(std::nullptr_t) noexcept {
+        _node = nullptr;
+        return *this;
+    }
+
+    NodePtr(const NodePtr&) = delete;
+    NodePtr& operator=(const NodePtr&) = delete;
+
+    [[nodiscard]] T* get() const {
+        return _node;
+    }
+    T* release() {
+        return std::exchange(_node, nullptr);
+    }
+    void reset(T* node = nullptr) {
+        _node = node;
+    }
+
+    T& operator*() const {
+        return *_node;
+    }
+    T* operator->() const {
+        return _node;
+    }
+    explicit operator bool() const {
+        return _node != nullptr;
+    }
+    bool operator==(std::nullptr_t) const {
+        return _node == nullptr;
+    }
+
+private:
+    T* _node{nullptr};
+};
+
+template<typename T>
+using NodeList = std::vector<NodePtr<T>, ArenaAllocator<NodePtr<T>>>;
+
+template<typename T, typename... Args>
+NodePtr<T> makeNode(Args&&... args) {
+    auto& arena = ASTArena::current();
+    return NodePtr<T>(new(arena.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...));
+}
+
+#endif//VUG_ASTARENA_HPP
@@ -0,0 +1,127 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_ASTTRAVERSAL_HPP
+#define VUG_ASTTRAVERSAL_HPP
+
+#include "AST/ASTNodes.hpp"
+#include "Misc/Stack.hpp"
+
+// Calls `visitor` for every direct child of `node`, in the order the evaluator visits them
+template<typename Visitor>
+void forEachChild(Node& node, Visitor&& visitor) {
+    switch (node.kind) {
+        case Node::Kind::ModuleDeclaration:
+            visitor(static_cast<Node&>(*static_cast<ModuleDeclaration&>(node).body));
+            break;
+        case Node::Kind::DeclarationsBlock:
+            for (const auto& declaration: static_cast<DeclarationsBlock&>(node).declarations) {
+                visitor(static_cast<Node&>(*declaration));
+            }
+            break;
+        case Node::Kind::FunctionDeclaration: {
+            auto& functionNode = static_cast<FunctionDeclaration&>(node);
+            for (const auto& parameter: functionNode.parameters) {
+                visitor(static_cast<Node&>(*parameter));
+            }
+            visitor(static_cast<Node&>(*functionNode.definition));
+            break;
+        }
+        case Node::Kind::BinaryOperation:
+            visitor(static_cast<Node&>(*static_cast<BinaryOperation&>(node).left));
+            visitor(static_cast<Node&>(*static_cast<BinaryOperation&>(node).right));
+            break;
+        case Node::Kind::PrefixOperation:
+            visitor(static_cast<Node&>(*static_cast<PrefixOperation&>(node).right));
+            break;
+        case Node::Kind::CallFunction:
+            for (const auto& argument: static_cast<CallFunction&>(node).arguments) {
+                visitor(static_cast<Node&>(*argument));
+            }
+            break;
+        case Node::Kind::Assign:
+            visitor(static_cast<Node&>(*static_cast<Assign&>(node).value));
+            break;
+        case Node::Kind::LocalVarDeclaration:
+            visitor(static_cast<Node&>(*static_cast<LocalVariableDeclaration&>(node).value));
+            break;
+        case Node::Kind::Print:
+            visitor(static_cast<Node&>(*static_cast<Print&>(node).expression));
+            break;
+        case Node::Kind::Return:
+            visitor(static_cast<Node&>(*static_cast<Return&>(node).returnExpression));
+            break;
+        case Node::Kind::StatementBlock:
+            for (const auto& statement: static_cast<StatementsBlock&>(node).statements) {
+                visitor(static_cast<Node&>(*statement));
+            }
+            break;
+        case Node::Kind::If: {
+            auto& ifNode = static_cast<If&>(node);
+            visitor(static_cast<Node&>(*ifNode.condition));
+            visitor(static_cast<Node&>(*ifNode.then));
+            if (ifNode.elseThen != nullptr) {
+                visitor(static_cast<Node&>(*ifNode.elseThen));
+            }
+            break;
+        }
+        case Node::Kind::While:
+            visitor(static_cast<Node&>(*static_cast<While&>(node).condition));
+            visitor(static_cast<Node&>(*static_cast<While&>(node).body));
+            break;
+        default:
+            break;
+    }
+}
+
+// Calls `visitor` with the owning pointer of every direct child expression of `node`, in evaluation order
+template<typename Visitor>
+void forEachExpressionSlot(Node& node, Visitor&& visitor) {
+    switch (node.kind) {
+        case Node::Kind::BinaryOperation:
+            visitor(static_cast<BinaryOperation&>(node).left);
+            visitor(static_cast<BinaryOperation&>(node).right);
+            break;
+        case Node::Kind::PrefixOperation:
+            visitor(static_cast<PrefixOperation&>(node).right);
+            break;
+        case Node::Kind::CallFunction:
+            for (auto& argument: static_cast<CallFunction&>(node).arguments) {
+                visitor(argument);
+            }
+            break;
+        case Node::Kind::Assign:
+            visitor(static_cast<Assign&>(node).value);
+            break;
+        case Node::Kind::LocalVarDeclaration:
+            visitor(static_cast<LocalVariableDeclaration&>(node).value);
+            break;
+        case Node::Kind::Print:
+            visitor(static_cast<Print&>(node).expression);
+            break;
+        case Node::Kind::Return:
+            visitor(static_cast<Return&>(node).returnExpression);
+            break;
+        case Node::Kind::If:
+            visitor(static_cast<If&>(node).condition);
+            break;
+        case Node::Kind::While:
+            visitor(static_cast<While&>(node).condition);
+            break;
+        default:
+            break;
+    }
+}
+
+// Number of nodes in the subtree, the size measure of the optimization passes
+inline size_t getNodeCount(Node& node) {
+    stackGuard();
+
+    size_t count = 1;
+    forEachChild(node, [&count](Node& child) {
+        count += getNodeCount(child);
+    });
+    return count;
+}
+
+#endif//VUG_ASTTRAVERSAL_HPP
@@ -0,0 +1,191 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "FlatAST.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "AST/ASTNodes.hpp"
+#include "AST/ASTTraversal.hpp"
+#include "Misc/Stack.hpp"
+#include "Semantic/Type.hpp"
+
+namespace {
+FlatAST::Operation getBinaryOperation(LexemType type, const Type& operandType) {
+    using Operation = FlatAST::Operation;
+
+    if (operandType.isInteger()) {
+        switch (type) {
+            case LexemType::Equal:
+                return Operation::Equal;
+            case LexemType::Unequal:
+                return Operation::Unequal;
+            case LexemType::Less:
+                return Operation::Less;
+            case LexemType::LessEqual:
+                return Operation::LessEqual;
+            case LexemType::Greater:
+                return Operation::Greater;
+            case LexemType::GreaterEqual:
+                return Operation::GreaterEqual;
+            case LexemType::Plus:
+                return Operation::Add;
+            case LexemType::Minus:
+                return Operation::Subtract;
+            case LexemType::Multiply:
+                return Operation::Multiply;
+            case LexemType::Divide:
+                return Operation::Divide;
+            case LexemType::Remainder:
+                return Operation::Remainder;
+            default:
+                return Operation::Unsupported;
+        }
+    }
+    switch (type) {
+        case LexemType::LogicAnd:
+            return Operation::LogicAnd;
+        case LexemType::LogicOr:
+            return Operation::LogicOr;
+        default:
+            return Operation::Unsupported;
+    }
+}
+FlatAST::Operation getPrefixOperation(LexemType type, const Type& operandType) {
+    using Operation = FlatAST::Operation;
+
+    if (operandType.isInteger()) {
+        return type == LexemType::Minus ? Operation::Negate : Operation::Unsupported;
+    }
+    return type == LexemType::Not ? Operation::Not : Operation::Unsupported;
+}
+}// namespace
+
+struct FlatAST::Flattening {
+    std::unordered_map<const FunctionSymbol*, uint32_t> functionIndices;
+    // Slots of the function being flattened
+    std::unordered_map<const LocalVariableSymbol*, uint32_t> slots;
+    // Enclosing loops, the innermost one last
+    std::vector<std::pair<const Node*, NodeId>> loops;
+    // Children of the nodes being flattened, each node lists its own above what it found
+    std::vector<NodeId> pendingChildren;
+
+    uint32_t getFunction(const FunctionSymbol& symbol, std::vector<Function>& functions) {
+        auto [iterator, isInserted] = functionIndices.try_emplace(&symbol, static_cast<uint32_t>(functions.size()));
+        if (isInserted) {
+            functions.emplace_back().symbol = &symbol;
+        }
+        return iterator->second;
+    }
+    uint32_t getSlot(const LocalVariableSymbol& symbol) {
+        return slots.try_emplace(&symbol, static_cast<uint32_t>(slots.size())).first->second;
+    }
+};
+
+FlatAST FlatAST::flatten(Node& ast) {
+    if (ast.kind != Node::Kind::ModuleDeclaration) {
+        throw std::logic_error("Only a module can be flattened");
+    }
+
+    auto flatAst = FlatAST();
+    auto flattening = Flattening();
+    flatAst.add(ast, flattening);
+
+    auto& mainSymbol = *static_cast<ModuleDeclaration&>(ast).symbolRef->findMember("main")[0];
+    flatAst._mainFunction = flattening.getFunction(static_cast<FunctionSymbol&>(mainSymbol), flatAst._functions);
+    for (const auto& function: flatAst._functions) {
+        if (function.definition == noNode) {
+            throw std::logic_error("Called function is not in the module");
+        }
+    }
+    return flatAst;
+}
+
+NodeId FlatAST::add(Node& node, Flattening& flattening) {
+    stackGuard();
+
+    auto id = static_cast<NodeId>(_kinds.size());
+    _kinds.push_back(node.kind);
+    _sourceLocations.push_back(node.sourceLocation);
+    _firstChildren.push_back(0);
+    _childCounts.push_back(0);
+    _payloads.push_back(computePayload(node, id, flattening));
+
+    auto& pending = flattening.pendingChildren;
+    auto base = pending.size();
+    forEachChild(node, [&](Node& child) {
+        auto childId = add(child, flattening);
+        pending.push_back(childId);
+    });
+    _firstChildren[id] = static_cast<uint32_t>(_children.size());
+    _childCounts[id] = static_cast<uint32_t>(pending.size() - base);
+    _children.insert(_children.end(), pending.begin() + static_cast<ptrdiff_t>(base), pending.end());
+    pending.resize(base);
+
+    switch (node.kind) {
+        case Node::Kind::FunctionDeclaration: {
+            auto& function = _functions[_payloads[id]];
+            function.declaration = id;
+            function.definition = _children.back();
+            function.parameterCount = static_cast<uint32_t>(static_cast<FunctionDeclaration&>(node).parameters.size());
+            function.slotCount = static_cast<uint32_t>(flattening.slots.size());
+            break;
+        }
+        case Node::Kind::While:
+            flattening.loops.pop_back();
+            break;
+        default:
+            break;
+    }
+    return id;
+}
+uint32_t FlatAST::computePayload(Node& node, NodeId id, Flattening& flattening) {
+    switch (node.kind) {
+        case Node::Kind::ModuleDeclaration:
+        case Node::Kind::DeclarationsBlock:
+        case Node::Kind::StatementBlock:
+        case Node::Kind::If:
+        case Node::Kind::Print:
+        case Node::Kind::Return:
+            return 0;
+        case Node::Kind::FunctionDeclaration:
+            flattening.slots.clear();
+            return flattening.getFunction(*static_cast<FunctionDeclaration&>(node).symbolRef, _functions);
+        case Node::Kind::FunctionParameter:
+            return flattening.getSlot(*static_cast<FunctionParameter&>(node).symbolRef);
+        case Node::Kind::Identifier:
+            return flattening.getSlot(*static_cast<Identifier&>(node).symbolRef);
+        case Node::Kind::Assign:
+            return flattening.getSlot(*static_cast<Assign&>(node).symbolRef);
+        case Node::Kind::LocalVarDeclaration:
+            return flattening.getSlot(*static_cast<LocalVariableDeclaration&>(node).symbolRef);
+        case Node::Kind::CallFunction:
+            return flattening.getFunction(*static_cast<CallFunction&>(node).symbolRef, _functions);
+        case Node::Kind::Number:
+            return static_cast<uint32_t>(std::stoi(std::string(static_cast<Number&>(node).number)));
+        case Node::Kind::BinaryOperation: {
+            auto& operation = static_cast<BinaryOperation&>(node);
+            return static_cast<uint32_t>(getBinaryOperation(operation.operationToken, *operation.left->exprType));
+        }
+        case Node::Kind::PrefixOperation: {
+            auto& operation = static_cast<PrefixOperation&>(node);
+            return static_cast<uint32_t>(getPrefixOperation(operation.operationType, *operation.right->exprType));
+        }
+        case Node::Kind::Break: {
+            const auto* loop = static_cast<Break&>(node).breakedStmt;
+            for (auto enclosing = flattening.loops.rbegin(); enclosing != flattening.loops.rend(); ++enclosing) {
+                if (enclosing->first == loop) {
+                    return enclosing->second;
+                }
+            }
+            throw std::logic_error("Break outside of its loop");
+        }
+        case Node::Kind::While:
+            flattening.loops.emplace_back(&node, id);
+            return 0;
+        default:
+            throw std::logic_error("Unsupported node");
+    }
+}
@@ -0,0 +1,128 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_FLATAST_HPP
+#define VUG_FLATAST_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "AST/Nodes/Node.hpp"
+
+class FunctionSymbol;
+
+// Index of a node in its FlatAST
+using NodeId = uint32_t;
+
+// The checked AST laid out as tables instead of objects: every column is indexed by NodeId and holds one
+// field of every node, so a walk that only switches on kinds and follows children touches kinds and child
+// indices alone. Nodes are numbered in pre-order and children are listed in the order forEachChild gives.
+// Locations are a side table only diagnostics read.
+class FlatAST {
+public:
+    static constexpr NodeId noNode = UINT32_MAX;
+
+    // Operation of a BinaryOperation or PrefixOperation, resolved for the type of its operands.
+    // Operations the evaluator has no objects for are Unsupported and fail when they run.
+    enum class Operation : uint32_t {
+        Unsupported,
+
+        Equal,
+        Unequal,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Remainder,
+        Negate,
+
+        LogicAnd,
+        LogicOr,
+        Not,
+    };
+
+    struct Function {
+        NodeId declaration{noNode};
+        // Body, the last child of the declaration
+        NodeId definition{noNode};
+        // Parameters take the first slots of the frame, in order
+        uint32_t parameterCount{0};
+        // Local variables of the function, one slot each
+        uint32_t slotCount{0};
+        const FunctionSymbol* symbol{nullptr};
+    };
+
+    // Builds the tables from an analyzed module, after the optimization passes are done with it
+    static FlatAST flatten(Node& ast);
+
+    [[nodiscard]] NodeId getRoot() const {
+        return 0;
+    }
+    [[nodiscard]] size_t getNodeCount() const {
+        return _kinds.size();
+    }
+
+    [[nodiscard]] Node::Kind getKind(NodeId node) const {
+        return _kinds[node];
+    }
+    [[nodiscard]] std::span<const NodeId> getChildren(NodeId node) const {
+        return {_children.data() + _firstChildren[node], _childCounts[node]};
+    }
+    [[nodiscard]] NodeId getChild(NodeId node, uint32_t index) const {
+        return _children[_firstChildren[node] + index];
+    }
+    // What a node holds besides its children, by kind:
+    //  FunctionDeclaration, CallFunction                     function index
+    //  FunctionParameter, Identifier, Assign, LocalVarDecl.  frame slot
+    //  BinaryOperation, PrefixOperation                      Operation
+    //  Number                                                value, as int32_t
+    //  Break                                                 NodeId of the loop
+    [[nodiscard]] uint32_t getPayload(NodeId node) const {
+        return _payloads[node];
+    }
+    [[nodiscard]] const SourceLocation& getSourceLocation(NodeId node) const {
+        return _sourceLocations[node];
+    }
+
+    [[nodiscard]] const std::vector<Function>& getFunctions() const {
+        return _functions;
+    }
+    [[nodiscard]] uint32_t getMainFunction() const {
+        return _mainFunction;
+    }
+
+    // Bytes of the columns walks read, locations and functions aside
+    [[nodiscard]] size_t getTableBytes() const {
+        return _kinds.size() * sizeof(Node::Kind) +
+               _firstChildren.size() * sizeof(uint32_t) +
+               _childCounts.size() * sizeof(uint32_t) +
+               _payloads.size() * sizeof(uint32_t) +
+               _children.size() * sizeof(NodeId);
+    }
+
+private:
+    std::vector<Node::Kind> _kinds;
+    // Where the children of a node start in `_children`
+    std::vector<uint32_t> _firstChildren;
+    std::vector<uint32_t> _childCounts;
+    std::vector<uint32_t> _payloads;
+    std::vector<NodeId> _children;
+    std::vector<SourceLocation> _sourceLocations;
+
+    std::vector<Function> _functions;
+    uint32_t _mainFunction{0};
+
+    struct Flattening;
+
+    FlatAST() = default;
+
+    NodeId add(Node& node, Flattening& flattening);
+    uint32_t computePayload(Node& node, NodeId id, Flattening& flattening);
+};
+
+#endif//VUG_FLATAST_HPP
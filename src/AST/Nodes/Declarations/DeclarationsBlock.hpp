@@ -9,9 +9,9 @@
 #include "AST/Nodes/Declaration.hpp"
 
 struct DeclarationsBlock : public Declaration {
-    std::vector<std::unique_ptr<Declaration>> declarations;
+    NodeList<Declaration> declarations;
 
-    DeclarationsBlock(std::vector<std::unique_ptr<Declaration>> declarations,
+    DeclarationsBlock(NodeList<Declaration> declarations,
                       SourceLocation sourceLocation)
         : Declaration(Kind::DeclarationsBlock, sourceLocation),
           declarations(std::move(declarations)) {}
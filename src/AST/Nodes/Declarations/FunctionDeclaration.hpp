@@ -13,21 +13,21 @@
 #include "AST/Nodes/Statements/StatementsBlock.hpp"
 
 struct FunctionDeclaration : public Declaration {
-    std::string name;
-    std::string returnType;
-    std::vector<std::unique_ptr<FunctionParameter>> parameters;
-    std::unique_ptr<StatementsBlock> definition;
+    std::string_view name;
+    std::string_view returnType;
+    NodeList<FunctionParameter> parameters;
+    NodePtr<StatementsBlock> definition;
 
     FunctionSymbol* symbolRef{nullptr};
 
-    FunctionDeclaration(std::string name,
-                        std::string returnType,
-                        std::vector<std::unique_ptr<FunctionParameter>> parameters,
-                        std::unique_ptr<StatementsBlock> definition,
+    FunctionDeclaration(std::string_view name,
+                        std::string_view returnType,
+                        NodeList<FunctionParameter> parameters,
+                        NodePtr<StatementsBlock> definition,
                         SourceLocation sourceLocation)
         : Declaration(Kind::FunctionDeclaration, sourceLocation),
-          name(std::move(name)),
-          returnType(std::move(returnType)),
+          name(name),
+          returnType(returnType),
           parameters(std::move(parameters)),
           definition(std::move(definition)) {}
 
@@ -9,18 +9,18 @@
 #include "AST/Nodes/Expressions/Identifier.hpp"
 
 struct FunctionParameter : public Declaration {
-    std::string type;
-    std::string name;
-    std::unique_ptr<Expression> defaultValue;
+    std::string_view type;
+    std::string_view name;
+    NodePtr<Expression> defaultValue;
 
     LocalVariableSymbol* symbolRef{nullptr};
 
-    FunctionParameter(std::string type,
-                      std::string name,
+    FunctionParameter(std::string_view type,
+                      std::string_view name,
                       SourceLocation sourceLocation)
         : Declaration(Kind::FunctionParameter, sourceLocation),
-          type(std::move(type)),
-          name(std::move(name)) {}
+          type(type),
+          name(name) {}
 
     [[nodiscard]] Symbol* getSymbolPtr() const override {
         return symbolRef;
@@ -10,16 +10,16 @@
 #include "AST/Nodes/Expressions/Identifier.hpp"
 
 struct ModuleDeclaration : public Declaration {
-    std::string name;
-    std::unique_ptr<DeclarationsBlock> body;
+    std::string_view name;
+    NodePtr<DeclarationsBlock> body;
 
     ModuleSymbol* symbolRef{nullptr};
 
-    ModuleDeclaration(std::string name,
-                      std::unique_ptr<DeclarationsBlock> body,
+    ModuleDeclaration(std::string_view name,
+                      NodePtr<DeclarationsBlock> body,
                       SourceLocation sourceLocation)
         : Declaration(Kind::ModuleDeclaration, sourceLocation),
-          name(std::move(name)),
+          name(name),
           body(std::move(body)) {}
 
     [[nodiscard]] Symbol* getSymbolPtr() const override {
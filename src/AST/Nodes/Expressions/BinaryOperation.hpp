@@ -10,12 +10,14 @@
 
 struct BinaryOperation : public Expression {
     LexemType operationToken;
-    std::unique_ptr<Expression> left;
-    std::unique_ptr<Expression> right;
+    NodePtr<Expression> left;
+    NodePtr<Expression> right;
+    // Set by range analysis when the left operand is never negative, signed division may then divide unsigned
+    bool isLeftNonNegative{false};
 
     BinaryOperation(LexemType operationToken,
-                    std::unique_ptr<Expression> left,
-                    std::unique_ptr<Expression> right,
+                    NodePtr<Expression> left,
+                    NodePtr<Expression> right,
                     SourceLocation sourceLocation)
         : Expression(Kind::BinaryOperation, sourceLocation),
           operationToken(operationToken),
@@ -8,16 +8,16 @@
 #include "AST/Nodes/Statement.hpp"
 
 struct CallFunction : public Expression {
-    std::string name;
-    std::vector<std::unique_ptr<Expression>> arguments;
+    std::string_view name;
+    NodeList<Expression> arguments;
 
     FunctionSymbol* symbolRef{nullptr};
 
-    CallFunction(std::string name,
-                 std::vector<std::unique_ptr<Expression>> expressions,
+    CallFunction(std::string_view name,
+                 NodeList<Expression> expressions,
                  SourceLocation sourceLocation)
         : Expression(Kind::CallFunction, sourceLocation),
-          name(std::move(name)),
+          name(name),
           arguments(std::move(expressions)) {}
 
     void accept(ASTWalker& walker) override {
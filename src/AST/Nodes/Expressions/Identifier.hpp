@@ -4,19 +4,19 @@
 #ifndef VUG_IDENTIFIER_HPP
 #define VUG_IDENTIFIER_HPP
 
-#include <string>
+#include <string_view>
 
 #include "AST/Nodes/Expression.hpp"
 
 struct Identifier : public Expression {
-    std::string name;
+    std::string_view name;
 
     LocalVariableSymbol* symbolRef{nullptr};
 
-    explicit Identifier(std::string name,
+    explicit Identifier(std::string_view name,
                         SourceLocation sourceLocation)
         : Expression(Kind::Identifier, sourceLocation),
-          name(std::move(name)) {}
+          name(name) {}
 
     void accept(ASTWalker& walker) override {
         walker.visit(*this);
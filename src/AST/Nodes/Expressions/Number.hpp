@@ -4,18 +4,18 @@
 #ifndef VUG_NUMBER_HPP
 #define VUG_NUMBER_HPP
 
-#include <string>
+#include <string_view>
 #include <utility>
 
 #include "AST/Nodes/Expression.hpp"
 
 struct Number : public Expression {
-    std::string number;
+    std::string_view number;
 
-    explicit Number(std::string num,
+    explicit Number(std::string_view num,
                     SourceLocation sourceLocation)
         : Expression(Kind::Number, sourceLocation),
-          number(std::move(num)) {}
+          number(num) {}
 
     void accept(ASTWalker& walker) override {
         walker.visit(*this);
@@ -8,10 +8,10 @@
 
 struct PrefixOperation : public Expression {
     LexemType operationType;
-    std::unique_ptr<Expression> right;
+    NodePtr<Expression> right;
 
     PrefixOperation(LexemType operationType,
-                    std::unique_ptr<Expression> right,
+                    NodePtr<Expression> right,
                     SourceLocation sourceLocation)
         : Expression(Kind::PrefixOperation, sourceLocation),
           operationType(operationType),
@@ -5,16 +5,19 @@
 #define VUG_NODE_HPP
 
 #include <memory>
-#include <string>
+#include <string_view>
 #include <vector>
 
+#include "AST/ASTArena.hpp"
 #include "AST/ASTNodesForward.hpp"
 #include "AST/ASTWalker.hpp"
 #include "Lexing/Token.hpp"
 #include "Semantic/Symbol.hpp"
 
+// Nodes live in an ASTArena and are never destroyed, so they hold no memory of their own: children are
+// NodePtrs and NodeLists, names and literals view the source text or text copied into the arena.
 struct Node {
-    enum class Kind {
+    enum class Kind : uint8_t {
         None,
 
         BadNode,
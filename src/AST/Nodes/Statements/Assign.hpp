@@ -11,16 +11,16 @@
 class LocalVariableSymbol;
 
 struct Assign : public Statement {
-    std::string name;
-    std::unique_ptr<Expression> value;
+    std::string_view name;
+    NodePtr<Expression> value;
 
     LocalVariableSymbol* symbolRef{nullptr};
 
-    Assign(std::string name,
-           std::unique_ptr<Expression> value,
+    Assign(std::string_view name,
+           NodePtr<Expression> value,
            SourceLocation sourceLocation)
         : Statement(Kind::Assign, sourceLocation),
-          name(std::move(name)),
+          name(name),
           value(std::move(value)) {}
 
     void accept(ASTWalker& walker) override {
@@ -10,13 +10,13 @@
 #include "StatementsBlock.hpp"
 
 struct If : public Statement {
-    std::unique_ptr<Expression> condition;
-    std::unique_ptr<StatementsBlock> then;
-    std::unique_ptr<Statement> elseThen;
+    NodePtr<Expression> condition;
+    NodePtr<StatementsBlock> then;
+    NodePtr<Statement> elseThen;
 
-    If(std::unique_ptr<Expression> condition,
-       std::unique_ptr<StatementsBlock> then,
-       std::unique_ptr<Statement> elseThen,
+    If(NodePtr<Expression> condition,
+       NodePtr<StatementsBlock> then,
+       NodePtr<Statement> elseThen,
        SourceLocation sourceLocation)
         : Statement(Kind::If, sourceLocation),
           condition(std::move(condition)),
@@ -13,19 +13,19 @@
 #include "Semantic/Type.hpp"
 
 struct LocalVariableDeclaration : public Statement {
-    std::string type;
-    std::string name;
-    std::unique_ptr<Expression> value;
+    std::string_view type;
+    std::string_view name;
+    NodePtr<Expression> value;
 
     LocalVariableSymbol* symbolRef{nullptr};
 
-    LocalVariableDeclaration(std::string type,
-                             std::string name,
-                             std::unique_ptr<Expression> value,
+    LocalVariableDeclaration(std::string_view type,
+                             std::string_view name,
+                             NodePtr<Expression> value,
                              SourceLocation sourceLocation)
         : Statement(Kind::LocalVarDeclaration, sourceLocation),
-          type(std::move(type)),
-          name(std::move(name)),
+          type(type),
+          name(name),
           value(std::move(value)) {}
 
     void accept(ASTWalker& walker) override {
@@ -8,9 +8,9 @@
 #include "AST/Nodes/Statement.hpp"
 
 struct Print : public Statement {
-    std::unique_ptr<Expression> expression;
+    NodePtr<Expression> expression;
 
-    Print(std::unique_ptr<Expression> expression,
+    Print(NodePtr<Expression> expression,
           SourceLocation sourceLocation)
         : Statement(Kind::Print, sourceLocation),
           expression(std::move(expression)) {}
@@ -8,9 +8,9 @@
 #include "AST/Nodes/Statement.hpp"
 
 struct Return : public Statement {
-    std::unique_ptr<Expression> returnExpression;
+    NodePtr<Expression> returnExpression;
 
-    Return(std::unique_ptr<Expression> returnedExpression,
+    Return(NodePtr<Expression> returnedExpression,
            SourceLocation sourceLocation)
         : Statement(Kind::Return, sourceLocation),
           returnExpression(std::move(returnedExpression)) {}
@@ -9,9 +9,9 @@
 #include "AST/Nodes/Statement.hpp"
 
 struct StatementsBlock : public Statement {
-    std::vector<std::unique_ptr<Statement>> statements;
+    NodeList<Statement> statements;
 
-    explicit StatementsBlock(std::vector<std::unique_ptr<Statement>> statements,
+    explicit StatementsBlock(NodeList<Statement> statements,
                              SourceLocation sourceLocation)
         : Statement(Kind::StatementBlock, sourceLocation),
           statements(std::move(statements)) {}
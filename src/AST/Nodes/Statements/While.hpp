@@ -8,11 +8,11 @@
 #include "AST/Nodes/Statements/StatementsBlock.hpp"
 
 struct While : public Statement {
-    std::unique_ptr<Expression> condition;
-    std::unique_ptr<StatementsBlock> body;
+    NodePtr<Expression> condition;
+    NodePtr<StatementsBlock> body;
 
-    While(std::unique_ptr<Expression> condition,
-          std::unique_ptr<StatementsBlock> body,
+    While(NodePtr<Expression> condition,
+          NodePtr<StatementsBlock> body,
           SourceLocation sourceLocation)
         : Statement(Kind::While, sourceLocation),
           condition(std::move(condition)),
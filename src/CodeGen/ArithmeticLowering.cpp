@@ -0,0 +1,192 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ArithmeticLowering.hpp"
+
+#include <bit>
+#include <stdexcept>
+
+#include "Semantic/Type.hpp"
+
+namespace {
+    bool isPowerOfTwo(int64_t value) {
+        return value > 0 && std::has_single_bit(static_cast<uint64_t>(value));
+    }
+    uint8_t getLog2(int64_t value) {
+        return static_cast<uint8_t>(std::countr_zero(static_cast<uint64_t>(value)));
+    }
+
+    // Remainder from the quotient in rax and the dividend in rcx
+    void lowerRemainder(X86Assembler& assembler, int64_t divisor) {
+        assembler.movImm(Register::Rdx, divisor);
+        assembler.imul(Register::Rax, Register::Rdx);
+        assembler.sub(Register::Rcx, Register::Rax);
+        assembler.mov(Register::Rax, Register::Rcx);
+    }
+    void lowerSignedDivision(X86Assembler& assembler, LexemType operation, int64_t divisor) {
+        assembler.mov(Register::Rcx, Register::Rax);
+
+        if (isPowerOfTwo(divisor)) {
+            // Negative dividends are biased by divisor - 1 to round towards zero
+            auto shift = getLog2(divisor);
+            assembler.sarImm(Register::Rcx, 63);
+            assembler.shrImm(Register::Rcx, static_cast<uint8_t>(64 - shift));
+            assembler.add(Register::Rcx, Register::Rax);
+
+            if (operation == LexemType::Divide) {
+                assembler.mov(Register::Rax, Register::Rcx);
+                assembler.sarImm(Register::Rax, shift);
+            } else {
+                assembler.movImm(Register::Rdx, -divisor);
+                assembler.bitAnd(Register::Rcx, Register::Rdx);
+                assembler.sub(Register::Rax, Register::Rcx);
+            }
+            return;
+        }
+
+        auto magic = getSignedMagic(static_cast<int32_t>(divisor));
+        assembler.movImm(Register::Rdx, magic.multiplier);
+        assembler.imul(Register::Rax, Register::Rdx);
+        assembler.sarImm(Register::Rax, 32);
+        if (divisor > 0 && magic.multiplier < 0) {
+            assembler.add(Register::Rax, Register::Rcx);
+        } else if (divisor < 0 && magic.multiplier > 0) {
+            assembler.sub(Register::Rax, Register::Rcx);
+        }
+        if (magic.shift > 0) {
+            assembler.sarImm(Register::Rax, static_cast<uint8_t>(magic.shift));
+        }
+        assembler.mov(Register::Rdx, Register::Rax);
+        assembler.shrImm(Register::Rdx, 63);
+        assembler.add(Register::Rax, Register::Rdx);
+
+        if (operation == LexemType::Remainder) {
+            lowerRemainder(assembler, divisor);
+        }
+    }
+    void lowerUnsignedDivision(X86Assembler& assembler, LexemType operation, int64_t divisor) {
+        if (isPowerOfTwo(divisor)) {
+            if (operation == LexemType::Divide) {
+                assembler.shrImm(Register::Rax, getLog2(divisor));
+            } else {
+                assembler.movImm(Register::Rcx, divisor - 1);
+                assembler.bitAnd(Register::Rax, Register::Rcx);
+            }
+            return;
+        }
+
+        // The product stays below 2^64, imul's low half is the unsigned one
+        auto magic = *getUnsignedMagic(static_cast<uint32_t>(divisor));
+        assembler.mov(Register::Rcx, Register::Rax);
+        assembler.movImm(Register::Rdx, magic.multiplier);
+        assembler.imul(Register::Rax, Register::Rdx);
+        assembler.shrImm(Register::Rax, static_cast<uint8_t>(magic.shift));
+
+        if (operation == LexemType::Remainder) {
+            lowerRemainder(assembler, divisor);
+        }
+    }
+}// namespace
+
+bool canLowerByConstant(LexemType operation, int64_t constant, const Type* operandType) {
+    if (!operandType->isInteger()) {
+        return false;
+    }
+    auto integerType = static_cast<const IntegerType*>(operandType);
+    if (integerType->getBits() > 32) {
+        return false;
+    }
+
+    switch (operation) {
+        case LexemType::Multiply:
+            return isPowerOfTwo(constant) && constant > 1;
+        case LexemType::Divide:
+        case LexemType::Remainder:
+            if (constant == 1) {
+                return true;
+            }
+            if (!integerType->isIsSigned()) {
+                return constant > 1 && constant <= UINT32_MAX &&
+                       (isPowerOfTwo(constant) || getUnsignedMagic(static_cast<uint32_t>(constant)));
+            }
+            // -1 may trap on the minimum
+            return constant >= -INT32_MAX && constant <= INT32_MAX && constant != 0 && constant != -1;
+        default:
+            return false;
+    }
+}
+void lowerByConstant(X86Assembler& assembler,
+                     LexemType operation,
+                     int64_t constant,
+                     const Type* operandType,
+                     bool isDividendNonNegative) {
+    if (!canLowerByConstant(operation, constant, operandType)) {
+        throw std::logic_error("Unsupported operation");
+    }
+
+    if (operation == LexemType::Multiply) {
+        assembler.shlImm(Register::Rax, getLog2(constant));
+    } else if (constant == 1) {
+        if (operation == LexemType::Remainder) {
+            assembler.movImm(Register::Rax, 0);
+        }
+    } else if (isDividendNonNegative && constant > 1 &&
+               (isPowerOfTwo(constant) || getUnsignedMagic(static_cast<uint32_t>(constant)))) {
+        // The sign-extended dividend has its upper bits clear, no rounding fixups are needed
+        lowerUnsignedDivision(assembler, operation, constant);
+    } else if (static_cast<const IntegerType*>(operandType)->isIsSigned()) {
+        lowerSignedDivision(assembler, operation, constant);
+    } else {
+        lowerUnsignedDivision(assembler, operation, constant);
+    }
+}
+
+DivisionMagic getSignedMagic(int32_t divisor) {
+    // Hacker's Delight, 10-1
+    constexpr uint32_t twoTo31 = 0x80000000;
+
+    auto absolute = divisor < 0 ? 0 - static_cast<uint32_t>(divisor) : static_cast<uint32_t>(divisor);
+    auto t = twoTo31 + (static_cast<uint32_t>(divisor) >> 31);
+    auto absoluteNc = t - 1 - t % absolute;
+
+    uint32_t p = 31;
+    uint32_t q1 = twoTo31 / absoluteNc;
+    uint32_t r1 = twoTo31 - q1 * absoluteNc;
+    uint32_t q2 = twoTo31 / absolute;
+    uint32_t r2 = twoTo31 - q2 * absolute;
+    uint32_t delta;
+    do {
+        ++p;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= absoluteNc) {
+            ++q1;
+            r1 -= absoluteNc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= absolute) {
+            ++q2;
+            r2 -= absolute;
+        }
+        delta = absolute - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    auto multiplier = q2 + 1;
+    return {static_cast<int32_t>(divisor < 0 ? 0 - multiplier : multiplier), p - 32};
+}
+std::optional<DivisionMagic> getUnsignedMagic(uint32_t divisor) {
+    // With m = ceil(2^p / d) = (2^p + e) / d, n * m / 2^p = n / d + n * e / (d * 2^p)
+    // and the error stays below 1 / d for every n < 2^32 while e <= 2^(p - 32)
+    for (uint32_t p = 32; p < 64; ++p) {
+        auto power = uint64_t{1} << p;
+        auto multiplier = (power + divisor - 1) / divisor;
+        if (multiplier > UINT32_MAX) {
+            return std::nullopt;
+        }
+        if (multiplier * divisor - power <= (uint64_t{1} << (p - 32))) {
+            return DivisionMagic{static_cast<int64_t>(multiplier), p};
+        }
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,39 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_ARITHMETICLOWERING_HPP
+#define VUG_ARITHMETICLOWERING_HPP
+
+#include <cstdint>
+#include <optional>
+
+#include "CodeGen/X86Assembler.hpp"
+#include "Lexing/Token.hpp"
+
+class Type;
+
+// Multiplication, division and remainder by a constant without imul/idiv where possible:
+// powers of two become shifts and masks, other divisors a multiplication by their reciprocal that
+// keeps the high half (Granlund, Montgomery). Operands are integers of at most 32 bits, extended to
+// 64 bits in registers; divisors that may trap are never lowered.
+struct DivisionMagic {
+    int64_t multiplier;
+    uint32_t shift;
+};
+
+bool canLowerByConstant(LexemType operation, int64_t constant, const Type* operandType);
+// rax = rax operation constant, clobbers rcx and rdx. The result is not normalized.
+// A signed dividend known not to be negative is divided as an unsigned one
+void lowerByConstant(X86Assembler& assembler,
+                     LexemType operation,
+                     int64_t constant,
+                     const Type* operandType,
+                     bool isDividendNonNegative = false);
+
+// n / divisor = ((n * multiplier) >> 32, plus n if the multiplier is negative and the divisor positive,
+// minus n the other way round) >> shift, plus one when that is negative; for 2 <= |divisor| < 2^31
+DivisionMagic getSignedMagic(int32_t divisor);
+// n / divisor = (n * multiplier) >> shift for unsigned 32-bit n, when a multiplier below 2^32 exists
+std::optional<DivisionMagic> getUnsignedMagic(uint32_t divisor);
+
+#endif//VUG_ARITHMETICLOWERING_HPP
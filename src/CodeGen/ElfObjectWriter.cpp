@@ -0,0 +1,226 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ElfObjectWriter.hpp"
+
+#include <unordered_map>
+
+namespace {
+    enum SectionIndex : uint16_t {
+        Null,
+        Text,
+        RelaText,
+        SymbolTable,
+        StringTable,
+        SectionStringTable,
+        GnuStack,
+        SectionCount,
+    };
+
+    constexpr uint64_t elfHeaderSize = 64;
+    constexpr uint64_t sectionHeaderSize = 64;
+    constexpr uint64_t symbolSize = 24;
+    constexpr uint64_t relocationSize = 24;
+
+    constexpr uint16_t elfTypeRelocatable = 1;
+    constexpr uint16_t elfMachineX86_64 = 62;
+
+    constexpr uint32_t sectionProgbits = 1;
+    constexpr uint32_t sectionSymtab = 2;
+    constexpr uint32_t sectionStrtab = 3;
+    constexpr uint32_t sectionRela = 4;
+
+    constexpr uint64_t flagAlloc = 0x2;
+    constexpr uint64_t flagExecute = 0x4;
+    constexpr uint64_t flagInfoLink = 0x40;
+
+    constexpr uint8_t bindLocal = 0;
+    constexpr uint8_t bindGlobal = 1;
+    constexpr uint8_t typeNone = 0;
+    constexpr uint8_t typeFunction = 2;
+    constexpr uint8_t typeSection = 3;
+
+    constexpr uint32_t relocationPlt32 = 4;
+
+    class ByteBuffer {
+    public:
+        template<typename T>
+        void append(T value) {
+            for (size_t i = 0; i < sizeof(T); ++i) {
+                _bytes.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+            }
+        }
+        void append(const std::vector<uint8_t>& bytes) {
+            _bytes.insert(_bytes.end(), bytes.begin(), bytes.end());
+        }
+        void align(size_t alignment) {
+            while (_bytes.size() % alignment != 0) {
+                _bytes.push_back(0);
+            }
+        }
+
+        [[nodiscard]] size_t size() const {
+            return _bytes.size();
+        }
+        [[nodiscard]] const std::vector<uint8_t>& bytes() const {
+            return _bytes;
+        }
+
+    private:
+        std::vector<uint8_t> _bytes;
+    };
+
+    class StringTableBuilder {
+    public:
+        StringTableBuilder() {
+            _bytes.push_back(0);
+        }
+
+        uint32_t add(const std::string& string) {
+            auto offset = static_cast<uint32_t>(_bytes.size());
+            _bytes.insert(_bytes.end(), string.begin(), string.end());
+            _bytes.push_back(0);
+            return offset;
+        }
+
+        [[nodiscard]] const std::vector<uint8_t>& bytes() const {
+            return _bytes;
+        }
+
+    private:
+        std::vector<uint8_t> _bytes;
+    };
+
+    struct SectionHeader {
+        uint32_t name{0};
+        uint32_t type{0};
+        uint64_t flags{0};
+        uint64_t offset{0};
+        uint64_t size{0};
+        uint32_t link{0};
+        uint32_t info{0};
+        uint64_t alignment{0};
+        uint64_t entrySize{0};
+    };
+
+    void appendSymbol(ByteBuffer& buffer, uint32_t name, uint8_t bind, uint8_t type,
+                      uint16_t section, uint64_t value, uint64_t size) {
+        buffer.append<uint32_t>(name);
+        buffer.append<uint8_t>((bind << 4) | type);
+        buffer.append<uint8_t>(0);
+        buffer.append<uint16_t>(section);
+        buffer.append<uint64_t>(value);
+        buffer.append<uint64_t>(size);
+    }
+}// namespace
+
+void ElfObjectWriter::write(std::ostream& output) const {
+    StringTableBuilder strings;
+    ByteBuffer symbols;
+    std::unordered_map<std::string, uint32_t> symbolIndices;
+    uint32_t symbolCount = 0;
+
+    appendSymbol(symbols, 0, bindLocal, typeNone, SectionIndex::Null, 0, 0);
+    appendSymbol(symbols, 0, bindLocal, typeSection, SectionIndex::Text, 0, 0);
+    symbolCount += 2;
+
+    // ELF requires every local symbol to precede the global ones
+    uint32_t firstGlobal = symbolCount;
+    for (bool global: {false, true}) {
+        for (const auto& symbol: _objectCode.symbols) {
+            if (symbol.isGlobal == global) {
+                appendSymbol(symbols, strings.add(symbol.name), global ? bindGlobal : bindLocal,
+                             typeFunction, SectionIndex::Text, symbol.offset, symbol.size);
+                symbolIndices[symbol.name] = symbolCount++;
+            }
+        }
+        if (!global) {
+            firstGlobal = symbolCount;
+        }
+    }
+
+    ByteBuffer relocations;
+    for (const auto& relocation: _objectCode.relocations) {
+        if (!symbolIndices.contains(relocation.symbol)) {
+            appendSymbol(symbols, strings.add(relocation.symbol), bindGlobal, typeNone,
+                         SectionIndex::Null, 0, 0);
+            symbolIndices[relocation.symbol] = symbolCount++;
+        }
+
+        relocations.append<uint64_t>(relocation.offset);
+        relocations.append<uint64_t>((static_cast<uint64_t>(symbolIndices[relocation.symbol]) << 32) |
+                                     relocationPlt32);
+        relocations.append<int64_t>(-4);
+    }
+
+    StringTableBuilder sectionNames;
+    SectionHeader headers[SectionIndex::SectionCount];
+    ByteBuffer file;
+
+    file.append(std::vector<uint8_t>(elfHeaderSize, 0));
+
+    file.align(16);
+    headers[SectionIndex::Text] = {sectionNames.add(".text"), sectionProgbits, flagAlloc | flagExecute,
+                                   file.size(), _objectCode.text.size(), 0, 0, 16, 0};
+    file.append(_objectCode.text);
+
+    file.align(8);
+    headers[SectionIndex::RelaText] = {sectionNames.add(".rela.text"), sectionRela, flagInfoLink,
+                                       file.size(), relocations.size(), SectionIndex::SymbolTable,
+                                       SectionIndex::Text, 8, relocationSize};
+    file.append(relocations.bytes());
+
+    file.align(8);
+    headers[SectionIndex::SymbolTable] = {sectionNames.add(".symtab"), sectionSymtab, 0,
+                                          file.size(), symbols.size(), SectionIndex::StringTable,
+                                          firstGlobal, 8, symbolSize};
+    file.append(symbols.bytes());
+
+    headers[SectionIndex::StringTable] = {sectionNames.add(".strtab"), sectionStrtab, 0,
+                                          file.size(), strings.bytes().size(), 0, 0, 1, 0};
+    file.append(strings.bytes());
+
+    headers[SectionIndex::GnuStack] = {sectionNames.add(".note.GNU-stack"), sectionProgbits, 0,
+                                       file.size(), 0, 0, 0, 1, 0};
+
+    auto sectionNamesName = sectionNames.add(".shstrtab");
+    headers[SectionIndex::SectionStringTable] = {sectionNamesName, sectionStrtab, 0,
+                                                 file.size(), sectionNames.bytes().size(), 0, 0, 1, 0};
+    file.append(sectionNames.bytes());
+
+    file.align(8);
+    auto sectionHeadersOffset = file.size();
+    for (const auto& header: headers) {
+        file.append<uint32_t>(header.name);
+        file.append<uint32_t>(header.type);
+        file.append<uint64_t>(header.flags);
+        file.append<uint64_t>(0);
+        file.append<uint64_t>(header.offset);
+        file.append<uint64_t>(header.size);
+        file.append<uint32_t>(header.link);
+        file.append<uint32_t>(header.info);
+        file.append<uint64_t>(header.alignment);
+        file.append<uint64_t>(header.entrySize);
+    }
+
+    ByteBuffer elfHeader;
+    elfHeader.append(std::vector<uint8_t>{0x7F, 'E', 'L', 'F', 2, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+    elfHeader.append<uint16_t>(elfTypeRelocatable);
+    elfHeader.append<uint16_t>(elfMachineX86_64);
+    elfHeader.append<uint32_t>(1);
+    elfHeader.append<uint64_t>(0);
+    elfHeader.append<uint64_t>(0);
+    elfHeader.append<uint64_t>(sectionHeadersOffset);
+    elfHeader.append<uint32_t>(0);
+    elfHeader.append<uint16_t>(elfHeaderSize);
+    elfHeader.append<uint16_t>(0);
+    elfHeader.append<uint16_t>(0);
+    elfHeader.append<uint16_t>(sectionHeaderSize);
+    elfHeader.append<uint16_t>(SectionIndex::SectionCount);
+    elfHeader.append<uint16_t>(SectionIndex::SectionStringTable);
+
+    auto bytes = file.bytes();
+    std::copy(elfHeader.bytes().begin(), elfHeader.bytes().end(), bytes.begin());
+
+    output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
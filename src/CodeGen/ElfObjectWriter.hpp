@@ -0,0 +1,53 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_ELFOBJECTWRITER_HPP
+#define VUG_ELFOBJECTWRITER_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct ObjectSymbol {
+    std::string name;
+    uint64_t offset;
+    uint64_t size;
+    bool isGlobal;
+
+    ObjectSymbol(std::string name, uint64_t offset, uint64_t size, bool isGlobal)
+        : name(std::move(name)),
+          offset(offset),
+          size(size),
+          isGlobal(isGlobal) {}
+};
+
+// PC-relative call to an external symbol, patched by the linker
+struct ObjectRelocation {
+    uint64_t offset;
+    std::string symbol;
+
+    ObjectRelocation(uint64_t offset, std::string symbol)
+        : offset(offset),
+          symbol(std::move(symbol)) {}
+};
+
+struct ObjectCode {
+    std::vector<uint8_t> text;
+    std::vector<ObjectSymbol> symbols;
+    std::vector<ObjectRelocation> relocations;
+};
+
+// Writes a relocatable x86-64 ELF object with a single .text section
+class ElfObjectWriter {
+public:
+    explicit ElfObjectWriter(const ObjectCode& objectCode)
+        : _objectCode(objectCode) {}
+
+    void write(std::ostream& output) const;
+
+protected:
+    const ObjectCode& _objectCode;
+};
+
+#endif//VUG_ELFOBJECTWRITER_HPP
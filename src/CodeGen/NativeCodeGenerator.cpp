@@ -0,0 +1,425 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "NativeCodeGenerator.hpp"
+
+#include "AST/ASTNodes.hpp"
+#include "CodeGen/ArithmeticLowering.hpp"
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/ConstantFolding.hpp"
+#include "Semantic/Type.hpp"
+
+namespace {
+    constexpr Register argumentRegisters[] = {
+            Register::Rdi,
+            Register::Rsi,
+            Register::Rdx,
+            Register::Rcx,
+            Register::R8,
+            Register::R9,
+    };
+    constexpr size_t argumentRegistersCount = std::size(argumentRegisters);
+
+    constexpr const char* entrySymbol = "vug_main";
+    constexpr const char* printSignedSymbol = "vug_print_int64";
+    constexpr const char* printUnsignedSymbol = "vug_print_uint64";
+
+    bool isSigned(const Type* type) {
+        return !type->isInteger() || static_cast<const IntegerType*>(type)->isIsSigned();
+    }
+}// namespace
+
+ObjectCode NativeCodeGenerator::generate() {
+    stackGuard();
+
+    collectFunctionNames(static_cast<Declaration&>(_ast));
+    visit(_ast);
+    resolveCalls();
+
+    _objectCode.text = _assembler.getCode();
+    return std::move(_objectCode);
+}
+
+void NativeCodeGenerator::visit(Node& node) {
+    stackGuard();
+
+    node.accept(*this);
+}
+
+void NativeCodeGenerator::collectFunctionNames(Declaration& node) {
+    stackGuard();
+
+    if (node.kind == Node::Kind::ModuleDeclaration) {
+        auto& module = static_cast<ModuleDeclaration&>(node);
+
+        _modulePath.push_back(module.name);
+        collectFunctionNames(*module.body);
+        _modulePath.pop_back();
+    } else if (node.kind == Node::Kind::DeclarationsBlock) {
+        for (const auto& declaration: static_cast<DeclarationsBlock&>(node).declarations) {
+            collectFunctionNames(*declaration);
+        }
+    } else if (node.kind == Node::Kind::FunctionDeclaration) {
+        auto& function = static_cast<FunctionDeclaration&>(node);
+
+        std::string name;
+        for (const auto& module: _modulePath) {
+            name += module;
+            name += '.';
+        }
+        _functionNames[function.symbolRef] = name.append(function.name);
+    }
+}
+void NativeCodeGenerator::resolveCalls() {
+    std::unordered_map<std::string, uint64_t> offsets;
+    for (const auto& symbol: _objectCode.symbols) {
+        offsets[symbol.name] = symbol.offset;
+    }
+
+    for (const auto& reference: _assembler.getSymbolReferences()) {
+        auto target = offsets.find(reference.symbol);
+        if (target != offsets.end()) {
+            _assembler.patchInt32(reference.offset,
+                                  static_cast<int32_t>(target->second - (reference.offset + 4)));
+        } else {
+            _objectCode.relocations.emplace_back(reference.offset, reference.symbol);
+        }
+    }
+}
+
+void NativeCodeGenerator::visit(ModuleDeclaration& node) {
+    stackGuard();
+
+    _modulePath.push_back(node.name);
+    visit(*node.body);
+    _modulePath.pop_back();
+
+    if (_modulePath.empty()) {
+        auto mainMembers = node.symbolRef->findMember("main");
+        if (mainMembers.empty() || mainMembers[0]->getKind() != Symbol::Kind::Function) {
+            auto diagnostic = Diagnostic();
+            diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
+                                                    std::format("module '{}' has no 'main' function", node.name),
+                                                    {node.sourceLocation}));
+            _diagnosticManager.report(diagnostic);
+            return;
+        }
+
+        const auto& mainName = _functionNames[static_cast<FunctionSymbol*>(mainMembers[0])];
+        for (const auto& symbol: _objectCode.symbols) {
+            if (symbol.name == mainName) {
+                _objectCode.symbols.emplace_back(entrySymbol, symbol.offset, symbol.size, true);
+                break;
+            }
+        }
+    }
+}
+void NativeCodeGenerator::visit(DeclarationsBlock& node) {
+    stackGuard();
+
+    for (const auto& declaration: node.declarations) {
+        visit(*declaration);
+    }
+}
+void NativeCodeGenerator::visit(FunctionDeclaration& node) {
+    stackGuard();
+
+    _slots.clear();
+    _loopExits.clear();
+    _frameSize = 0;
+    _pushDepth = 0;
+    _epilogue = _assembler.createLabel();
+
+    auto start = _assembler.getPosition();
+
+    _assembler.push(Register::Rbp);
+    _assembler.mov(Register::Rbp, Register::Rsp);
+    auto frameSizeOffset = _assembler.subImm32(Register::Rsp, 0);
+
+    for (size_t index = 0; index < node.parameters.size(); ++index) {
+        auto symbol = node.parameters[index]->symbolRef;
+
+        if (index < argumentRegistersCount) {
+            _assembler.store(Register::Rbp, getSlot(symbol), argumentRegisters[index]);
+        } else {
+            // Stack arguments already live above the return address
+            _slots[symbol] = static_cast<int32_t>(16 + 8 * (index - argumentRegistersCount));
+        }
+    }
+
+    visit(*node.definition);
+
+    _assembler.movImm(Register::Rax, 0);
+    _assembler.bind(_epilogue);
+    _assembler.mov(Register::Rsp, Register::Rbp);
+    _assembler.pop(Register::Rbp);
+    _assembler.ret();
+
+    _assembler.patchInt32(frameSizeOffset, (_frameSize + 15) / 16 * 16);
+
+    _objectCode.symbols.emplace_back(_functionNames[node.symbolRef],
+                                     start,
+                                     _assembler.getPosition() - start,
+                                     false);
+}
+
+void NativeCodeGenerator::visit(CallFunction& node) {
+    stackGuard();
+
+    for (const auto& argument: node.arguments) {
+        visit(*argument);
+        pushResult();
+    }
+
+    auto count = node.arguments.size();
+    auto stackCount = count > argumentRegistersCount ? count - argumentRegistersCount : 0;
+    int32_t padding = (_pushDepth + stackCount) % 2 == 0 ? 0 : 8;
+    if (padding != 0) {
+        _assembler.subImm(Register::Rsp, padding);
+    }
+
+    // Arguments were pushed in source order, stack arguments must be laid out in reverse
+    for (size_t pushed = 0; pushed < stackCount; ++pushed) {
+        auto index = count - 1 - pushed;
+        auto offset = static_cast<int32_t>((count - 1 - index + pushed) * 8) + padding;
+
+        _assembler.load(Register::Rax, Register::Rsp, offset);
+        _assembler.push(Register::Rax);
+    }
+    for (size_t index = 0; index < std::min(count, argumentRegistersCount); ++index) {
+        auto offset = static_cast<int32_t>((count - 1 - index + stackCount) * 8) + padding;
+
+        _assembler.load(argumentRegisters[index], Register::Rsp, offset);
+    }
+
+    _assembler.callSymbol(_functionNames[node.symbolRef]);
+
+    _assembler.addImm(Register::Rsp, static_cast<int32_t>((count + stackCount) * 8) + padding);
+    _pushDepth -= count;
+}
+void NativeCodeGenerator::visit(Number& node) {
+    stackGuard();
+
+    _assembler.movImm(Register::Rax, std::stoi(std::string(node.number)));
+}
+void NativeCodeGenerator::visit(Identifier& node) {
+    stackGuard();
+
+    _assembler.load(Register::Rax, Register::Rbp, getSlot(node.symbolRef));
+}
+void NativeCodeGenerator::visit(BinaryOperation& node) {
+    stackGuard();
+
+    auto constant = getConstantValue(*node.right);
+    if (constant && canLowerByConstant(node.operationToken, *constant, node.left->exprType)) {
+        visit(*node.left);
+        lowerByConstant(_assembler, node.operationToken, *constant, node.left->exprType, node.isLeftNonNegative);
+        normalize(node.exprType);
+        return;
+    }
+
+    // Both operands are always evaluated, the evaluator doesn't short-circuit logic operators either
+    visit(*node.left);
+    pushResult();
+    visit(*node.right);
+    _assembler.mov(Register::Rcx, Register::Rax);
+    popResult(Register::Rax);
+
+    auto operandSigned = isSigned(node.left->exprType);
+
+    switch (node.operationToken) {
+        case LexemType::Plus:
+            _assembler.add(Register::Rax, Register::Rcx);
+            break;
+        case LexemType::Minus:
+            _assembler.sub(Register::Rax, Register::Rcx);
+            break;
+        case LexemType::Multiply:
+            _assembler.imul(Register::Rax, Register::Rcx);
+            break;
+        case LexemType::Divide:
+        case LexemType::Remainder:
+            if (operandSigned) {
+                _assembler.cqo();
+                _assembler.idiv(Register::Rcx);
+            } else {
+                _assembler.movImm(Register::Rdx, 0);
+                _assembler.div(Register::Rcx);
+            }
+            if (node.operationToken == LexemType::Remainder) {
+                _assembler.mov(Register::Rax, Register::Rdx);
+            }
+            break;
+        case LexemType::BitAnd:
+        case LexemType::LogicAnd:
+            _assembler.bitAnd(Register::Rax, Register::Rcx);
+            break;
+        case LexemType::BitOr:
+        case LexemType::LogicOr:
+            _assembler.bitOr(Register::Rax, Register::Rcx);
+            break;
+        case LexemType::BitXor:
+            _assembler.bitXor(Register::Rax, Register::Rcx);
+            break;
+        case LexemType::Equal:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(Condition::Equal, Register::Rax);
+            break;
+        case LexemType::Unequal:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(Condition::NotEqual, Register::Rax);
+            break;
+        case LexemType::Less:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(operandSigned ? Condition::Less : Condition::Below, Register::Rax);
+            break;
+        case LexemType::LessEqual:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(operandSigned ? Condition::LessEqual : Condition::BelowEqual, Register::Rax);
+            break;
+        case LexemType::Greater:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(operandSigned ? Condition::Greater : Condition::Above, Register::Rax);
+            break;
+        case LexemType::GreaterEqual:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(operandSigned ? Condition::GreaterEqual : Condition::AboveEqual, Register::Rax);
+            break;
+        default:
+            throw std::logic_error("Unsupported operation");
+    }
+
+    normalize(node.exprType);
+}
+void NativeCodeGenerator::visit(PrefixOperation& node) {
+    stackGuard();
+
+    visit(*node.right);
+
+    switch (node.operationType) {
+        case LexemType::Minus:
+            _assembler.neg(Register::Rax);
+            break;
+        case LexemType::Not:
+            _assembler.movImm(Register::Rcx, 1);
+            _assembler.bitXor(Register::Rax, Register::Rcx);
+            break;
+        default:
+            throw std::logic_error("Unsupported operation");
+    }
+
+    normalize(node.exprType);
+}
+
+void NativeCodeGenerator::visit(Assign& node) {
+    stackGuard();
+
+    visit(*node.value);
+    _assembler.store(Register::Rbp, getSlot(node.symbolRef), Register::Rax);
+}
+void NativeCodeGenerator::visit(LocalVariableDeclaration& node) {
+    stackGuard();
+
+    visit(*node.value);
+    _assembler.store(Register::Rbp, getSlot(node.symbolRef), Register::Rax);
+}
+void NativeCodeGenerator::visit(StatementsBlock& node) {
+    stackGuard();
+
+    for (const auto& stmt: node.statements) {
+        visit(*stmt);
+    }
+}
+void NativeCodeGenerator::visit(Break& node) {
+    stackGuard();
+
+    _assembler.jmp(_loopExits.at(static_cast<While*>(node.breakedStmt)));
+}
+void NativeCodeGenerator::visit(If& node) {
+    stackGuard();
+
+    auto elseLabel = _assembler.createLabel();
+    auto endLabel = _assembler.createLabel();
+
+    visit(*node.condition);
+    _assembler.test(Register::Rax, Register::Rax);
+    _assembler.jcc(Condition::Equal, elseLabel);
+
+    visit(*node.then);
+    _assembler.jmp(endLabel);
+
+    _assembler.bind(elseLabel);
+    if (node.elseThen != nullptr) {
+        visit(*node.elseThen);
+    }
+    _assembler.bind(endLabel);
+}
+void NativeCodeGenerator::visit(While& node) {
+    stackGuard();
+
+    auto conditionLabel = _assembler.createLabel();
+    auto exitLabel = _assembler.createLabel();
+    _loopExits.emplace(&node, exitLabel);
+
+    _assembler.bind(conditionLabel);
+    visit(*node.condition);
+    _assembler.test(Register::Rax, Register::Rax);
+    _assembler.jcc(Condition::Equal, exitLabel);
+
+    visit(*node.body);
+    _assembler.jmp(conditionLabel);
+
+    _assembler.bind(exitLabel);
+}
+void NativeCodeGenerator::visit(Print& node) {
+    stackGuard();
+
+    visit(*node.expression);
+    _assembler.mov(Register::Rdi, Register::Rax);
+    alignedCall(isSigned(node.expression->exprType) ? printSignedSymbol : printUnsignedSymbol);
+}
+void NativeCodeGenerator::visit(Return& node) {
+    stackGuard();
+
+    visit(*node.returnExpression);
+    _assembler.jmp(_epilogue);
+}
+
+int32_t NativeCodeGenerator::getSlot(const LocalVariableSymbol* symbol) {
+    auto slot = _slots.find(symbol);
+    if (slot != _slots.end()) {
+        return slot->second;
+    }
+
+    _frameSize += 8;
+    _slots[symbol] = -_frameSize;
+    return -_frameSize;
+}
+void NativeCodeGenerator::normalize(const Type* type) {
+    if (type->isInteger()) {
+        auto integerType = static_cast<const IntegerType*>(type);
+        if (integerType->isIsSigned()) {
+            _assembler.signExtend(Register::Rax, integerType->getBits());
+        } else {
+            _assembler.zeroExtend(Register::Rax, integerType->getBits());
+        }
+    }
+}
+void NativeCodeGenerator::pushResult() {
+    _assembler.push(Register::Rax);
+    ++_pushDepth;
+}
+void NativeCodeGenerator::popResult(Register reg) {
+    _assembler.pop(reg);
+    --_pushDepth;
+}
+void NativeCodeGenerator::alignedCall(const std::string& symbol) {
+    if (_pushDepth % 2 != 0) {
+        _assembler.subImm(Register::Rsp, 8);
+        _assembler.callSymbol(symbol);
+        _assembler.addImm(Register::Rsp, 8);
+    } else {
+        _assembler.callSymbol(symbol);
+    }
+}
@@ -0,0 +1,78 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_NATIVECODEGENERATOR_HPP
+#define VUG_NATIVECODEGENERATOR_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AST/ASTWalker.hpp"
+#include "CodeGen/ElfObjectWriter.hpp"
+#include "CodeGen/X86Assembler.hpp"
+
+class DiagnosticManager;
+class FunctionSymbol;
+class LocalVariableSymbol;
+class Type;
+
+// Lowers the checked AST to x86-64 machine code following the System V calling convention.
+// Expression results are produced in rax, locals live in rbp-relative stack slots.
+class NativeCodeGenerator : public ASTWalker {
+public:
+    NativeCodeGenerator(Node& ast,
+                        DiagnosticManager& diagnosticManager)
+        : _ast(ast),
+          _diagnosticManager(diagnosticManager) {}
+
+    ObjectCode generate();
+
+    void visit(ModuleDeclaration& node) override;
+    void visit(DeclarationsBlock& node) override;
+    void visit(FunctionDeclaration& node) override;
+
+    void visit(CallFunction& node) override;
+    void visit(Number& node) override;
+    void visit(Identifier& node) override;
+    void visit(BinaryOperation& node) override;
+    void visit(PrefixOperation& node) override;
+
+    void visit(Assign& node) override;
+    void visit(LocalVariableDeclaration& node) override;
+    void visit(StatementsBlock& node) override;
+    void visit(Break& node) override;
+    void visit(If& node) override;
+    void visit(While& node) override;
+    void visit(Print& node) override;
+    void visit(Return& node) override;
+
+protected:
+    Node& _ast;
+    DiagnosticManager& _diagnosticManager;
+
+    X86Assembler _assembler;
+    ObjectCode _objectCode;
+
+    std::vector<std::string_view> _modulePath;
+    std::unordered_map<const FunctionSymbol*, std::string> _functionNames;
+
+    std::unordered_map<const LocalVariableSymbol*, int32_t> _slots;
+    std::unordered_map<const While*, X86Assembler::Label> _loopExits;
+    X86Assembler::Label _epilogue{0};
+    int32_t _frameSize{0};
+    size_t _pushDepth{0};
+
+    void visit(Node& node) override;
+
+    void collectFunctionNames(Declaration& node);
+    void resolveCalls();
+
+    int32_t getSlot(const LocalVariableSymbol* symbol);
+    void normalize(const Type* type);
+    void pushResult();
+    void popResult(Register reg);
+    void alignedCall(const std::string& symbol);
+};
+
+#endif//VUG_NATIVECODEGENERATOR_HPP
@@ -0,0 +1,192 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PerfMap.hpp"
+
+#include <format>
+
+#include "Misc/SourceManager.hpp"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+    // Layout follows tools/perf/Documentation/jitdump-specification.txt
+    constexpr uint32_t jitdumpMagic = 0x4A695444;
+    constexpr uint32_t jitdumpVersion = 1;
+    constexpr uint32_t elfMachineX86_64 = 62;
+
+    enum class JitdumpRecord : uint32_t {
+        CodeLoad = 0,
+        CodeMove = 1,
+        DebugInfo = 2,
+        Close = 3,
+    };
+
+    struct JitdumpHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t totalSize;
+        uint32_t elfMachine;
+        uint32_t pad;
+        uint32_t pid;
+        uint64_t timestamp;
+        uint64_t flags;
+    };
+    struct JitdumpRecordHeader {
+        uint32_t id;
+        uint32_t totalSize;
+        uint64_t timestamp;
+    };
+    struct JitdumpCodeLoad {
+        JitdumpRecordHeader header;
+        uint32_t pid;
+        uint32_t tid;
+        uint64_t vma;
+        uint64_t codeAddress;
+        uint64_t codeSize;
+        uint64_t codeIndex;
+    };
+    struct JitdumpDebugInfo {
+        JitdumpRecordHeader header;
+        uint64_t codeAddress;
+        uint64_t entryCount;
+    };
+    struct JitdumpDebugEntry {
+        uint64_t address;
+        uint32_t line;
+        uint32_t discriminator;
+    };
+
+    uint64_t timestamp() {
+        timespec time{};
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1'000'000'000 + static_cast<uint64_t>(time.tv_nsec);
+    }
+    std::string sourceFileName(const SourceLocation& location) {
+        if (location.isValid() && location.getSourceFile() != nullptr) {
+            return location.getSourceFile()->getName();
+        }
+        return "<unknown>";
+    }
+}// namespace
+
+PerfMap::PerfMap(Format format) {
+    if (format & Format::Map) {
+        _mapFile = std::fopen(std::format("/tmp/perf-{}.map", getpid()).c_str(), "w");
+    }
+    if (format & Format::Jitdump) {
+        _jitdumpFile = std::fopen(std::format("jit-{}.dump", getpid()).c_str(), "w+");
+        if (_jitdumpFile != nullptr) {
+            // perf finds the dump through the executable mapping of the file in the recorded process
+            _jitdumpMarker = mmap(nullptr, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE,
+                                  fileno(_jitdumpFile), 0);
+            if (_jitdumpMarker == MAP_FAILED) {
+                _jitdumpMarker = nullptr;
+            }
+            writeJitdumpHeader();
+        }
+    }
+}
+PerfMap::~PerfMap() {
+    if (_mapFile != nullptr) {
+        std::fclose(_mapFile);
+    }
+    if (_jitdumpFile != nullptr) {
+        JitdumpRecordHeader close{static_cast<uint32_t>(JitdumpRecord::Close),
+                                  sizeof(JitdumpRecordHeader),
+                                  timestamp()};
+        std::fwrite(&close, sizeof(close), 1, _jitdumpFile);
+
+        if (_jitdumpMarker != nullptr) {
+            munmap(_jitdumpMarker, sysconf(_SC_PAGESIZE));
+        }
+        std::fclose(_jitdumpFile);
+    }
+}
+
+void PerfMap::registerCode(const void* code,
+                           size_t size,
+                           const std::string& name,
+                           const std::vector<LineEntry>& lines) {
+    if (_mapFile != nullptr) {
+        std::fprintf(_mapFile, "%lx %zx %s\n", reinterpret_cast<uintptr_t>(code), size, name.c_str());
+        std::fflush(_mapFile);
+    }
+    if (_jitdumpFile != nullptr) {
+        if (!lines.empty()) {
+            writeJitdumpDebugInfo(code, lines);
+        }
+        writeJitdumpCodeLoad(code, size, name);
+        std::fflush(_jitdumpFile);
+    }
+    ++_codeIndex;
+}
+
+void PerfMap::writeJitdumpHeader() {
+    JitdumpHeader header{jitdumpMagic,
+                         jitdumpVersion,
+                         sizeof(JitdumpHeader),
+                         elfMachineX86_64,
+                         0,
+                         static_cast<uint32_t>(getpid()),
+                         timestamp(),
+                         0};
+    std::fwrite(&header, sizeof(header), 1, _jitdumpFile);
+}
+void PerfMap::writeJitdumpDebugInfo(const void* code, const std::vector<LineEntry>& lines) {
+    size_t totalSize = sizeof(JitdumpDebugInfo);
+    for (const auto& line: lines) {
+        totalSize += sizeof(JitdumpDebugEntry) + sourceFileName(line.sourceLocation).size() + 1;
+    }
+
+    JitdumpDebugInfo record{{static_cast<uint32_t>(JitdumpRecord::DebugInfo),
+                             static_cast<uint32_t>(totalSize),
+                             timestamp()},
+                            reinterpret_cast<uint64_t>(code),
+                            lines.size()};
+    std::fwrite(&record, sizeof(record), 1, _jitdumpFile);
+
+    for (const auto& line: lines) {
+        JitdumpDebugEntry entry{reinterpret_cast<uint64_t>(line.address),
+                                static_cast<uint32_t>(line.sourceLocation.isValid()
+                                                              ? line.sourceLocation.getStartLine()
+                                                              : 0),
+                                0};
+        auto fileName = sourceFileName(line.sourceLocation);
+
+        std::fwrite(&entry, sizeof(entry), 1, _jitdumpFile);
+        std::fwrite(fileName.c_str(), fileName.size() + 1, 1, _jitdumpFile);
+    }
+}
+void PerfMap::writeJitdumpCodeLoad(const void* code, size_t size, const std::string& name) {
+    JitdumpCodeLoad record{{static_cast<uint32_t>(JitdumpRecord::CodeLoad),
+                            static_cast<uint32_t>(sizeof(JitdumpCodeLoad) + name.size() + 1 + size),
+                            timestamp()},
+                           static_cast<uint32_t>(getpid()),
+                           static_cast<uint32_t>(syscall(SYS_gettid)),
+                           reinterpret_cast<uint64_t>(code),
+                           reinterpret_cast<uint64_t>(code),
+                           size,
+                           _codeIndex};
+    std::fwrite(&record, sizeof(record), 1, _jitdumpFile);
+    std::fwrite(name.c_str(), name.size() + 1, 1, _jitdumpFile);
+    std::fwrite(code, size, 1, _jitdumpFile);
+}
+#endif
+#ifndef __linux__
+PerfMap::PerfMap(Format format) {}
+PerfMap::~PerfMap() {}
+
+void PerfMap::registerCode(const void* code,
+                           size_t size,
+                           const std::string& name,
+                           const std::vector<LineEntry>& lines) {}
+
+void PerfMap::writeJitdumpHeader() {}
+void PerfMap::writeJitdumpDebugInfo(const void* code, const std::vector<LineEntry>& lines) {}
+void PerfMap::writeJitdumpCodeLoad(const void* code, size_t size, const std::string& name) {}
+#endif
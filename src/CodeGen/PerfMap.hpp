@@ -0,0 +1,67 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_PERFMAP_HPP
+#define VUG_PERFMAP_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Lexing/Token.hpp"
+
+// Publishes generated machine code to Linux perf.
+// Map format: /tmp/perf-<pid>.map, one "<start> <size> <name>" line per code region.
+// Jitdump format: ./jit-<pid>.dump, consumed by `perf inject --jit`, also carries source lines.
+class PerfMap {
+public:
+    enum class Format : uint32_t {
+        None = 0,
+        Map = 1 << 0,
+        Jitdump = 1 << 1,
+    };
+
+    struct LineEntry {
+        const void* address;
+        SourceLocation sourceLocation;
+
+        LineEntry(const void* address, SourceLocation sourceLocation)
+            : address(address),
+              sourceLocation(sourceLocation) {}
+    };
+
+    explicit PerfMap(Format format);
+    ~PerfMap();
+
+    PerfMap(const PerfMap&) = delete;
+    PerfMap& operator=(const PerfMap&) = delete;
+
+    void registerCode(const void* code,
+                      size_t size,
+                      const std::string& name,
+                      const std::vector<LineEntry>& lines = {});
+
+    [[nodiscard]] bool isEnabled() const {
+        return _mapFile != nullptr || _jitdumpFile != nullptr;
+    }
+
+protected:
+    FILE* _mapFile{nullptr};
+    FILE* _jitdumpFile{nullptr};
+    void* _jitdumpMarker{nullptr};
+    uint64_t _codeIndex{0};
+
+    void writeJitdumpHeader();
+    void writeJitdumpDebugInfo(const void* code, const std::vector<LineEntry>& lines);
+    void writeJitdumpCodeLoad(const void* code, size_t size, const std::string& name);
+};
+
+constexpr PerfMap::Format operator|(PerfMap::Format lhs, PerfMap::Format rhs) {
+    return static_cast<PerfMap::Format>(static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+}
+constexpr bool operator&(PerfMap::Format lhs, PerfMap::Format rhs) {
+    return (static_cast<uint32_t>(lhs) & static_cast<uint32_t>(rhs)) != 0;
+}
+
+#endif//VUG_PERFMAP_HPP
@@ -0,0 +1,338 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "X86Assembler.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    bool fitsInt8(int64_t value) {
+        return value >= std::numeric_limits<int8_t>::min() && value <= std::numeric_limits<int8_t>::max();
+    }
+    bool fitsInt32(int64_t value) {
+        return value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max();
+    }
+}// namespace
+
+X86Assembler::Label X86Assembler::createLabel() {
+    _labels.push_back(-1);
+    _labelFixups.emplace_back();
+
+    return {_labels.size() - 1};
+}
+void X86Assembler::bind(Label label) {
+    if (_labels[label.id] != -1) {
+        throw std::logic_error("Label is already bound");
+    }
+    _labels[label.id] = static_cast<int64_t>(getPosition());
+
+    for (auto offset: _labelFixups[label.id]) {
+        patchInt32(offset, static_cast<int32_t>(getPosition() - (offset + 4)));
+    }
+    _labelFixups[label.id].clear();
+}
+size_t X86Assembler::getLabelPosition(Label label) const {
+    if (_labels[label.id] == -1) {
+        throw std::logic_error("Label isn't bound");
+    }
+    return static_cast<size_t>(_labels[label.id]);
+}
+
+void X86Assembler::patchInt32(size_t offset, int32_t value) {
+    for (size_t i = 0; i < 4; ++i) {
+        _code[offset + i] = static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8 * i));
+    }
+}
+
+void X86Assembler::movImm(Register dst, int64_t value) {
+    if (fitsInt32(value)) {
+        emitRex(true, Register::Rax, dst);
+        emitByte(0xC7);
+        emitByte(0xC0 | low(dst));
+        emitInt32(static_cast<int32_t>(value));
+    } else {
+        emitRex(true, Register::Rax, dst);
+        emitByte(0xB8 + low(dst));
+        emitInt64(value);
+    }
+}
+void X86Assembler::mov(Register dst, Register src) {
+    emitRegisterOperand(0x89, src, dst);
+}
+void X86Assembler::load(Register dst, Register base, int32_t displacement) {
+    emitRex(true, dst, base);
+    emitByte(0x8B);
+    emitMemoryOperand(dst, base, displacement);
+}
+void X86Assembler::store(Register base, int32_t displacement, Register src) {
+    emitRex(true, src, base);
+    emitByte(0x89);
+    emitMemoryOperand(src, base, displacement);
+}
+void X86Assembler::lea(Register dst, Register base, int32_t displacement) {
+    emitRex(true, dst, base);
+    emitByte(0x8D);
+    emitMemoryOperand(dst, base, displacement);
+}
+
+void X86Assembler::add(Register dst, Register src) {
+    emitRegisterOperand(0x01, src, dst);
+}
+void X86Assembler::sub(Register dst, Register src) {
+    emitRegisterOperand(0x29, src, dst);
+}
+void X86Assembler::imul(Register dst, Register src) {
+    emitRex(true, dst, src);
+    emitByte(0x0F);
+    emitByte(0xAF);
+    emitByte(0xC0 | (low(dst) << 3) | low(src));
+}
+void X86Assembler::bitAnd(Register dst, Register src) {
+    emitRegisterOperand(0x21, src, dst);
+}
+void X86Assembler::bitOr(Register dst, Register src) {
+    emitRegisterOperand(0x09, src, dst);
+}
+void X86Assembler::bitXor(Register dst, Register src) {
+    emitRegisterOperand(0x31, src, dst);
+}
+void X86Assembler::cmp(Register lhs, Register rhs) {
+    emitRegisterOperand(0x39, rhs, lhs);
+}
+void X86Assembler::test(Register lhs, Register rhs) {
+    emitRegisterOperand(0x85, rhs, lhs);
+}
+void X86Assembler::addImm(Register dst, int32_t value) {
+    emitRex(true, Register::Rax, dst);
+    if (fitsInt8(value)) {
+        emitByte(0x83);
+        emitByte(0xC0 | low(dst));
+        emitByte(static_cast<uint8_t>(value));
+    } else {
+        emitByte(0x81);
+        emitByte(0xC0 | low(dst));
+        emitInt32(value);
+    }
+}
+void X86Assembler::subImm(Register dst, int32_t value) {
+    emitRex(true, Register::Rax, dst);
+    if (fitsInt8(value)) {
+        emitByte(0x83);
+        emitByte(0xE8 | low(dst));
+        emitByte(static_cast<uint8_t>(value));
+    } else {
+        emitByte(0x81);
+        emitByte(0xE8 | low(dst));
+        emitInt32(value);
+    }
+}
+void X86Assembler::cmpImm(Register lhs, int32_t value) {
+    emitRex(true, Register::Rax, lhs);
+    if (fitsInt8(value)) {
+        emitByte(0x83);
+        emitByte(0xF8 | low(lhs));
+        emitByte(static_cast<uint8_t>(value));
+    } else {
+        emitByte(0x81);
+        emitByte(0xF8 | low(lhs));
+        emitInt32(value);
+    }
+}
+size_t X86Assembler::subImm32(Register dst, int32_t value) {
+    emitRex(true, Register::Rax, dst);
+    emitByte(0x81);
+    emitByte(0xE8 | low(dst));
+
+    auto offset = getPosition();
+    emitInt32(value);
+
+    return offset;
+}
+void X86Assembler::shlImm(Register dst, uint8_t value) {
+    emitRex(true, Register::Rax, dst);
+    emitByte(0xC1);
+    emitByte(0xE0 | low(dst));
+    emitByte(value);
+}
+void X86Assembler::sarImm(Register dst, uint8_t value) {
+    emitRex(true, Register::Rax, dst);
+    emitByte(0xC1);
+    emitByte(0xF8 | low(dst));
+    emitByte(value);
+}
+void X86Assembler::shrImm(Register dst, uint8_t value) {
+    emitRex(true, Register::Rax, dst);
+    emitByte(0xC1);
+    emitByte(0xE8 | low(dst));
+    emitByte(value);
+}
+void X86Assembler::neg(Register dst) {
+    emitRex(true, Register::Rax, dst);
+    emitByte(0xF7);
+    emitByte(0xD8 | low(dst));
+}
+void X86Assembler::cqo() {
+    emitByte(0x48);
+    emitByte(0x99);
+}
+void X86Assembler::idiv(Register divisor) {
+    emitRex(true, Register::Rax, divisor);
+    emitByte(0xF7);
+    emitByte(0xF8 | low(divisor));
+}
+void X86Assembler::div(Register divisor) {
+    emitRex(true, Register::Rax, divisor);
+    emitByte(0xF7);
+    emitByte(0xF0 | low(divisor));
+}
+
+void X86Assembler::signExtend(Register reg, uint32_t bits) {
+    switch (bits) {
+        case 8:
+            emitRex(true, reg, reg);
+            emitByte(0x0F);
+            emitByte(0xBE);
+            emitByte(0xC0 | (low(reg) << 3) | low(reg));
+            break;
+        case 16:
+            emitRex(true, reg, reg);
+            emitByte(0x0F);
+            emitByte(0xBF);
+            emitByte(0xC0 | (low(reg) << 3) | low(reg));
+            break;
+        case 32:
+            emitRex(true, reg, reg);
+            emitByte(0x63);
+            emitByte(0xC0 | (low(reg) << 3) | low(reg));
+            break;
+        case 64:
+            break;
+        default:
+            throw std::logic_error("Unsupported integer width");
+    }
+}
+void X86Assembler::zeroExtend(Register reg, uint32_t bits) {
+    switch (bits) {
+        case 8:
+            emitRex(false, reg, reg, low(reg) >= 4);
+            emitByte(0x0F);
+            emitByte(0xB6);
+            emitByte(0xC0 | (low(reg) << 3) | low(reg));
+            break;
+        case 16:
+            emitRex(false, reg, reg);
+            emitByte(0x0F);
+            emitByte(0xB7);
+            emitByte(0xC0 | (low(reg) << 3) | low(reg));
+            break;
+        case 32:
+            emitRex(false, reg, reg);
+            emitByte(0x89);
+            emitByte(0xC0 | (low(reg) << 3) | low(reg));
+            break;
+        case 64:
+            break;
+        default:
+            throw std::logic_error("Unsupported integer width");
+    }
+}
+void X86Assembler::setCondition(Condition condition, Register reg) {
+    emitRex(false, Register::Rax, reg, low(reg) >= 4);
+    emitByte(0x0F);
+    emitByte(0x90 | static_cast<uint8_t>(condition));
+    emitByte(0xC0 | low(reg));
+    zeroExtend(reg, 8);
+}
+
+void X86Assembler::push(Register reg) {
+    emitRex(false, Register::Rax, reg);
+    emitByte(0x50 + low(reg));
+}
+void X86Assembler::pop(Register reg) {
+    emitRex(false, Register::Rax, reg);
+    emitByte(0x58 + low(reg));
+}
+
+void X86Assembler::jmp(Label label) {
+    emitByte(0xE9);
+    emitLabelReference(label);
+}
+void X86Assembler::jcc(Condition condition, Label label) {
+    emitByte(0x0F);
+    emitByte(0x80 | static_cast<uint8_t>(condition));
+    emitLabelReference(label);
+}
+void X86Assembler::callSymbol(const std::string& symbol) {
+    emitByte(0xE8);
+    _symbolReferences.push_back({getPosition(), symbol});
+    emitInt32(0);
+}
+void X86Assembler::callAbsolute(const void* function) {
+    // r11 is caller-saved and never carries arguments
+    emitRex(true, Register::Rax, Register::R11);
+    emitByte(0xB8 + low(Register::R11));
+    emitInt64(static_cast<int64_t>(reinterpret_cast<uintptr_t>(function)));
+    emitRex(false, Register::Rax, Register::R11);
+    emitByte(0xFF);
+    emitByte(0xD0 | low(Register::R11));
+}
+void X86Assembler::ret() {
+    emitByte(0xC3);
+}
+
+void X86Assembler::emitInt32(int32_t value) {
+    for (size_t i = 0; i < 4; ++i) {
+        emitByte(static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8 * i)));
+    }
+}
+void X86Assembler::emitInt64(int64_t value) {
+    for (size_t i = 0; i < 8; ++i) {
+        emitByte(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+    }
+}
+
+void X86Assembler::emitRex(bool wide, Register reg, Register base, bool force) {
+    uint8_t rex = 0x40 |
+                  (wide ? 0x08 : 0) |
+                  (isExtended(reg) ? 0x04 : 0) |
+                  (isExtended(base) ? 0x01 : 0);
+    if (rex != 0x40 || force) {
+        emitByte(rex);
+    }
+}
+void X86Assembler::emitRegisterOperand(uint8_t opcode, Register reg, Register rm) {
+    emitRex(true, reg, rm);
+    emitByte(opcode);
+    emitByte(0xC0 | (low(reg) << 3) | low(rm));
+}
+void X86Assembler::emitMemoryOperand(Register reg, Register base, int32_t displacement) {
+    uint8_t mod;
+    if (displacement == 0 && low(base) != low(Register::Rbp)) {
+        mod = 0x00;
+    } else if (fitsInt8(displacement)) {
+        mod = 0x40;
+    } else {
+        mod = 0x80;
+    }
+
+    emitByte(mod | (low(reg) << 3) | low(base));
+    if (low(base) == low(Register::Rsp)) {
+        emitByte(0x24);
+    }
+
+    if (mod == 0x40) {
+        emitByte(static_cast<uint8_t>(displacement));
+    } else if (mod == 0x80) {
+        emitInt32(displacement);
+    }
+}
+void X86Assembler::emitLabelReference(Label label) {
+    auto offset = getPosition();
+    if (_labels[label.id] != -1) {
+        emitInt32(static_cast<int32_t>(_labels[label.id] - static_cast<int64_t>(offset + 4)));
+    } else {
+        _labelFixups[label.id].push_back(offset);
+        emitInt32(0);
+    }
+}
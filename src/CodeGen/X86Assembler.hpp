@@ -0,0 +1,146 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_X86ASSEMBLER_HPP
+#define VUG_X86ASSEMBLER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class Register : uint8_t {
+    Rax,
+    Rcx,
+    Rdx,
+    Rbx,
+    Rsp,
+    Rbp,
+    Rsi,
+    Rdi,
+    R8,
+    R9,
+    R10,
+    R11,
+    R12,
+    R13,
+    R14,
+    R15,
+};
+
+enum class Condition : uint8_t {
+    Overflow = 0x0,
+    NoOverflow = 0x1,
+    Below = 0x2,
+    AboveEqual = 0x3,
+    Equal = 0x4,
+    NotEqual = 0x5,
+    BelowEqual = 0x6,
+    Above = 0x7,
+    Less = 0xC,
+    GreaterEqual = 0xD,
+    LessEqual = 0xE,
+    Greater = 0xF,
+};
+
+constexpr Condition invert(Condition condition) {
+    return static_cast<Condition>(static_cast<uint8_t>(condition) ^ 1);
+}
+
+// Encoder for the x86-64 subset used by the code generators.
+// All arithmetic is 64-bit; narrower integers are kept sign/zero extended in registers.
+class X86Assembler {
+public:
+    struct Label {
+        size_t id;
+    };
+    struct SymbolReference {
+        size_t offset;
+        std::string symbol;
+    };
+
+    X86Assembler() = default;
+
+    [[nodiscard]] const std::vector<uint8_t>& getCode() const {
+        return _code;
+    }
+    [[nodiscard]] size_t getPosition() const {
+        return _code.size();
+    }
+    [[nodiscard]] const std::vector<SymbolReference>& getSymbolReferences() const {
+        return _symbolReferences;
+    }
+
+    Label createLabel();
+    void bind(Label label);
+    [[nodiscard]] size_t getLabelPosition(Label label) const;
+
+    void patchInt32(size_t offset, int32_t value);
+
+    void movImm(Register dst, int64_t value);
+    void mov(Register dst, Register src);
+    void load(Register dst, Register base, int32_t displacement);
+    void store(Register base, int32_t displacement, Register src);
+    void lea(Register dst, Register base, int32_t displacement);
+
+    void add(Register dst, Register src);
+    void sub(Register dst, Register src);
+    void imul(Register dst, Register src);
+    void bitAnd(Register dst, Register src);
+    void bitOr(Register dst, Register src);
+    void bitXor(Register dst, Register src);
+    void cmp(Register lhs, Register rhs);
+    void test(Register lhs, Register rhs);
+    void addImm(Register dst, int32_t value);
+    void subImm(Register dst, int32_t value);
+    void cmpImm(Register lhs, int32_t value);
+    // Emits `sub dst, imm32` and returns the offset of the immediate for later patching
+    size_t subImm32(Register dst, int32_t value);
+    void shlImm(Register dst, uint8_t value);
+    void sarImm(Register dst, uint8_t value);
+    void shrImm(Register dst, uint8_t value);
+    void neg(Register dst);
+    void cqo();
+    void idiv(Register divisor);
+    void div(Register divisor);
+
+    // Sign or zero extends the low `bits` of `reg` to the full register
+    void signExtend(Register reg, uint32_t bits);
+    void zeroExtend(Register reg, uint32_t bits);
+    // reg = condition ? 1 : 0
+    void setCondition(Condition condition, Register reg);
+
+    void push(Register reg);
+    void pop(Register reg);
+
+    void jmp(Label label);
+    void jcc(Condition condition, Label label);
+    void callSymbol(const std::string& symbol);
+    void callAbsolute(const void* function);
+    void ret();
+
+    void emitByte(uint8_t byte) {
+        _code.push_back(byte);
+    }
+    void emitInt32(int32_t value);
+    void emitInt64(int64_t value);
+
+protected:
+    std::vector<uint8_t> _code;
+    std::vector<int64_t> _labels;
+    std::vector<std::vector<size_t>> _labelFixups;
+    std::vector<SymbolReference> _symbolReferences;
+
+    static uint8_t low(Register reg) {
+        return static_cast<uint8_t>(reg) & 7;
+    }
+    static bool isExtended(Register reg) {
+        return static_cast<uint8_t>(reg) >= 8;
+    }
+
+    void emitRex(bool wide, Register reg, Register base, bool force = false);
+    void emitRegisterOperand(uint8_t opcode, Register reg, Register rm);
+    void emitMemoryOperand(Register reg, Register base, int32_t displacement);
+    void emitLabelReference(Label label);
+};
+
+#endif//VUG_X86ASSEMBLER_HPP
@@ -0,0 +1,31 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_DEOPTIMIZATION_HPP
+#define VUG_DEOPTIMIZATION_HPP
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Evaluator/Evaluator.hpp"
+
+// Interpreter frame rebuilt from optimized code
+struct DeoptimizationFrame {
+    // Statements enclosing the resume point, outermost first; the last one is evaluated again.
+    // Callee frames start at the function body, the frame of the optimized loop at its body.
+    std::vector<Statement*> path;
+    // Locals of a callee frame, the optimized loop writes its own into the current frame
+    Evaluator::Frame locals;
+    // Results of calls the resumed statement already made, used instead of calling again
+    std::unordered_map<const CallFunction*, std::unique_ptr<Object>> completedCalls;
+    // Call whose result comes from the next frame
+    const CallFunction* pendingCall{nullptr};
+};
+
+// Interpreter state at a failed guard of an optimized loop, outermost frame first
+struct Deoptimization {
+    std::vector<DeoptimizationFrame> frames;
+};
+
+#endif//VUG_DEOPTIMIZATION_HPP
@@ -4,10 +4,16 @@
 #include "Evaluator.hpp"
 
 #include "AST/ASTNodes.hpp"
+#include "Evaluator/Deoptimization.hpp"
 #include "Evaluator/Objects/BooleanObject.hpp"
 #include "Evaluator/Objects/IntegerObject.hpp"
+#include "JIT/TraceJit.hpp"
 #include "Misc/Stack.hpp"
 
+namespace {
+    // Leaves a compile-time evaluation that can't produce a value
+    struct EvaluationAbort {};
+}// namespace
 
 void Evaluator::evaluate() {
     stackGuard();
@@ -15,16 +21,47 @@ void Evaluator::evaluate() {
     auto& mainSymbol = *static_cast<ModuleDeclaration&>(_ast).symbolRef->findMember("main")[0];
     callFunction(static_cast<FunctionSymbol&>(mainSymbol), {});
 }
+std::unique_ptr<Object> Evaluator::evaluateCall(const FunctionSymbol& functionSymbol,
+                                                std::vector<std::unique_ptr<Object>> arguments,
+                                                uint64_t stepBudget) {
+    stackGuard();
+
+    _isBudgeted = true;
+    _stepBudget = stepBudget;
+    _steps = 0;
+
+    std::unique_ptr<Object> result;
+    try {
+        result = callFunction(functionSymbol, std::move(arguments));
+    } catch (const EvaluationAbort&) {
+        result = nullptr;
+    } catch (const std::logic_error&) {
+        // Operations the evaluator doesn't implement fail at run time instead
+        result = nullptr;
+    }
+
+    _localObjects = {};
+    _isBudgeted = false;
+    return result;
+}
 
 
 StmtResult Evaluator::evaluateStatement(Statement& node) {
     stackGuard();
 
+    if (_isBudgeted && ++_steps > _stepBudget) {
+        throw EvaluationAbort();
+    }
+
     return node.evaluate(*this);
 }
 std::unique_ptr<Object> Evaluator::evaluateExpression(Expression& node) {
     stackGuard();
 
+    if (_isBudgeted && ++_steps > _stepBudget) {
+        throw EvaluationAbort();
+    }
+
     return node.evaluate(*this);
 }
 
@@ -109,7 +146,32 @@ StmtResult Evaluator::evaluateStatement(const StatementsBlock& node) {
 StmtResult Evaluator::evaluateStatement(const While& node) {
     stackGuard();
 
-    while (static_cast<BooleanObject&>(*evaluateExpression(*node.condition)).getValue()) {
+    while (true) {
+        // A resumed loop condition must use the overridden calls before anything runs natively
+        if (_traceJit != nullptr && _callOverrides.empty()) {
+            auto deoptimization = _traceJit->execute(node, _localObjects.top());
+
+            if (deoptimization != nullptr) {
+                auto result = resume(*deoptimization);
+                if (result.resultType != StmtResultKind::Successful) {
+                    if (result.breakedStmt == &node) {
+                        break;
+                    } else {
+                        return result;
+                    }
+                }
+                if (!deoptimization->frames[0].path.empty()) {
+                    continue;
+                }
+            }
+        }
+
+        auto condition = evaluateExpression(*node.condition);
+        _callOverrides.clear();
+        if (!static_cast<BooleanObject&>(*condition).getValue()) {
+            break;
+        }
+
         auto result = evaluateStatement(*node.body);
         if (result.resultType != StmtResultKind::Successful) {
             if (result.breakedStmt == &node) {
@@ -129,11 +191,30 @@ std::unique_ptr<Object> Evaluator::evaluateExpression(const BinaryOperation& nod
     auto left = evaluateExpression(*node.left);
     auto right = evaluateExpression(*node.right);
 
+    // Division traps end the program, at compile time they only cancel the evaluation
+    if (_isBudgeted &&
+        (node.operationToken == LexemType::Divide || node.operationToken == LexemType::Remainder)) {
+        auto dividend = left->to<const IntegerObject<int32_t>&>().getValue();
+        auto divisor = right->to<const IntegerObject<int32_t>&>().getValue();
+        if (divisor == 0 || (divisor == -1 && dividend == INT32_MIN)) {
+            throw EvaluationAbort();
+        }
+    }
+
     return left->binaryOperation(node.operationToken, *right);
 }
 std::unique_ptr<Object> Evaluator::evaluateExpression(const CallFunction& node) {
     stackGuard();
 
+    if (!_callOverrides.empty() && _localObjects.size() == _overrideDepth) {
+        auto completed = _callOverrides.find(&node);
+        if (completed != _callOverrides.end()) {
+            auto result = std::move(completed->second);
+            _callOverrides.erase(completed);
+            return result;
+        }
+    }
+
     std::vector<std::unique_ptr<Object>> arguments;
     arguments.reserve(node.arguments.size());
 
@@ -146,12 +227,16 @@ std::unique_ptr<Object> Evaluator::evaluateExpression(const CallFunction& node)
 std::unique_ptr<Object> Evaluator::evaluateExpression(const Number& node) {
     stackGuard();
 
-    return std::make_unique<IntegerObject<int32_t>>(std::stoi(node.number));
+    return std::make_unique<IntegerObject<int32_t>>(std::stoi(std::string(node.number)));
 }
 std::unique_ptr<Object> Evaluator::evaluateExpression(const Identifier& node) {
     stackGuard();
 
-    return _localObjects.top()[node.symbolRef]->clone();
+    auto& object = _localObjects.top()[node.symbolRef];
+    if (_isBudgeted && object == nullptr) {
+        throw EvaluationAbort();
+    }
+    return object->clone();
 }
 std::unique_ptr<Object> Evaluator::evaluateExpression(const PrefixOperation& node) {
     stackGuard();
@@ -163,6 +248,9 @@ std::unique_ptr<Object> Evaluator::evaluateExpression(const PrefixOperation& nod
 std::unique_ptr<Object> Evaluator::callFunction(const FunctionSymbol& functionSymbol, std::vector<std::unique_ptr<Object>> arguments) {
     stackGuard();
 
+    if (_isBudgeted && _localObjects.size() >= maxCompileTimeDepth) {
+        throw EvaluationAbort();
+    }
     _localObjects.emplace();
 
     size_t index = 0;
@@ -174,3 +262,69 @@ std::unique_ptr<Object> Evaluator::callFunction(const FunctionSymbol& functionSy
 
     return std::move(result.returnedObject);
 }
+
+StmtResult Evaluator::resume(Deoptimization& deoptimization, size_t frameIndex) {
+    stackGuard();
+
+    auto& frame = deoptimization.frames[frameIndex];
+
+    if (frameIndex + 1 < deoptimization.frames.size()) {
+        _localObjects.push(std::move(deoptimization.frames[frameIndex + 1].locals));
+        auto result = resume(deoptimization, frameIndex + 1);
+
+        frame.completedCalls[frame.pendingCall] = std::move(result.returnedObject);
+    }
+
+    _callOverrides = std::move(frame.completedCalls);
+    _overrideDepth = _localObjects.size();
+
+    if (frame.path.empty()) {
+        return {StmtResultKind::Successful};
+    }
+    return resumePath(frame.path, 0);
+}
+StmtResult Evaluator::resumePath(const std::vector<Statement*>& path, size_t depth) {
+    stackGuard();
+
+    auto& node = *path[depth];
+
+    if (depth + 1 == path.size()) {
+        auto result = evaluateStatement(node);
+        _callOverrides.clear();
+        return result;
+    }
+
+    auto result = resumePath(path, depth + 1);
+
+    switch (node.kind) {
+        case Node::Kind::StatementBlock: {
+            if (result.resultType != StmtResultKind::Successful) {
+                return result;
+            }
+
+            const auto& statements = static_cast<StatementsBlock&>(node).statements;
+            auto next = std::find_if(statements.begin(), statements.end(), [&](const auto& statement) {
+                return statement.get() == path[depth + 1];
+            });
+            for (++next; next != statements.end(); ++next) {
+                result = evaluateStatement(**next);
+                if (result.resultType != StmtResultKind::Successful) {
+                    return result;
+                }
+            }
+            return {StmtResultKind::Successful};
+        }
+        case Node::Kind::If:
+            return result;
+        case Node::Kind::While:
+            if (result.resultType != StmtResultKind::Successful) {
+                if (result.breakedStmt == &node) {
+                    return {StmtResultKind::Successful};
+                }
+                return result;
+            }
+            return evaluateStatement(static_cast<const While&>(node));
+        default:
+            throw std::logic_error("Unsupported operation");
+    }
+}
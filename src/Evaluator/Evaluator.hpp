@@ -12,6 +12,8 @@
 class Symbol;
 class FunctionSymbol;
 class SymbolContext;
+class TraceJit;
+struct Deoptimization;
 
 enum class StmtResultKind {
     Successful,
@@ -38,12 +40,26 @@ struct StmtResult {
 
 class Evaluator {
 public:
+    static constexpr size_t maxCompileTimeDepth = 256;
+
+    using Frame = std::unordered_map<const Symbol*, std::unique_ptr<Object>>;
+
     explicit Evaluator(Node& ast,
-                       const SymbolContext& typeContext)
+                       const SymbolContext& typeContext,
+                       TraceJit* traceJit = nullptr)
         : _ast(ast),
-          _typeContext(typeContext) {}
+          _typeContext(typeContext),
+          _traceJit(traceJit) {}
 
     void evaluate();
+    // Runs a call at compile time. Returns nullptr when the call traps, recurses deeper than
+    // `maxCompileTimeDepth` or takes more than `stepBudget` statements and expressions.
+    std::unique_ptr<Object> evaluateCall(const FunctionSymbol& functionSymbol,
+                                         std::vector<std::unique_ptr<Object>> arguments,
+                                         uint64_t stepBudget);
+    [[nodiscard]] uint64_t getSteps() const {
+        return _steps;
+    }
 
     void evaluateDeclaration(const DeclarationsBlock& node);
     void evaluateDeclaration(const FunctionDeclaration& node);
@@ -68,12 +84,26 @@ public:
 protected:
     Node& _ast;
     const SymbolContext& _typeContext;
-    std::stack<std::unordered_map<const Symbol*, std::unique_ptr<Object>>> _localObjects;
+    TraceJit* _traceJit;
+    std::stack<Frame> _localObjects;
+
+    bool _isBudgeted{false};
+    uint64_t _stepBudget{0};
+    uint64_t _steps{0};
+
+    // Results of calls made before a deoptimization, valid for the frame at `_overrideDepth`
+    std::unordered_map<const CallFunction*, std::unique_ptr<Object>> _callOverrides;
+    size_t _overrideDepth{0};
 
     StmtResult evaluateStatement(Statement& node);
     std::unique_ptr<Object> evaluateExpression(Expression& node);
 
     std::unique_ptr<Object> callFunction(const FunctionSymbol& functionSymbol, std::vector<std::unique_ptr<Object>> arguments);
+
+    // Finishes the loop iteration an optimized trace left, innermost frame first.
+    // With an empty path the overrides stay installed for the loop condition.
+    StmtResult resume(Deoptimization& deoptimization, size_t frameIndex = 0);
+    StmtResult resumePath(const std::vector<Statement*>& path, size_t depth);
 };
 
 
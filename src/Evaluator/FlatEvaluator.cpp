@@ -0,0 +1,155 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "FlatEvaluator.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include "Misc/Stack.hpp"
+
+void FlatEvaluator::evaluate() {
+    stackGuard();
+
+    callFunction(_ast.getMainFunction(), _slots.size());
+}
+
+FlatEvaluator::Completion FlatEvaluator::evaluateStatement(NodeId node) {
+    stackGuard();
+
+    switch (_ast.getKind(node)) {
+        case Node::Kind::StatementBlock:
+            for (auto statement: _ast.getChildren(node)) {
+                auto completion = evaluateStatement(statement);
+                if (completion != Completion::Normal) {
+                    return completion;
+                }
+            }
+            return Completion::Normal;
+        case Node::Kind::If: {
+            auto children = _ast.getChildren(node);
+            if (evaluateExpression(children[0]) != 0) {
+                return evaluateStatement(children[1]);
+            } else if (children.size() > 2) {
+                return evaluateStatement(children[2]);
+            }
+            return Completion::Normal;
+        }
+        case Node::Kind::While: {
+            auto condition = _ast.getChild(node, 0);
+            auto body = _ast.getChild(node, 1);
+            while (evaluateExpression(condition) != 0) {
+                auto completion = evaluateStatement(body);
+                if (completion == Completion::Break && _breakTarget == node) {
+                    break;
+                }
+                if (completion != Completion::Normal) {
+                    return completion;
+                }
+            }
+            return Completion::Normal;
+        }
+        case Node::Kind::Break:
+            _breakTarget = _ast.getPayload(node);
+            return Completion::Break;
+        case Node::Kind::Return:
+            _returnValue = evaluateExpression(_ast.getChild(node, 0));
+            return Completion::Return;
+        case Node::Kind::Print:
+            std::cout << evaluateExpression(_ast.getChild(node, 0)) << std::endl;
+            return Completion::Normal;
+        case Node::Kind::Assign:
+        case Node::Kind::LocalVarDeclaration: {
+            // Calls in the value may move the slots
+            auto value = evaluateExpression(_ast.getChild(node, 0));
+            _slots[_frame + _ast.getPayload(node)] = value;
+            return Completion::Normal;
+        }
+        default:
+            throw std::logic_error("Unsupported statement");
+    }
+}
+int32_t FlatEvaluator::evaluateExpression(NodeId node) {
+    stackGuard();
+
+    switch (_ast.getKind(node)) {
+        case Node::Kind::Number:
+            return static_cast<int32_t>(_ast.getPayload(node));
+        case Node::Kind::Identifier:
+            return _slots[_frame + _ast.getPayload(node)];
+        case Node::Kind::CallFunction: {
+            auto frame = _slots.size();
+            for (auto argument: _ast.getChildren(node)) {
+                auto value = evaluateExpression(argument);
+                _slots.push_back(value);
+            }
+            return callFunction(_ast.getPayload(node), frame);
+        }
+        case Node::Kind::BinaryOperation: {
+            auto left = evaluateExpression(_ast.getChild(node, 0));
+            auto right = evaluateExpression(_ast.getChild(node, 1));
+
+            switch (static_cast<FlatAST::Operation>(_ast.getPayload(node))) {
+                case FlatAST::Operation::Equal:
+                    return left == right;
+                case FlatAST::Operation::Unequal:
+                    return left != right;
+                case FlatAST::Operation::Less:
+                    return left < right;
+                case FlatAST::Operation::LessEqual:
+                    return left <= right;
+                case FlatAST::Operation::Greater:
+                    return left > right;
+                case FlatAST::Operation::GreaterEqual:
+                    return left >= right;
+                case FlatAST::Operation::Add:
+                    return left + right;
+                case FlatAST::Operation::Subtract:
+                    return left - right;
+                case FlatAST::Operation::Multiply:
+                    return left * right;
+                case FlatAST::Operation::Divide:
+                    return left / right;
+                case FlatAST::Operation::Remainder:
+                    return left % right;
+                case FlatAST::Operation::LogicAnd:
+                    return left != 0 && right != 0;
+                case FlatAST::Operation::LogicOr:
+                    return left != 0 || right != 0;
+                default:
+                    throw std::logic_error("Unsupported operation");
+            }
+        }
+        case Node::Kind::PrefixOperation: {
+            auto right = evaluateExpression(_ast.getChild(node, 0));
+
+            switch (static_cast<FlatAST::Operation>(_ast.getPayload(node))) {
+                case FlatAST::Operation::Negate:
+                    return -right;
+                case FlatAST::Operation::Not:
+                    return right == 0;
+                default:
+                    throw std::logic_error("Unsupported operation");
+            }
+        }
+        default:
+            throw std::logic_error("Unsupported expression");
+    }
+}
+
+int32_t FlatEvaluator::callFunction(uint32_t function, size_t frame) {
+    stackGuard();
+
+    const auto& callee = _ast.getFunctions()[function];
+    _slots.resize(frame + callee.slotCount);
+    auto callerFrame = std::exchange(_frame, frame);
+
+    _returnValue = 0;
+    evaluateStatement(callee.definition);
+    auto result = _returnValue;
+
+    _frame = callerFrame;
+    _slots.resize(frame);
+    return result;
+}
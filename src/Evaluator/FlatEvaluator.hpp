@@ -0,0 +1,46 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_FLATEVALUATOR_HPP
+#define VUG_FLATEVALUATOR_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "AST/FlatAST.hpp"
+
+// Runs a FlatAST the way Evaluator runs the tree, switching on node kinds instead of calling the nodes.
+// Values are the int32 and boolean objects of Evaluator unboxed into frame slots, booleans as 0 and 1.
+// Neither the trace JIT nor compile-time evaluation can use it.
+class FlatEvaluator {
+public:
+    explicit FlatEvaluator(const FlatAST& ast)
+        : _ast(ast) {}
+
+    void evaluate();
+
+protected:
+    enum class Completion {
+        Normal,
+        Break,
+        Return,
+    };
+
+    const FlatAST& _ast;
+    // Frames of the calls in progress, the innermost one last
+    std::vector<int32_t> _slots;
+    size_t _frame{0};
+
+    // Loop a Break completion leaves
+    NodeId _breakTarget{FlatAST::noNode};
+    // Value a Return completion carries
+    int32_t _returnValue{0};
+
+    Completion evaluateStatement(NodeId node);
+    int32_t evaluateExpression(NodeId node);
+
+    // The arguments are the values of `_slots` from `frame` on
+    int32_t callFunction(uint32_t function, size_t frame);
+};
+
+#endif//VUG_FLATEVALUATOR_HPP
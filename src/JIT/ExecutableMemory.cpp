@@ -0,0 +1,59 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ExecutableMemory.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#ifdef _WIN32
+#include <windows.h>
+
+ExecutableMemory::ExecutableMemory(const std::vector<uint8_t>& code)
+    : _size(code.size()),
+      _mappedSize(code.size()) {
+    _memory = VirtualAlloc(nullptr, _mappedSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (_memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    std::memcpy(_memory, code.data(), code.size());
+
+    DWORD oldProtection;
+    if (!VirtualProtect(_memory, _mappedSize, PAGE_EXECUTE_READ, &oldProtection)) {
+        auto error = static_cast<int>(GetLastError());
+        VirtualFree(_memory, 0, MEM_RELEASE);
+        throw std::system_error(error, std::system_category(), "VirtualProtect");
+    }
+    FlushInstructionCache(GetCurrentProcess(), _memory, _mappedSize);
+}
+ExecutableMemory::~ExecutableMemory() {
+    VirtualFree(_memory, 0, MEM_RELEASE);
+}
+#endif
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+
+ExecutableMemory::ExecutableMemory(const std::vector<uint8_t>& code)
+    : _size(code.size()) {
+    auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    _mappedSize = (code.size() + pageSize - 1) / pageSize * pageSize;
+
+    _memory = mmap(nullptr, _mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (_memory == MAP_FAILED) {
+        _memory = nullptr;
+        throw std::bad_alloc();
+    }
+    std::memcpy(_memory, code.data(), code.size());
+    if (mprotect(_memory, _mappedSize, PROT_READ | PROT_EXEC) != 0) {
+        auto error = errno;
+        munmap(_memory, _mappedSize);
+        throw std::system_error(error, std::generic_category(), "mprotect");
+    }
+}
+ExecutableMemory::~ExecutableMemory() {
+    munmap(_memory, _mappedSize);
+}
+#endif
@@ -0,0 +1,34 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_EXECUTABLEMEMORY_HPP
+#define VUG_EXECUTABLEMEMORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Page-aligned copy of generated code, mapped read+execute once written.
+// Throws std::bad_alloc when no pages are left and std::system_error when they can't be made executable.
+class ExecutableMemory {
+public:
+    explicit ExecutableMemory(const std::vector<uint8_t>& code);
+    ~ExecutableMemory();
+
+    ExecutableMemory(const ExecutableMemory&) = delete;
+    ExecutableMemory& operator=(const ExecutableMemory&) = delete;
+
+    [[nodiscard]] const void* getCode() const {
+        return _memory;
+    }
+    [[nodiscard]] size_t getSize() const {
+        return _size;
+    }
+
+protected:
+    void* _memory{nullptr};
+    size_t _size{0};
+    size_t _mappedSize{0};
+};
+
+#endif//VUG_EXECUTABLEMEMORY_HPP
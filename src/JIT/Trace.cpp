@@ -0,0 +1,54 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Trace.hpp"
+
+#include "Evaluator/Objects/BooleanObject.hpp"
+#include "Evaluator/Objects/IntegerObject.hpp"
+#include "Semantic/Type.hpp"
+
+namespace {
+    bool isBoolean(const Type* type) {
+        return type->getKind() == TypeKind::Primitive &&
+               static_cast<const PrimitiveType*>(type)->getPrimitiveKind() == PrimitiveKind::Boolean;
+    }
+    bool isInt32(const Type* type) {
+        if (!type->isInteger()) {
+            return false;
+        }
+        auto integerType = static_cast<const IntegerType*>(type);
+        return integerType->getBits() == 32 && integerType->isIsSigned();
+    }
+}// namespace
+
+bool isTraceableType(const Type* type) {
+    return type != nullptr && (isBoolean(type) || isInt32(type));
+}
+int64_t unboxValue(const Object& object, const Type* type) {
+    if (isBoolean(type)) {
+        return object.to<const BooleanObject&>().getValue();
+    }
+    return object.to<const IntegerObject<int32_t>&>().getValue();
+}
+std::unique_ptr<Object> boxValue(int64_t value, const Type* type) {
+    if (isBoolean(type)) {
+        return std::make_unique<BooleanObject>(value != 0);
+    }
+    return std::make_unique<IntegerObject<int32_t>>(static_cast<int32_t>(value));
+}
+int64_t normalizeValue(int64_t value, const Type* type) {
+    if (!type->isInteger()) {
+        return value != 0;
+    }
+
+    auto integerType = static_cast<const IntegerType*>(type);
+    auto bits = integerType->getBits();
+    if (bits >= 64) {
+        return value;
+    }
+
+    auto shift = 64 - bits;
+    auto raw = static_cast<uint64_t>(value) << shift;
+    return integerType->isIsSigned() ? static_cast<int64_t>(raw) >> shift
+                                     : static_cast<int64_t>(raw >> shift);
+}
@@ -0,0 +1,125 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_TRACE_HPP
+#define VUG_TRACE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "AST/ASTNodesForward.hpp"
+#include "Lexing/Token.hpp"
+
+class LocalVariableSymbol;
+class Object;
+class Type;
+
+// Root slots mirror the locals of the traced function and are shared by every path of a trace,
+// temporaries belong to inlined callees and call results.
+struct TraceSlot {
+    uint32_t index;
+    bool isRoot;
+};
+
+// Linear IR of one recorded loop iteration
+struct TraceExpression {
+    enum class Kind {
+        Constant,
+        Slot,
+        BinaryOperation,
+        PrefixOperation,
+    };
+
+    const Kind kind;
+    const Type* type;
+    int64_t constant{0};
+    TraceSlot slot{0, false};
+    LexemType operation{LexemType::EndOfFile};
+    // Of binary operations, see BinaryOperation
+    bool isLeftNonNegative{false};
+    std::unique_ptr<TraceExpression> left;
+    std::unique_ptr<TraceExpression> right;
+
+    TraceExpression(Kind kind, const Type* type)
+        : kind(kind),
+          type(type) {}
+};
+
+// Interpreter frame at a trace exit, see DeoptimizationFrame
+struct FrameStateLevel {
+    std::vector<Statement*> path;
+    std::vector<std::pair<const LocalVariableSymbol*, TraceSlot>> locals;
+    std::vector<std::pair<const CallFunction*, TraceSlot>> completedCalls;
+    const CallFunction* pendingCall{nullptr};
+};
+
+// Recorded for every instruction that may leave the trace.
+// The first level is the traced function, whose locals are the root slots.
+struct FrameState {
+    std::vector<FrameStateLevel> levels;
+};
+
+struct TraceInstruction {
+    enum class Kind {
+        Store,
+        Guard,
+        Print,
+    };
+
+    const Kind kind;
+    std::unique_ptr<TraceExpression> expression;
+    SourceLocation sourceLocation;
+    // Store: destination slot
+    TraceSlot slot{0, false};
+    // Guard: value the expression had while recording
+    bool expected{false};
+    // Where the interpreter resumes if the instruction exits
+    std::unique_ptr<FrameState> frameState;
+
+    TraceInstruction(Kind kind,
+                     std::unique_ptr<TraceExpression> expression,
+                     SourceLocation sourceLocation)
+        : kind(kind),
+          expression(std::move(expression)),
+          sourceLocation(sourceLocation) {}
+};
+
+struct TraceRootSlot {
+    const LocalVariableSymbol* symbol;
+    bool isWritten;
+};
+
+// One way through the loop body.
+// A branch path starts right after a guard of its parent and replaces that guard's exit.
+struct TracePath {
+    // Position of the first instruction within the whole iteration
+    size_t start{0};
+    std::vector<TraceInstruction> instructions;
+    // Guard instruction index to branch path index
+    std::unordered_map<size_t, size_t> branches;
+};
+
+// Tree of paths through a loop body.
+// The first instruction of the first path guards the loop condition, its failure leaves the loop.
+struct Trace {
+    const While* loop;
+    std::vector<TracePath> paths;
+    std::vector<TraceRootSlot> rootSlots;
+    uint32_t temporaryCount{0};
+    bool hasPrints{false};
+
+    explicit Trace(const While* loop)
+        : loop(loop) {}
+};
+
+// Traced code keeps every value as int64; only the types the evaluator materializes
+// (int32 and bool) may cross the boundary between the interpreter and a trace.
+bool isTraceableType(const Type* type);
+int64_t unboxValue(const Object& object, const Type* type);
+std::unique_ptr<Object> boxValue(int64_t value, const Type* type);
+// Wraps a 64-bit result to the width and signedness of `type`
+int64_t normalizeValue(int64_t value, const Type* type);
+
+#endif//VUG_TRACE_HPP
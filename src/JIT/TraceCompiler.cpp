@@ -0,0 +1,257 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "TraceCompiler.hpp"
+
+#include <iostream>
+
+#include "CodeGen/ArithmeticLowering.hpp"
+#include "Misc/Stack.hpp"
+#include "Semantic/Type.hpp"
+
+namespace {
+    constexpr Register slotsRegister = Register::Rbx;
+    constexpr Register runtimeRegister = Register::R12;
+
+    constexpr size_t outputBufferSize = 64 * 1024;
+
+    void tracePrint(TraceRuntime* runtime, int64_t value) {
+        runtime->output += std::to_string(value);
+        runtime->output += '\n';
+        if (runtime->output.size() >= outputBufferSize) {
+            flushTraceOutput(*runtime);
+        }
+    }
+
+    bool isSigned(const Type* type) {
+        return !type->isInteger() || static_cast<const IntegerType*>(type)->isIsSigned();
+    }
+}// namespace
+
+void flushTraceOutput(TraceRuntime& runtime) {
+    if (!runtime.output.empty()) {
+        std::cout << runtime.output << std::flush;
+        runtime.output.clear();
+    }
+}
+
+void TraceCompiler::compile() {
+    stackGuard();
+
+    auto epilogue = _assembler.createLabel();
+    auto loop = _assembler.createLabel();
+    auto backEdge = _assembler.createLabel();
+
+    std::vector<X86Assembler::Label> pathLabels;
+    for (size_t index = 0; index < _trace.paths.size(); ++index) {
+        pathLabels.push_back(_assembler.createLabel());
+    }
+
+    // rbp keeps the frame so exits may leave expression temporaries on the stack
+    _assembler.push(Register::Rbp);
+    _assembler.mov(Register::Rbp, Register::Rsp);
+    _assembler.push(slotsRegister);
+    _assembler.push(runtimeRegister);
+    _assembler.mov(slotsRegister, Register::Rdi);
+    _assembler.mov(runtimeRegister, Register::Rsi);
+
+    _assembler.bind(loop);
+    for (_currentPath = 0; _currentPath < _trace.paths.size(); ++_currentPath) {
+        const auto& path = _trace.paths[_currentPath];
+        _assembler.bind(pathLabels[_currentPath]);
+
+        for (_currentInstruction = 0; _currentInstruction < path.instructions.size(); ++_currentInstruction) {
+            const auto& instruction = path.instructions[_currentInstruction];
+            _lineOffsets.push_back({_assembler.getPosition(), instruction.sourceLocation});
+
+            compileExpression(*instruction.expression);
+
+            switch (instruction.kind) {
+                case TraceInstruction::Kind::Store:
+                    _assembler.store(slotsRegister, getOffset(instruction.slot), Register::Rax);
+                    break;
+                case TraceInstruction::Kind::Guard: {
+                    auto branch = path.branches.find(_currentInstruction);
+                    auto target = branch != path.branches.end() ? pathLabels[branch->second] : createExit(true);
+
+                    _assembler.test(Register::Rax, Register::Rax);
+                    _assembler.jcc(instruction.expected ? Condition::Equal : Condition::NotEqual, target);
+                    break;
+                }
+                case TraceInstruction::Kind::Print:
+                    _assembler.mov(Register::Rdi, runtimeRegister);
+                    _assembler.mov(Register::Rsi, Register::Rax);
+                    _assembler.callAbsolute(reinterpret_cast<const void*>(&tracePrint));
+                    break;
+            }
+        }
+
+        if (_currentPath + 1 < _trace.paths.size()) {
+            _assembler.jmp(backEdge);
+        }
+    }
+
+    // Iteration completed: commit written roots
+    _assembler.bind(backEdge);
+    for (uint32_t root = 0; root < _trace.rootSlots.size(); ++root) {
+        if (_trace.rootSlots[root].isWritten) {
+            _assembler.load(Register::Rax, slotsRegister, getOffset(root));
+            _assembler.store(slotsRegister, getOffset(getCommittedIndex(_trace, root)), Register::Rax);
+        }
+    }
+    _assembler.load(Register::Rax, slotsRegister, getOffset(getCounterIndex(_trace)));
+    _assembler.addImm(Register::Rax, 1);
+    _assembler.store(slotsRegister, getOffset(getCounterIndex(_trace)), Register::Rax);
+    _assembler.jmp(loop);
+
+    for (size_t index = 0; index < _exitLabels.size(); ++index) {
+        _assembler.bind(_exitLabels[index]);
+        _assembler.movImm(Register::Rax, static_cast<int64_t>(index));
+        _assembler.jmp(epilogue);
+    }
+
+    _assembler.bind(epilogue);
+    _assembler.lea(Register::Rsp, Register::Rbp, -16);
+    _assembler.pop(runtimeRegister);
+    _assembler.pop(slotsRegister);
+    _assembler.pop(Register::Rbp);
+    _assembler.ret();
+}
+
+void TraceCompiler::compileExpression(const TraceExpression& expression) {
+    stackGuard();
+
+    switch (expression.kind) {
+        case TraceExpression::Kind::Constant:
+            _assembler.movImm(Register::Rax, expression.constant);
+            return;
+        case TraceExpression::Kind::Slot:
+            _assembler.load(Register::Rax, slotsRegister, getOffset(expression.slot));
+            return;
+        case TraceExpression::Kind::PrefixOperation:
+            compileExpression(*expression.right);
+            if (expression.operation == LexemType::Minus) {
+                _assembler.neg(Register::Rax);
+            } else {
+                _assembler.movImm(Register::Rcx, 1);
+                _assembler.bitXor(Register::Rax, Register::Rcx);
+            }
+            normalize(expression.type);
+            return;
+        case TraceExpression::Kind::BinaryOperation:
+            break;
+    }
+
+    // A constant divisor that can't trap needs no exit
+    if (expression.right->kind == TraceExpression::Kind::Constant &&
+        canLowerByConstant(expression.operation, expression.right->constant, expression.left->type)) {
+        compileExpression(*expression.left);
+        lowerByConstant(_assembler,
+                        expression.operation,
+                        expression.right->constant,
+                        expression.left->type,
+                        expression.isLeftNonNegative);
+        normalize(expression.type);
+        return;
+    }
+
+    compileExpression(*expression.left);
+    _assembler.push(Register::Rax);
+    compileExpression(*expression.right);
+    _assembler.mov(Register::Rcx, Register::Rax);
+    _assembler.pop(Register::Rax);
+
+    auto operandSigned = isSigned(expression.left->type);
+
+    switch (expression.operation) {
+        case LexemType::Plus:
+            _assembler.add(Register::Rax, Register::Rcx);
+            break;
+        case LexemType::Minus:
+            _assembler.sub(Register::Rax, Register::Rcx);
+            break;
+        case LexemType::Multiply:
+            _assembler.imul(Register::Rax, Register::Rcx);
+            break;
+        case LexemType::Divide:
+        case LexemType::Remainder:
+            // Divisions that trap in the interpreter are left to the interpreter
+            _assembler.test(Register::Rcx, Register::Rcx);
+            _assembler.jcc(Condition::Equal, createExit(false));
+            if (operandSigned) {
+                auto divisible = _assembler.createLabel();
+                auto bits = static_cast<const IntegerType*>(expression.left->type)->getBits();
+
+                _assembler.cmpImm(Register::Rcx, -1);
+                _assembler.jcc(Condition::NotEqual, divisible);
+                _assembler.movImm(Register::Rdx, static_cast<int64_t>(UINT64_MAX << (bits - 1)));
+                _assembler.cmp(Register::Rax, Register::Rdx);
+                _assembler.jcc(Condition::Equal, createExit(false));
+                _assembler.bind(divisible);
+                _assembler.cqo();
+                _assembler.idiv(Register::Rcx);
+            } else {
+                _assembler.movImm(Register::Rdx, 0);
+                _assembler.div(Register::Rcx);
+            }
+            if (expression.operation == LexemType::Remainder) {
+                _assembler.mov(Register::Rax, Register::Rdx);
+            }
+            break;
+        case LexemType::LogicAnd:
+            _assembler.bitAnd(Register::Rax, Register::Rcx);
+            break;
+        case LexemType::LogicOr:
+            _assembler.bitOr(Register::Rax, Register::Rcx);
+            break;
+        case LexemType::Equal:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(Condition::Equal, Register::Rax);
+            break;
+        case LexemType::Unequal:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(Condition::NotEqual, Register::Rax);
+            break;
+        case LexemType::Less:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(operandSigned ? Condition::Less : Condition::Below, Register::Rax);
+            break;
+        case LexemType::LessEqual:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(operandSigned ? Condition::LessEqual : Condition::BelowEqual, Register::Rax);
+            break;
+        case LexemType::Greater:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(operandSigned ? Condition::Greater : Condition::Above, Register::Rax);
+            break;
+        case LexemType::GreaterEqual:
+            _assembler.cmp(Register::Rax, Register::Rcx);
+            _assembler.setCondition(operandSigned ? Condition::GreaterEqual : Condition::AboveEqual, Register::Rax);
+            break;
+        default:
+            throw std::logic_error("Unsupported operation");
+    }
+
+    normalize(expression.type);
+}
+void TraceCompiler::normalize(const Type* type) {
+    if (type->isInteger()) {
+        auto integerType = static_cast<const IntegerType*>(type);
+        if (integerType->isIsSigned()) {
+            _assembler.signExtend(Register::Rax, integerType->getBits());
+        } else {
+            _assembler.zeroExtend(Register::Rax, integerType->getBits());
+        }
+    }
+}
+X86Assembler::Label TraceCompiler::createExit(bool isGuard) {
+    _exits.push_back({_currentPath, _currentInstruction, isGuard});
+    _exitLabels.push_back(_assembler.createLabel());
+    return _exitLabels.back();
+}
+int32_t TraceCompiler::getOffset(size_t index) const {
+    return static_cast<int32_t>(index * sizeof(int64_t));
+}
+int32_t TraceCompiler::getOffset(TraceSlot slot) const {
+    return getOffset(getSlotIndex(_trace, slot));
+}
@@ -0,0 +1,86 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_TRACECOMPILER_HPP
+#define VUG_TRACECOMPILER_HPP
+
+#include <string>
+#include <vector>
+
+#include "CodeGen/X86Assembler.hpp"
+#include "JIT/Trace.hpp"
+
+// State shared by every trace, passed to the runtime helpers
+struct TraceRuntime {
+    // Prints are buffered while a trace runs and flushed before the interpreter continues
+    std::string output;
+};
+
+void flushTraceOutput(TraceRuntime& runtime);
+
+// Slots are laid out as [working roots | committed roots | iteration counter | temporaries].
+// Returns the index of the exit taken.
+using TraceEntry = uint32_t (*)(int64_t* slots, TraceRuntime* runtime);
+
+struct TraceExit {
+    uint32_t path;
+    uint32_t instruction;
+    // Guard failures may grow a branch, trapping divisions always return to the interpreter
+    bool isGuard;
+};
+
+// Lowers every path of a trace into one x86-64 loop.
+// Exits leave the working slots as they were at the exiting instruction; root slots are also
+// committed at the end of each iteration, keeping the start of the current iteration.
+class TraceCompiler {
+public:
+    struct LineOffset {
+        size_t offset;
+        SourceLocation sourceLocation;
+    };
+
+    explicit TraceCompiler(const Trace& trace)
+        : _trace(trace) {}
+
+    void compile();
+
+    [[nodiscard]] const std::vector<uint8_t>& getCode() const {
+        return _assembler.getCode();
+    }
+    [[nodiscard]] const std::vector<LineOffset>& getLineOffsets() const {
+        return _lineOffsets;
+    }
+    [[nodiscard]] const std::vector<TraceExit>& getExits() const {
+        return _exits;
+    }
+
+    [[nodiscard]] static size_t getSlotCount(const Trace& trace) {
+        return 2 * trace.rootSlots.size() + 1 + trace.temporaryCount;
+    }
+    [[nodiscard]] static size_t getCommittedIndex(const Trace& trace, uint32_t root) {
+        return trace.rootSlots.size() + root;
+    }
+    [[nodiscard]] static size_t getCounterIndex(const Trace& trace) {
+        return 2 * trace.rootSlots.size();
+    }
+    [[nodiscard]] static size_t getSlotIndex(const Trace& trace, TraceSlot slot) {
+        return slot.isRoot ? slot.index : getCounterIndex(trace) + 1 + slot.index;
+    }
+
+protected:
+    const Trace& _trace;
+    X86Assembler _assembler;
+    std::vector<LineOffset> _lineOffsets;
+    std::vector<TraceExit> _exits;
+    std::vector<X86Assembler::Label> _exitLabels;
+    uint32_t _currentPath{0};
+    uint32_t _currentInstruction{0};
+
+    void compileExpression(const TraceExpression& expression);
+    void normalize(const Type* type);
+    X86Assembler::Label createExit(bool isGuard);
+    [[nodiscard]] int32_t getOffset(size_t index) const;
+    [[nodiscard]] int32_t getOffset(TraceSlot slot) const;
+};
+
+#endif//VUG_TRACECOMPILER_HPP
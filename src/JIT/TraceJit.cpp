@@ -0,0 +1,253 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "TraceJit.hpp"
+
+#include <algorithm>
+#include <format>
+#include <new>
+#include <system_error>
+
+#include "AST/ASTNodes.hpp"
+#include "CodeGen/PerfMap.hpp"
+#include "JIT/TraceRecorder.hpp"
+#include "Misc/SourceManager.hpp"
+#include "Semantic/Symbol.hpp"
+
+std::unique_ptr<Deoptimization> TraceJit::execute(const While& loop, Evaluator::Frame& frame) {
+    auto& state = _loops[&loop];
+    if (state.isBlacklisted) {
+        return nullptr;
+    }
+
+    if (state.trace == nullptr) {
+        if (++state.hotness < hotLoopThreshold) {
+            return nullptr;
+        }
+        state.hotness = 0;
+
+        auto recording = TraceRecorder(loop, frame, {}).record();
+        ++state.recordings;
+        if (recording == nullptr) {
+            state.isBlacklisted = state.recordings >= maxRecordings;
+            return nullptr;
+        }
+
+        state.trace = std::make_unique<Trace>(&loop);
+        state.trace->paths.emplace_back().instructions = std::move(recording->instructions);
+        state.trace->rootSlots = std::move(recording->rootSlots);
+        state.trace->temporaryCount = recording->temporaryCount;
+        state.trace->hasPrints = recording->hasPrints;
+        state.compiled = compile(*state.trace);
+        if (state.compiled == nullptr) {
+            giveUp(state);
+            return nullptr;
+        }
+    }
+
+    auto index = run(state, frame);
+    if (index < 0) {
+        return nullptr;
+    }
+
+    auto exit = state.compiled->exits[index];
+    auto deoptimization = deoptimize(state, exit, frame);
+    if (exit.path == 0 && exit.instruction == 0 && exit.isGuard) {
+        // The loop condition failed, the interpreter leaves the loop
+        return deoptimization;
+    }
+
+    const auto& location = state.trace->paths[exit.path].instructions[exit.instruction].sourceLocation;
+    auto& site = _deoptimizations[{location.getAbsoluteStart(), exit.isGuard}];
+    site.sourceLocation = location;
+    site.isGuard = exit.isGuard;
+    ++site.count;
+
+    ++state.exits;
+    if (exit.isGuard &&
+        ++state.compiled->exitCounts[index] == hotExitThreshold &&
+        state.trace->paths.size() < maxPaths) {
+        growBranch(state, exit, frame);
+    } else if (state.exits >= minExitsToDrop && state.exits * exitRatioToDrop > state.iterations) {
+        discard(state);
+    }
+
+    return deoptimization;
+}
+
+void TraceJit::printDeoptimizations(std::ostream& output) const {
+    std::vector<const DeoptimizationSite*> sites;
+    for (const auto& [key, site]: _deoptimizations) {
+        sites.push_back(&site);
+    }
+    std::stable_sort(sites.begin(), sites.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->count > rhs->count;
+    });
+
+    for (const auto* site: sites) {
+        const auto& location = site->sourceLocation;
+        output << std::format("{}:{}:{}: {} deoptimization(s), {}\n",
+                              location.getSourceFile() != nullptr ? location.getSourceFile()->getName() : "",
+                              location.getStartLine(),
+                              location.getStartColumn(),
+                              site->count,
+                              site->isGuard ? "guard failed" : "division may trap");
+    }
+}
+
+std::unique_ptr<TraceJit::CompiledTrace> TraceJit::compile(const Trace& trace) {
+    auto compiler = TraceCompiler(trace);
+    compiler.compile();
+
+    auto compiled = std::make_unique<CompiledTrace>();
+    try {
+        compiled->memory = std::make_unique<ExecutableMemory>(compiler.getCode());
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    } catch (const std::system_error&) {
+        return nullptr;
+    }
+    compiled->entry = reinterpret_cast<TraceEntry>(const_cast<void*>(compiled->memory->getCode()));
+    compiled->exits = compiler.getExits();
+    compiled->exitCounts.resize(compiled->exits.size());
+
+    if (_perfMap.isEnabled()) {
+        auto code = static_cast<const uint8_t*>(compiled->memory->getCode());
+        std::vector<PerfMap::LineEntry> lines;
+        for (const auto& line: compiler.getLineOffsets()) {
+            lines.emplace_back(code + line.offset, line.sourceLocation);
+        }
+
+        const auto& location = trace.loop->sourceLocation;
+        auto name = std::format("vug-trace:{}:{}",
+                                location.getSourceFile() != nullptr ? location.getSourceFile()->getName() : "",
+                                location.getStartLine());
+        _perfMap.registerCode(code, compiled->memory->getSize(), name, lines);
+    }
+
+    return compiled;
+}
+
+int64_t TraceJit::run(LoopState& state, Evaluator::Frame& frame) {
+    const auto& trace = *state.trace;
+
+    _slots.assign(TraceCompiler::getSlotCount(trace), 0);
+    for (uint32_t root = 0; root < trace.rootSlots.size(); ++root) {
+        const auto& rootSlot = trace.rootSlots[root];
+
+        auto object = frame.find(rootSlot.symbol);
+        if (object == frame.end()) {
+            // Locals declared in the loop body appear after the first interpreted iteration
+            return -1;
+        }
+
+        auto value = unboxValue(*object->second, rootSlot.symbol->getTypeSymbol()->getType());
+        _slots[root] = value;
+        _slots[TraceCompiler::getCommittedIndex(trace, root)] = value;
+    }
+
+    auto exit = state.compiled->entry(_slots.data(), &_runtime);
+    flushTraceOutput(_runtime);
+
+    state.iterations += static_cast<uint64_t>(_slots[TraceCompiler::getCounterIndex(trace)]);
+    return exit;
+}
+
+std::unique_ptr<Deoptimization> TraceJit::deoptimize(const LoopState& state,
+                                                     const TraceExit& exit,
+                                                     Evaluator::Frame& frame) {
+    const auto& trace = *state.trace;
+    const auto& frameState = *trace.paths[exit.path].instructions[exit.instruction].frameState;
+
+    for (uint32_t root = 0; root < trace.rootSlots.size(); ++root) {
+        const auto& rootSlot = trace.rootSlots[root];
+
+        if (rootSlot.isWritten) {
+            frame[rootSlot.symbol] = boxValue(_slots[root], rootSlot.symbol->getTypeSymbol()->getType());
+        }
+    }
+
+    auto deoptimization = std::make_unique<Deoptimization>();
+    for (const auto& level: frameState.levels) {
+        auto& deoptimizationFrame = deoptimization->frames.emplace_back();
+
+        deoptimizationFrame.path = level.path;
+        for (const auto& [symbol, slot]: level.locals) {
+            deoptimizationFrame.locals[symbol] = boxValue(_slots[TraceCompiler::getSlotIndex(trace, slot)],
+                                                          symbol->getTypeSymbol()->getType());
+        }
+        for (const auto& [call, slot]: level.completedCalls) {
+            deoptimizationFrame.completedCalls[call] = boxValue(_slots[TraceCompiler::getSlotIndex(trace, slot)],
+                                                                call->exprType);
+        }
+        deoptimizationFrame.pendingCall = level.pendingCall;
+    }
+
+    return deoptimization;
+}
+
+void TraceJit::growBranch(LoopState& state, const TraceExit& exit, const Evaluator::Frame& frame) {
+    auto& trace = *state.trace;
+
+    // Recording the iteration that failed the guard again from its start
+    // follows the parent path up to that guard and diverges there
+    Evaluator::Frame snapshot;
+    for (const auto& [symbol, object]: frame) {
+        snapshot[symbol] = object->clone();
+    }
+    for (uint32_t root = 0; root < trace.rootSlots.size(); ++root) {
+        const auto& rootSlot = trace.rootSlots[root];
+
+        if (rootSlot.isWritten) {
+            snapshot[rootSlot.symbol] = boxValue(_slots[TraceCompiler::getCommittedIndex(trace, root)],
+                                                 rootSlot.symbol->getTypeSymbol()->getType());
+        }
+    }
+
+    auto position = trace.paths[exit.path].start + exit.instruction;
+    auto recording = TraceRecorder(*trace.loop, snapshot, trace.rootSlots).record();
+    if (recording == nullptr || recording->instructions.size() <= position) {
+        return;
+    }
+
+    const auto& guard = recording->instructions[position];
+    if (guard.kind != TraceInstruction::Kind::Guard ||
+        guard.expected == trace.paths[exit.path].instructions[exit.instruction].expected) {
+        return;
+    }
+
+    auto branch = TracePath();
+    branch.start = position + 1;
+    for (auto index = position + 1; index < recording->instructions.size(); ++index) {
+        branch.instructions.push_back(std::move(recording->instructions[index]));
+    }
+
+    trace.paths[exit.path].branches[exit.instruction] = trace.paths.size();
+    trace.paths.push_back(std::move(branch));
+    trace.rootSlots = std::move(recording->rootSlots);
+    trace.temporaryCount = std::max(trace.temporaryCount, recording->temporaryCount);
+    trace.hasPrints = trace.hasPrints || recording->hasPrints;
+
+    state.compiled = compile(trace);
+    if (state.compiled == nullptr) {
+        giveUp(state);
+        return;
+    }
+    state.iterations = 0;
+    state.exits = 0;
+}
+
+void TraceJit::discard(LoopState& state) {
+    // The recorded paths are not the common ones, record again or give up on the loop
+    state.trace = nullptr;
+    state.compiled = nullptr;
+    state.iterations = 0;
+    state.exits = 0;
+    state.isBlacklisted = state.recordings >= maxRecordings;
+}
+void TraceJit::giveUp(LoopState& state) {
+    // The code of the loop can't be mapped, the interpreter keeps running it
+    state.trace = nullptr;
+    state.compiled = nullptr;
+    state.isBlacklisted = true;
+}
@@ -0,0 +1,84 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_TRACEJIT_HPP
+#define VUG_TRACEJIT_HPP
+
+#include <map>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "Evaluator/Deoptimization.hpp"
+#include "Evaluator/Evaluator.hpp"
+#include "JIT/ExecutableMemory.hpp"
+#include "JIT/Trace.hpp"
+#include "JIT/TraceCompiler.hpp"
+
+class PerfMap;
+
+// Tracing mode of the evaluator.
+// Loops are counted at every iteration; a hot loop records the path of its next iteration,
+// which then runs natively until a guard fails and the interpreter resumes at that guard.
+// Guards that keep failing grow a branch recorded from the failing iteration,
+// so a loop ends up with a tree of paths compiled together.
+class TraceJit {
+public:
+    static constexpr uint32_t hotLoopThreshold = 64;
+    static constexpr uint32_t hotExitThreshold = 8;
+    static constexpr uint32_t maxRecordings = 4;
+    static constexpr size_t maxPaths = 32;
+    // A trace leaving through exits more often than this share of iterations is dropped
+    static constexpr uint64_t minExitsToDrop = 64;
+    static constexpr uint64_t exitRatioToDrop = 4;
+
+    explicit TraceJit(PerfMap& perfMap)
+        : _perfMap(perfMap) {}
+
+    // Called before each evaluation of the loop condition.
+    // Returns where the interpreter continues when the loop ran natively, nullptr otherwise.
+    std::unique_ptr<Deoptimization> execute(const While& loop, Evaluator::Frame& frame);
+
+    // Deoptimizations by source location, most frequent first
+    void printDeoptimizations(std::ostream& output) const;
+
+protected:
+    struct CompiledTrace {
+        std::unique_ptr<ExecutableMemory> memory;
+        TraceEntry entry;
+        std::vector<TraceExit> exits;
+        std::vector<uint32_t> exitCounts;
+    };
+    struct DeoptimizationSite {
+        SourceLocation sourceLocation;
+        bool isGuard;
+        uint64_t count;
+    };
+    struct LoopState {
+        uint32_t hotness{0};
+        uint32_t recordings{0};
+        bool isBlacklisted{false};
+        uint64_t iterations{0};
+        uint64_t exits{0};
+        std::unique_ptr<Trace> trace;
+        std::unique_ptr<CompiledTrace> compiled;
+    };
+
+    PerfMap& _perfMap;
+    TraceRuntime _runtime;
+    std::unordered_map<const While*, LoopState> _loops;
+    std::vector<int64_t> _slots;
+    std::map<std::pair<int64_t, bool>, DeoptimizationSite> _deoptimizations;
+
+    // Returns nullptr when no executable memory can be had for the code
+    std::unique_ptr<CompiledTrace> compile(const Trace& trace);
+    // Returns the index of the exit taken, or -1 when the trace couldn't be entered
+    int64_t run(LoopState& state, Evaluator::Frame& frame);
+    std::unique_ptr<Deoptimization> deoptimize(const LoopState& state, const TraceExit& exit, Evaluator::Frame& frame);
+    void growBranch(LoopState& state, const TraceExit& exit, const Evaluator::Frame& frame);
+    void discard(LoopState& state);
+    void giveUp(LoopState& state);
+};
+
+#endif//VUG_TRACEJIT_HPP
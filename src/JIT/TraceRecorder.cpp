@@ -0,0 +1,444 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "TraceRecorder.hpp"
+
+#include "AST/ASTNodes.hpp"
+#include "Misc/Stack.hpp"
+#include "Semantic/Symbol.hpp"
+#include "Semantic/Type.hpp"
+
+namespace {
+    std::unique_ptr<TraceExpression> makeSlot(TraceSlot slot, const Type* type) {
+        auto expression = std::make_unique<TraceExpression>(TraceExpression::Kind::Slot, type);
+        expression->slot = slot;
+        return expression;
+    }
+
+    bool isIntegerOperation(LexemType operation) {
+        switch (operation) {
+            case LexemType::Equal:
+            case LexemType::Unequal:
+            case LexemType::Less:
+            case LexemType::LessEqual:
+            case LexemType::Greater:
+            case LexemType::GreaterEqual:
+            case LexemType::Plus:
+            case LexemType::Minus:
+            case LexemType::Multiply:
+            case LexemType::Divide:
+            case LexemType::Remainder:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool hasDivision(const TraceExpression& expression) {
+        if (expression.kind == TraceExpression::Kind::BinaryOperation) {
+            return expression.operation == LexemType::Divide ||
+                   expression.operation == LexemType::Remainder ||
+                   hasDivision(*expression.left) ||
+                   hasDivision(*expression.right);
+        }
+        if (expression.kind == TraceExpression::Kind::PrefixOperation) {
+            return hasDivision(*expression.right);
+        }
+        return false;
+    }
+}// namespace
+
+TraceRecorder::TraceRecorder(const While& loop,
+                             const Evaluator::Frame& frame,
+                             std::vector<TraceRootSlot> rootSlots)
+    : _loop(loop),
+      _frame(frame),
+      _recording(std::make_unique<TraceRecording>()) {
+    for (const auto& rootSlot: rootSlots) {
+        auto object = _frame.find(rootSlot.symbol);
+        auto isDefined = object != _frame.end();
+
+        _rootIndices[rootSlot.symbol] = static_cast<uint32_t>(_rootValues.size());
+        _rootValues.push_back(isDefined ? unboxValue(*object->second, rootSlot.symbol->getTypeSymbol()->getType()) : 0);
+        _rootDefined.push_back(isDefined);
+    }
+    _recording->rootSlots = std::move(rootSlots);
+    _levels.emplace_back();
+}
+
+std::unique_ptr<TraceRecording> TraceRecorder::record() {
+    stackGuard();
+
+    try {
+        visit(*_loop.condition);
+        if (_value == 0) {
+            throw TraceAbort("loop exits on this iteration");
+        }
+        emitGuard(_loop.condition->sourceLocation);
+
+        visitStatement(*_loop.body);
+        if (_status != StmtResultKind::Successful) {
+            throw TraceAbort("iteration leaves the loop");
+        }
+    } catch (const TraceAbort& abort) {
+        _abortReason = abort.what();
+        return nullptr;
+    }
+
+    _recording->temporaryCount = static_cast<uint32_t>(_temporaryValues.size());
+    return std::move(_recording);
+}
+
+void TraceRecorder::visit(Node& node) {
+    stackGuard();
+
+    node.accept(*this);
+}
+void TraceRecorder::visitStatement(Statement& node) {
+    stackGuard();
+
+    _levels.back().statements.push_back({&node, {}});
+    node.accept(*this);
+    _levels.back().statements.pop_back();
+}
+
+int64_t& TraceRecorder::valueOf(TraceSlot slot) {
+    return slot.isRoot ? _rootValues[slot.index] : _temporaryValues[slot.index];
+}
+TraceSlot TraceRecorder::allocateTemporary() {
+    _temporaryValues.push_back(0);
+    return {static_cast<uint32_t>(_temporaryValues.size() - 1), false};
+}
+TraceSlot TraceRecorder::getSlot(const LocalVariableSymbol* symbol, bool isWrite) {
+    if (_levels.size() > 1) {
+        auto& slots = _levels.back().temporaries;
+
+        auto found = slots.find(symbol);
+        if (found != slots.end()) {
+            return {found->second, false};
+        }
+        if (!isTraceableType(symbol->getTypeSymbol()->getType())) {
+            throw TraceAbort("local of an untraceable type");
+        }
+        if (!isWrite) {
+            throw TraceAbort("read of an undefined local");
+        }
+
+        auto slot = allocateTemporary();
+        slots[symbol] = slot.index;
+        return slot;
+    }
+
+    auto found = _rootIndices.find(symbol);
+    if (found != _rootIndices.end()) {
+        auto index = found->second;
+        if (isWrite) {
+            _recording->rootSlots[index].isWritten = true;
+            _rootDefined[index] = true;
+        } else if (!_rootDefined[index]) {
+            throw TraceAbort("read of an undefined local");
+        }
+        return {index, true};
+    }
+
+    // Locals of the traced function are loaded from the interpreter frame on entry
+    auto type = symbol->getTypeSymbol()->getType();
+    if (!isTraceableType(type)) {
+        throw TraceAbort("local of an untraceable type");
+    }
+
+    auto object = _frame.find(symbol);
+    auto isDefined = object != _frame.end();
+    if (!isDefined && !isWrite) {
+        throw TraceAbort("read of an undefined local");
+    }
+
+    auto index = static_cast<uint32_t>(_rootValues.size());
+    _rootIndices[symbol] = index;
+    _rootValues.push_back(isDefined ? unboxValue(*object->second, type) : 0);
+    _rootDefined.push_back(true);
+    _recording->rootSlots.push_back({symbol, isWrite});
+    return {index, true};
+}
+void TraceRecorder::emit(TraceInstruction instruction) {
+    if (_recording->instructions.size() >= maxInstructions) {
+        throw TraceAbort("trace is too long");
+    }
+    if (instruction.kind == TraceInstruction::Kind::Guard || hasDivision(*instruction.expression)) {
+        instruction.frameState = captureFrameState();
+    }
+    _recording->instructions.push_back(std::move(instruction));
+}
+void TraceRecorder::emitStore(TraceSlot slot, SourceLocation sourceLocation) {
+    valueOf(slot) = _value;
+
+    auto instruction = TraceInstruction(TraceInstruction::Kind::Store, std::move(_expression), sourceLocation);
+    instruction.slot = slot;
+    emit(std::move(instruction));
+}
+void TraceRecorder::emitGuard(SourceLocation sourceLocation) {
+    auto instruction = TraceInstruction(TraceInstruction::Kind::Guard, std::move(_expression), sourceLocation);
+    instruction.expected = _value != 0;
+    emit(std::move(instruction));
+}
+
+std::unique_ptr<FrameState> TraceRecorder::captureFrameState() const {
+    auto frameState = std::make_unique<FrameState>();
+
+    for (size_t index = 0; index < _levels.size(); ++index) {
+        const auto& level = _levels[index];
+        auto& state = frameState->levels.emplace_back();
+
+        for (const auto& statement: level.statements) {
+            state.path.push_back(statement.statement);
+        }
+        if (!level.statements.empty()) {
+            state.completedCalls = level.statements.back().completedCalls;
+        } else if (index == 0) {
+            state.completedCalls = _conditionCalls;
+        }
+        for (const auto& [symbol, slot]: level.temporaries) {
+            state.locals.emplace_back(static_cast<const LocalVariableSymbol*>(symbol), TraceSlot{slot, false});
+        }
+        state.pendingCall = level.pendingCall;
+    }
+
+    return frameState;
+}
+
+void TraceRecorder::visit(CallFunction& node) {
+    stackGuard();
+
+    if (_levels.size() > maxInlineDepth) {
+        throw TraceAbort("inlining is too deep");
+    }
+
+    std::vector<std::pair<int64_t, std::unique_ptr<TraceExpression>>> arguments;
+    for (const auto& argument: node.arguments) {
+        visit(*argument);
+        arguments.emplace_back(_value, std::move(_expression));
+    }
+
+    // Parameters are stored by the caller, an exit there re-evaluates the call
+    auto callee = RecordingLevel();
+    const auto& parameters = node.symbolRef->getArguments();
+    for (size_t index = 0; index < parameters.size(); ++index) {
+        if (!isTraceableType(parameters[index]->getTypeSymbol()->getType())) {
+            throw TraceAbort("local of an untraceable type");
+        }
+
+        auto slot = allocateTemporary();
+        callee.temporaries[parameters[index]] = slot.index;
+        _value = arguments[index].first;
+        _expression = std::move(arguments[index].second);
+        emitStore(slot, node.arguments[index]->sourceLocation);
+    }
+
+    _levels.back().pendingCall = &node;
+    _levels.push_back(std::move(callee));
+
+    visitStatement(*node.symbolRef->getDefinition());
+    if (_status != StmtResultKind::Return) {
+        throw TraceAbort("function ends without return");
+    }
+    _status = StmtResultKind::Successful;
+
+    _levels.pop_back();
+    _levels.back().pendingCall = nullptr;
+
+    auto& caller = _levels.back();
+    auto& completedCalls = caller.statements.empty() ? _conditionCalls : caller.statements.back().completedCalls;
+    completedCalls.emplace_back(&node, _returnSlot);
+
+    _expression = makeSlot(_returnSlot, node.exprType);
+}
+void TraceRecorder::visit(Number& node) {
+    stackGuard();
+
+    _value = std::stoi(std::string(node.number));
+    _expression = std::make_unique<TraceExpression>(TraceExpression::Kind::Constant, node.exprType);
+    _expression->constant = _value;
+}
+void TraceRecorder::visit(Identifier& node) {
+    stackGuard();
+
+    auto slot = getSlot(node.symbolRef, false);
+    _value = valueOf(slot);
+    _expression = makeSlot(slot, node.exprType);
+}
+void TraceRecorder::visit(BinaryOperation& node) {
+    stackGuard();
+
+    visit(*node.left);
+    auto left = _value;
+    auto leftExpression = std::move(_expression);
+    visit(*node.right);
+    auto right = _value;
+
+    // Mirror what the runtime objects support, anything else must fail in the interpreter
+    auto operation = node.operationToken;
+    if (node.left->exprType->isInteger() ? !isIntegerOperation(operation)
+                                         : operation != LexemType::LogicAnd && operation != LexemType::LogicOr) {
+        throw TraceAbort("operation unsupported by the evaluator");
+    }
+
+    int64_t result;
+    switch (operation) {
+        case LexemType::Equal:
+            result = left == right;
+            break;
+        case LexemType::Unequal:
+            result = left != right;
+            break;
+        case LexemType::Less:
+            result = left < right;
+            break;
+        case LexemType::LessEqual:
+            result = left <= right;
+            break;
+        case LexemType::Greater:
+            result = left > right;
+            break;
+        case LexemType::GreaterEqual:
+            result = left >= right;
+            break;
+        case LexemType::Plus:
+            result = left + right;
+            break;
+        case LexemType::Minus:
+            result = left - right;
+            break;
+        case LexemType::Multiply:
+            result = left * right;
+            break;
+        case LexemType::Divide:
+        case LexemType::Remainder:
+            // Zero divisors and the minimum divided by -1 trap
+            if (right == 0 || (right == -1 && left != 0 && normalizeValue(-left, node.exprType) == left)) {
+                throw TraceAbort("division traps");
+            }
+            result = operation == LexemType::Divide ? left / right : left % right;
+            break;
+        case LexemType::LogicAnd:
+            result = left && right;
+            break;
+        case LexemType::LogicOr:
+            result = left || right;
+            break;
+        default:
+            throw std::logic_error("Unsupported operation");
+    }
+
+    _value = normalizeValue(result, node.exprType);
+    auto expression = std::make_unique<TraceExpression>(TraceExpression::Kind::BinaryOperation, node.exprType);
+    expression->operation = operation;
+    expression->isLeftNonNegative = node.isLeftNonNegative;
+    expression->left = std::move(leftExpression);
+    expression->right = std::move(_expression);
+    _expression = std::move(expression);
+}
+void TraceRecorder::visit(PrefixOperation& node) {
+    stackGuard();
+
+    visit(*node.right);
+
+    auto operation = node.operationType;
+    if (operation == LexemType::Minus && node.right->exprType->isInteger()) {
+        _value = normalizeValue(-_value, node.exprType);
+    } else if (operation == LexemType::Not && !node.right->exprType->isInteger()) {
+        _value = !_value;
+    } else {
+        throw TraceAbort("operation unsupported by the evaluator");
+    }
+
+    auto expression = std::make_unique<TraceExpression>(TraceExpression::Kind::PrefixOperation, node.exprType);
+    expression->operation = operation;
+    expression->right = std::move(_expression);
+    _expression = std::move(expression);
+}
+
+void TraceRecorder::visit(Assign& node) {
+    stackGuard();
+
+    visit(*node.value);
+    emitStore(getSlot(node.symbolRef, true), node.sourceLocation);
+}
+void TraceRecorder::visit(LocalVariableDeclaration& node) {
+    stackGuard();
+
+    visit(*node.value);
+    emitStore(getSlot(node.symbolRef, true), node.sourceLocation);
+}
+void TraceRecorder::visit(StatementsBlock& node) {
+    stackGuard();
+
+    for (const auto& stmt: node.statements) {
+        visitStatement(*stmt);
+        if (_status != StmtResultKind::Successful) {
+            return;
+        }
+    }
+}
+void TraceRecorder::visit(Break& node) {
+    stackGuard();
+
+    if (node.breakedStmt == &_loop) {
+        throw TraceAbort("iteration leaves the loop");
+    }
+    _status = StmtResultKind::Break;
+    _breakTarget = node.breakedStmt;
+}
+void TraceRecorder::visit(If& node) {
+    stackGuard();
+
+    visit(*node.condition);
+    auto taken = _value != 0;
+    emitGuard(node.condition->sourceLocation);
+
+    if (taken) {
+        visitStatement(*node.then);
+    } else if (node.elseThen != nullptr) {
+        visitStatement(*node.elseThen);
+    }
+}
+void TraceRecorder::visit(While& node) {
+    stackGuard();
+
+    // Inner loops are unrolled for as many iterations as they run now
+    while (true) {
+        visit(*node.condition);
+        auto taken = _value != 0;
+        emitGuard(node.condition->sourceLocation);
+        if (!taken) {
+            return;
+        }
+
+        visitStatement(*node.body);
+        if (_status == StmtResultKind::Break && _breakTarget == &node) {
+            _status = StmtResultKind::Successful;
+            return;
+        }
+        if (_status != StmtResultKind::Successful) {
+            return;
+        }
+    }
+}
+void TraceRecorder::visit(Print& node) {
+    stackGuard();
+
+    visit(*node.expression);
+    emit(TraceInstruction(TraceInstruction::Kind::Print, std::move(_expression), node.sourceLocation));
+    _recording->hasPrints = true;
+}
+void TraceRecorder::visit(Return& node) {
+    stackGuard();
+
+    if (_levels.size() == 1) {
+        throw TraceAbort("iteration returns from the traced function");
+    }
+
+    visit(*node.returnExpression);
+    _returnSlot = allocateTemporary();
+    emitStore(_returnSlot, node.sourceLocation);
+    _status = StmtResultKind::Return;
+}
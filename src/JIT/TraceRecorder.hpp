@@ -0,0 +1,117 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_TRACERECORDER_HPP
+#define VUG_TRACERECORDER_HPP
+
+#include <exception>
+#include <unordered_map>
+#include <vector>
+
+#include "AST/ASTWalker.hpp"
+#include "Evaluator/Evaluator.hpp"
+#include "JIT/Trace.hpp"
+
+class TraceAbort : public std::exception {
+public:
+    explicit TraceAbort(const char* reason)
+        : _reason(reason) {}
+
+    [[nodiscard]] const char* what() const noexcept override {
+        return _reason;
+    }
+
+protected:
+    const char* _reason;
+};
+
+struct TraceRecording {
+    std::vector<TraceInstruction> instructions;
+    std::vector<TraceRootSlot> rootSlots;
+    uint32_t temporaryCount{0};
+    bool hasPrints{false};
+};
+
+// Records the path one iteration of a loop takes.
+// The iteration is dry-run on a snapshot of the frame: If branches become guards,
+// called functions are inlined into fresh slots, nothing is printed or written back.
+// Recording the same state twice yields the same instructions and slots.
+class TraceRecorder : public ASTWalker {
+public:
+    static constexpr size_t maxInstructions = 4096;
+    static constexpr size_t maxInlineDepth = 32;
+
+    // `rootSlots` keeps the root slots a trace of this loop already assigned
+    TraceRecorder(const While& loop,
+                  const Evaluator::Frame& frame,
+                  std::vector<TraceRootSlot> rootSlots);
+
+    // Returns nullptr when the iteration leaves the traceable subset
+    std::unique_ptr<TraceRecording> record();
+
+    [[nodiscard]] const char* getAbortReason() const {
+        return _abortReason;
+    }
+
+    void visit(CallFunction& node) override;
+    void visit(Number& node) override;
+    void visit(Identifier& node) override;
+    void visit(BinaryOperation& node) override;
+    void visit(PrefixOperation& node) override;
+
+    void visit(Assign& node) override;
+    void visit(LocalVariableDeclaration& node) override;
+    void visit(StatementsBlock& node) override;
+    void visit(Break& node) override;
+    void visit(If& node) override;
+    void visit(While& node) override;
+    void visit(Print& node) override;
+    void visit(Return& node) override;
+
+protected:
+    const While& _loop;
+    const Evaluator::Frame& _frame;
+    std::unique_ptr<TraceRecording> _recording;
+    const char* _abortReason{nullptr};
+
+    struct RecordingStatement {
+        Statement* statement;
+        std::vector<std::pair<const CallFunction*, TraceSlot>> completedCalls;
+    };
+    // The traced function, then every inlined call, innermost last
+    struct RecordingLevel {
+        std::unordered_map<const Symbol*, uint32_t> temporaries;
+        std::vector<RecordingStatement> statements;
+        const CallFunction* pendingCall{nullptr};
+    };
+
+    std::unordered_map<const Symbol*, uint32_t> _rootIndices;
+    std::vector<int64_t> _rootValues;
+    std::vector<bool> _rootDefined;
+    std::vector<RecordingLevel> _levels;
+    // Calls made by the loop condition, which is outside of any statement
+    std::vector<std::pair<const CallFunction*, TraceSlot>> _conditionCalls;
+    std::vector<int64_t> _temporaryValues;
+    TraceSlot _returnSlot{0, false};
+
+    // Result of the last visited expression
+    int64_t _value{0};
+    std::unique_ptr<TraceExpression> _expression;
+
+    // Outcome of the last visited statement
+    StmtResultKind _status{StmtResultKind::Successful};
+    const Statement* _breakTarget{nullptr};
+
+    void visit(Node& node) override;
+    void visitStatement(Statement& node);
+
+    int64_t& valueOf(TraceSlot slot);
+    TraceSlot allocateTemporary();
+    TraceSlot getSlot(const LocalVariableSymbol* symbol, bool isWrite);
+    void emit(TraceInstruction instruction);
+    void emitStore(TraceSlot slot, SourceLocation sourceLocation);
+    void emitGuard(SourceLocation sourceLocation);
+    std::unique_ptr<FrameState> captureFrameState() const;
+};
+
+#endif//VUG_TRACERECORDER_HPP
@@ -0,0 +1,127 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_CHARACTERSCAN_HPP
+#define VUG_CHARACTERSCAN_HPP
+
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Classes of characters the lexer skips runs of. Each tests one character and, for the instruction
+// set the compiler targets, a whole block, setting every byte of the result that belongs to the class.
+struct WhitespaceCharacters {
+    static bool contains(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+#if defined(__AVX2__)
+    static __m256i contains(__m256i block) {
+        return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+                                               _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t'))),
+                               _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r')),
+                                               _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'))));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    static __m128i contains(__m128i block) {
+        return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+                                         _mm_cmpeq_epi8(block, _mm_set1_epi8('\t'))),
+                            _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\r')),
+                                         _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))));
+    }
+#endif
+};
+
+struct DigitCharacters {
+    static bool contains(char c) {
+        return static_cast<uint8_t>(c - '0') <= 9;
+    }
+#if defined(__AVX2__)
+    static __m256i contains(__m256i block) {
+        auto offset = _mm256_sub_epi8(block, _mm256_set1_epi8('0'));
+        return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(9)), offset);
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    static __m128i contains(__m128i block) {
+        auto offset = _mm_sub_epi8(block, _mm_set1_epi8('0'));
+        return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(9)), offset);
+    }
+#endif
+};
+
+// ASCII letters and digits, as isalpha and isdigit in the "C" locale
+struct AlphanumericCharacters {
+    static bool contains(char c) {
+        return static_cast<uint8_t>((c | 0x20) - 'a') <= 'z' - 'a' || DigitCharacters::contains(c);
+    }
+#if defined(__AVX2__)
+    static __m256i contains(__m256i block) {
+        // Setting bit 5 lowercases letters and maps nothing else onto them
+        auto offset = _mm256_sub_epi8(_mm256_or_si256(block, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+        auto letters = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8('z' - 'a')), offset);
+        return _mm256_or_si256(letters, DigitCharacters::contains(block));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    static __m128i contains(__m128i block) {
+        // Setting bit 5 lowercases letters and maps nothing else onto them
+        auto offset = _mm_sub_epi8(_mm_or_si128(block, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        auto letters = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8('z' - 'a')), offset);
+        return _mm_or_si128(letters, DigitCharacters::contains(block));
+    }
+#endif
+};
+
+// Everything up to the closing quote, or a '\0' the lexer rejects
+struct StringCharacters {
+    static bool contains(char c) {
+        return c != '"' && c != '\0';
+    }
+#if defined(__AVX2__)
+    static __m256i contains(__m256i block) {
+        auto end = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('"')),
+                                   _mm256_cmpeq_epi8(block, _mm256_setzero_si256()));
+        return _mm256_andnot_si256(end, _mm256_set1_epi8(-1));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    static __m128i contains(__m128i block) {
+        auto end = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('"')),
+                                _mm_cmpeq_epi8(block, _mm_setzero_si128()));
+        return _mm_andnot_si128(end, _mm_set1_epi8(-1));
+    }
+#endif
+};
+
+// Position of the first character from `position` on that isn't in the class, or the size of the text
+template<typename Class>
+size_t skipCharacters(std::string_view text, size_t position) {
+#if defined(__AVX2__)
+    while (position + 32 <= text.size()) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + position));
+        auto outside = ~static_cast<uint32_t>(_mm256_movemask_epi8(Class::contains(block)));
+        if (outside != 0) {
+            return position + std::countr_zero(outside);
+        }
+        position += 32;
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    while (position + 16 <= text.size()) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + position));
+        auto outside = ~static_cast<uint32_t>(_mm_movemask_epi8(Class::contains(block))) & 0xFFFF;
+        if (outside != 0) {
+            return position + std::countr_zero(outside);
+        }
+        position += 16;
+    }
+#endif
+    while (position < text.size() && Class::contains(text[position])) {
+        ++position;
+    }
+    return position;
+}
+
+#endif//VUG_CHARACTERSCAN_HPP
@@ -0,0 +1,78 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_KEYWORDS_HPP
+#define VUG_KEYWORDS_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "Lexing/Token.hpp"
+
+struct Keyword {
+    std::string_view spelling;
+    LexemType type{LexemType::Identifier};
+};
+
+inline constexpr std::array<Keyword, 8> keywords = {{
+        {"mod", LexemType::Mod},
+        {"func", LexemType::Func},
+        {"var", LexemType::Var},
+        {"if", LexemType::If},
+        {"else", LexemType::Else},
+        {"while", LexemType::While},
+        {"break", LexemType::Break},
+        {"return", LexemType::Return},
+}};
+
+// Keywords are found by a perfect hash of the length and the first and last characters, the last one
+// scaled by the smallest multiplier under which no two keywords share a slot
+constexpr size_t keywordTableSize = 16;
+
+constexpr size_t hashKeyword(std::string_view text, size_t multiplier) {
+    return (text.size() + static_cast<uint8_t>(text.front()) + static_cast<uint8_t>(text.back()) * multiplier) %
+           keywordTableSize;
+}
+
+consteval size_t findKeywordMultiplier() {
+    for (size_t multiplier = 1; multiplier < 256; ++multiplier) {
+        std::array<bool, keywordTableSize> isUsed{};
+        bool isPerfect = true;
+        for (const auto& keyword: keywords) {
+            auto slot = hashKeyword(keyword.spelling, multiplier);
+            isPerfect = isPerfect && !isUsed[slot];
+            isUsed[slot] = true;
+        }
+        if (isPerfect) {
+            return multiplier;
+        }
+    }
+    return 0;
+}
+
+inline constexpr size_t keywordMultiplier = findKeywordMultiplier();
+static_assert(keywordMultiplier != 0, "no perfect hash of the keywords, grow keywordTableSize");
+
+// Each keyword in its slot, the other slots have empty spellings
+inline constexpr auto keywordTable = [] {
+    std::array<Keyword, keywordTableSize> table{};
+    for (const auto& keyword: keywords) {
+        table[hashKeyword(keyword.spelling, keywordMultiplier)] = keyword;
+    }
+    return table;
+}();
+
+constexpr std::optional<LexemType> findKeyword(std::string_view text) {
+    if (text.empty()) {
+        return std::nullopt;
+    }
+    const auto& keyword = keywordTable[hashKeyword(text, keywordMultiplier)];
+    if (keyword.spelling != text) {
+        return std::nullopt;
+    }
+    return keyword.type;
+}
+
+#endif//VUG_KEYWORDS_HPP
@@ -3,141 +3,177 @@
 
 #include "Lexer.hpp"
 #include "Token.hpp"
+#include "Lexing/CharacterScan.hpp"
+#include "Lexing/Keywords.hpp"
+#include <cstring>
+#include <exception>
 #include <stdexcept>
+#include <thread>
 
-Token Lexer::getToken() {
-    while (true) {
-        auto c = peek();
+namespace {
+// Starts of up to `count` chunks of about equal size, each chunk but the first starting after a '\n'
+// outside of strings. Strings have no escapes, so every quote opens or closes one.
+std::vector<size_t> findChunkStarts(std::string_view text, size_t count) {
+    std::vector<size_t> starts{0};
+    size_t position = 0;
+    bool isInString = false;
 
-        switch (c) {
-            case '(':
-                return {LexemType::LeftRoundBracket,
-                        SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-            case ')':
-                return {LexemType::RightRoundBracket,
-                        SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-            case '{':
-                return {LexemType::LeftCurlyBracket,
-                        SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-            case '}':
-                return {LexemType::RightCurlyBracket,
-                        SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-            case '+':
-                return {LexemType::Plus,
-                        SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-            case '-':
-                if (peek() == '>') {
-                    return {LexemType::Arrow,
-                            SourceLocation(&_source, getPrevPos() - 1, getPrevPos(), _line, _line, _column - 1, _column)};
-                } else {
-                    --_pos;
-                    --_column;
-                    return {LexemType::Minus,
-                            SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-                }
-            case '*':
-                return {LexemType::Multiply,
-                        SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-            case '/':
-                return {LexemType::Divide,
-                        SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-            case '%':
-                return {LexemType::Remainder,
-                        SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-            case '!':
-                if (peek() == '=') {
-                    return {LexemType::Unequal,
-                            SourceLocation(&_source, getPrevPos() - 1, getPrevPos(), _line, _line, _column - 1, _column)};
-                } else {
-                    --_pos;
-                    --_column;
-                    return {LexemType::Not,
-                            SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-                }
-            case '|':
-                if (peek() == '|') {
-                    return {LexemType::LogicOr,
-                            SourceLocation(&_source, getPrevPos() - 1, getPrevPos(), _line, _line, _column - 1, _column)};
-                } else {
-                    --_pos;
-                    --_column;
-                    return {LexemType::BitOr,
-                            SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-                }
-            case '&':
-                if (peek() == '&') {
-                    return {LexemType::LogicAnd,
-                            SourceLocation(&_source, getPrevPos() - 1, getPrevPos(), _line, _line, _column - 1, _column)};
-                } else {
-                    --_pos;
-                    --_column;
-                    return {LexemType::BitAnd,
-                            SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-                }
-            case '^':
-                return {LexemType::BitXor,
-                        SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-            case '<':
-                if (peek() == '=') {
-                    return {LexemType::LessEqual,
-                            SourceLocation(&_source, getPrevPos() - 1, getPrevPos(), _line, _line, _column - 1, _column)};
-                } else {
-                    --_pos;
-                    --_column;
-                    return {LexemType::Less,
-                            SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-                }
-            case '>':
-                if (peek() == '=') {
-                    return {LexemType::GreaterEqual,
-                            SourceLocation(&_source, getPrevPos() - 1, getPrevPos(), _line, _line, _column - 1, _column)};
-                } else {
-                    --_pos;
-                    --_column;
-                    return {LexemType::Greater,
-                            SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-                }
-            case '=':
-                if (peek() == '=') {
-                    return {LexemType::Equal,
-                            SourceLocation(&_source, getPrevPos() - 1, getPrevPos(), _line, _line, _column - 1, _column)};
-                } else {
-                    --_pos;
-                    --_column;
-                    return {LexemType::Assign,
-                            SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
+    for (size_t chunk = 1; chunk < count; ++chunk) {
+        auto target = text.size() / count * chunk;
+        if (target < position) {
+            continue;
+        }
+        for (auto quote = text.substr(0, target).find('"', position);
+             quote != std::string_view::npos;
+             quote = text.substr(0, target).find('"', quote + 1)) {
+            isInString = !isInString;
+        }
+        position = target;
+
+        while (true) {
+            if (isInString) {
+                auto quote = text.find('"', position);
+                if (quote == std::string_view::npos) {
+                    return starts;
                 }
-            case ',':
-                return {LexemType::Comma,
-                        SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-            case ';':
-                return {LexemType::Semicolon,
-                        SourceLocation(&_source, getPrevPos(), getPrevPos(), _line, _line, _column, _column)};
-            case '"':
-                return getString();
+                isInString = false;
+                position = quote + 1;
+            }
 
-            case ' ':
-            case '\r':
-                break;
-            case '\t':
-                _column += 4;
-                break;
-            case '\n':
-                _column = 0;
-                ++_line;
-                break;
+            auto end = text.find_first_of("\"\n", position);
+            if (end == std::string_view::npos) {
+                return starts;
+            }
+            position = end + 1;
+            if (text[end] == '"') {
+                isInString = true;
+                continue;
+            }
+            if (position < text.size()) {
+                starts.push_back(position);
+            }
+            break;
+        }
+    }
+    return starts;
+}
+}// namespace
 
-            case '\0':
-                return {LexemType::EndOfFile,
-                        SourceLocation()};
+Token Lexer::getToken() {
+    _pos = static_cast<int64_t>(skipCharacters<WhitespaceCharacters>(_text, _pos));
 
-            default:
-                if (c >= '0' && c <= '9') {
-                    return getNumber(c);
-                } else {
-                    return getIdentifier(c);
-                }
-        }
+    auto c = peek();
+
+    switch (c) {
+        case '(':
+            return {LexemType::LeftRoundBracket,
+                    getLocation(getPrevPos(), 1)};
+        case ')':
+            return {LexemType::RightRoundBracket,
+                    getLocation(getPrevPos(), 1)};
+        case '{':
+            return {LexemType::LeftCurlyBracket,
+                    getLocation(getPrevPos(), 1)};
+        case '}':
+            return {LexemType::RightCurlyBracket,
+                    getLocation(getPrevPos(), 1)};
+        case '+':
+            return {LexemType::Plus,
+                    getLocation(getPrevPos(), 1)};
+        case '-':
+            if (peek() == '>') {
+                return {LexemType::Arrow,
+                        getLocation(getPrevPos() - 1, 2)};
+            } else {
+                --_pos;
+                return {LexemType::Minus,
+                        getLocation(getPrevPos(), 1)};
+            }
+        case '*':
+            return {LexemType::Multiply,
+                    getLocation(getPrevPos(), 1)};
+        case '/':
+            return {LexemType::Divide,
+                    getLocation(getPrevPos(), 1)};
+        case '%':
+            return {LexemType::Remainder,
+                    getLocation(getPrevPos(), 1)};
+        case '!':
+            if (peek() == '=') {
+                return {LexemType::Unequal,
+                        getLocation(getPrevPos() - 1, 2)};
+            } else {
+                --_pos;
+                return {LexemType::Not,
+                        getLocation(getPrevPos(), 1)};
+            }
+        case '|':
+            if (peek() == '|') {
+                return {LexemType::LogicOr,
+                        getLocation(getPrevPos() - 1, 2)};
+            } else {
+                --_pos;
+                return {LexemType::BitOr,
+                        getLocation(getPrevPos(), 1)};
+            }
+        case '&':
+            if (peek() == '&') {
+                return {LexemType::LogicAnd,
+                        getLocation(getPrevPos() - 1, 2)};
+            } else {
+                --_pos;
+                return {LexemType::BitAnd,
+                        getLocation(getPrevPos(), 1)};
+            }
+        case '^':
+            return {LexemType::BitXor,
+                    getLocation(getPrevPos(), 1)};
+        case '<':
+            if (peek() == '=') {
+                return {LexemType::LessEqual,
+                        getLocation(getPrevPos() - 1, 2)};
+            } else {
+                --_pos;
+                return {LexemType::Less,
+                        getLocation(getPrevPos(), 1)};
+            }
+        case '>':
+            if (peek() == '=') {
+                return {LexemType::GreaterEqual,
+                        getLocation(getPrevPos() - 1, 2)};
+            } else {
+                --_pos;
+                return {LexemType::Greater,
+                        getLocation(getPrevPos(), 1)};
+            }
+        case '=':
+            if (peek() == '=') {
+                return {LexemType::Equal,
+                        getLocation(getPrevPos() - 1, 2)};
+            } else {
+                --_pos;
+                return {LexemType::Assign,
+                        getLocation(getPrevPos(), 1)};
+            }
+        case ',':
+            return {LexemType::Comma,
+                    getLocation(getPrevPos(), 1)};
+        case ';':
+            return {LexemType::Semicolon,
+                    getLocation(getPrevPos(), 1)};
+        case '"':
+            return getString();
+
+        case '\0':
+            return {LexemType::EndOfFile,
+                    SourceLocation()};
+
+        default:
+            if (c >= '0' && c <= '9') {
+                return getNumber();
+            } else {
+                return getIdentifier();
+            }
     }
 }
 void Lexer::getTokens(std::vector<Token>& tokens) {
@@ -147,111 +183,109 @@ void Lexer::getTokens(std::vector<Token>& tokens) {
         tokens.emplace_back(token);
 
         if (token.getType() == LexemType::EndOfFile) {
-            _pos = 0;
-            _line = 1;
-            _column = 0;
             return;
         }
     }
 }
-void Lexer::revertTo(const Token& token) {
-    _pos = token.getSourceLocation().getAbsoluteEnd() + 1;
-    _line = token.getSourceLocation().getEndLine();
-    _column = token.getSourceLocation().getEndColumn();
-}
-Token Lexer::getString() {
-    std::string string;
+void Lexer::getTokens(TokenQueue& queue, size_t batchSize) {
+    std::vector<Token> batch;
+    batch.reserve(batchSize);
+    try {
+        while (true) {
+            auto token = getToken();
 
-    auto startPos = getPrevPos();
-    auto startLine = _line;
-    auto startColumn = _column;
+            batch.emplace_back(token);
 
-    while (true) {
-        char c = peek();
-
-        if (c == '\0') {
-            throw std::logic_error("Bad lexing");
-        }
-        if (c == '\r') {
-            continue;
-        }
-        if (c == '\n') {
-            _column = 0;
-            ++_line;
-        }
-
-        if (c == '"') {
-            break;
+            if (token.getType() == LexemType::EndOfFile) {
+                break;
+            }
+            if (batch.size() == batchSize) {
+                queue.push(std::move(batch));
+                batch = std::vector<Token>();
+                batch.reserve(batchSize);
+            }
         }
-
-        string.push_back(c);
+    } catch (...) {
+        batch.emplace_back(LexemType::EndOfFile, SourceLocation());
+        queue.push(std::move(batch));
+        queue.close();
+        throw;
     }
-    return {LexemType::String,
-            SourceLocation(&_source, startPos, getPrevPos(),
-                           startLine, getPrevPos(),
-                           startColumn, getPrevPos()),
-            std::move(string)};
+    queue.push(std::move(batch));
+    queue.close();
 }
-Token Lexer::getIdentifier(char firstChar) {
-    auto startPos = getPrevPos();
-    auto startLine = _line;
-    auto startColumn = _column;
+void Lexer::getTokensInParallel(const SourceFile& source, std::vector<Token>& tokens, size_t threadCount) {
+    auto text = source.getText();
+    auto chunkCount = std::min(threadCount, text.size() / minimalChunkSize);
+    // A '\0' ends the file for the lexer, so only lexing from the start knows where the tokens end
+    if (chunkCount <= 1 || std::memchr(text.data(), '\0', text.size()) != nullptr) {
+        Lexer(source).getTokens(tokens);
+        return;
+    }
 
-    std::string string;
-    string.push_back(firstChar);
+    auto starts = findChunkStarts(text, chunkCount);
+    starts.push_back(text.size());
 
-    while (true) {
-        char c = peek();
-
-        if (!isalpha(c) && !isdigit(c)) {
-            _pos--;
-            _column--;
-            break;
+    std::vector<std::vector<Token>> chunks(starts.size() - 1);
+    std::vector<std::exception_ptr> exceptions(chunks.size());
+    auto lexChunk = [&](size_t index) {
+        try {
+            auto lexer = Lexer(source, starts[index], starts[index + 1]);
+            lexer.getTokens(chunks[index]);
+            chunks[index].pop_back();
+        } catch (...) {
+            exceptions[index] = std::current_exception();
         }
+    };
 
-        string.push_back(c);
+    std::vector<std::thread> threads;
+    for (size_t index = 1; index < chunks.size(); ++index) {
+        threads.emplace_back(lexChunk, index);
+    }
+    lexChunk(0);
+    for (auto& thread: threads) {
+        thread.join();
     }
 
-    auto keyword = _keywords.find(string);
-
-    if (keyword != _keywords.end()) {
-        return {
-                keyword->second,
-                SourceLocation(&_source, startPos, getPrevPos(),
-                               startLine, _line,
-                               startColumn, _column),
-        };
-    } else {
-        return {LexemType::Identifier,
-                SourceLocation(&_source, startPos, getPrevPos(),
-                               startLine, _line,
-                               startColumn, _column),
-                std::move(string)};
+    size_t size = 1;
+    for (size_t index = 0; index < chunks.size(); ++index) {
+        // The first error in the file is the one lexing from the start throws
+        if (exceptions[index] != nullptr) {
+            std::rethrow_exception(exceptions[index]);
+        }
+        size += chunks[index].size();
+    }
+    tokens.reserve(tokens.size() + size);
+    for (const auto& chunk: chunks) {
+        tokens.insert(tokens.end(), chunk.begin(), chunk.end());
     }
+    tokens.emplace_back(LexemType::EndOfFile, SourceLocation());
 }
-Token Lexer::getNumber(char firstChar) {
-    std::string string;
-    string.push_back(firstChar);
-
-    auto startPos = getPrevPos();
-    auto startLine = _line;
-    auto startColumn = _column;
+Token Lexer::getString() {
+    auto start = getPrevPos();
 
-    while (true) {
-        char c = peek();
+    _pos = static_cast<int64_t>(skipCharacters<StringCharacters>(_text, _pos));
+    if (peek() != '"') {
+        throw std::logic_error("Bad lexing");
+    }
+    return {LexemType::String, getLocation(start, _pos - start)};
+}
+Token Lexer::getIdentifier() {
+    auto start = getPrevPos();
+    _pos = static_cast<int64_t>(skipCharacters<AlphanumericCharacters>(_text, _pos));
 
-        if (!isdigit(c)) {
-            _pos--;
-            _column--;
-            break;
-        }
+    auto location = getLocation(start, _pos - start);
+    auto keyword = findKeyword(location.getText());
 
-        string.push_back(c);
+    if (keyword.has_value()) {
+        return {*keyword, location};
+    } else {
+        return {LexemType::Identifier, location};
     }
+}
+Token Lexer::getNumber() {
+    auto start = getPrevPos();
+    _pos = static_cast<int64_t>(skipCharacters<DigitCharacters>(_text, _pos));
 
-    return {LexemType::Number,
-            SourceLocation(&_source, startPos, getPrevPos(),
-                           startLine, _line,
-                           startColumn, _column),
-            std::move(string)};
+    return {LexemType::Number, getLocation(start, _pos - start)};
 }
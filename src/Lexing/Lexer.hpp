@@ -6,63 +6,72 @@
 
 #include <cctype>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
 #include "Diagnostic/Logger.hpp"
+#include "Misc/SingleProducerQueue.hpp"
 #include "Misc/SourceManager.hpp"
 #include "Token.hpp"
 
+// Tokens passed from a lexing thread to a parsing one, a batch at a time
+using TokenQueue = SingleProducerQueue<std::vector<Token>>;
+
 class Lexer {
 public:
-    explicit Lexer(const SourceFile& source) : _keywords({
-                                                       {"mod", LexemType::Mod},
-                                                       {"func", LexemType::Func},
-                                                       {"var", LexemType::Var},
-                                                       {"if", LexemType::If},
-                                                       {"else", LexemType::Else},
-                                                       {"while", LexemType::While},
-                                                       {"break", LexemType::Break},
-                                                       {"return", LexemType::Return},
-                                               }),
-                                               _source(source) {}
-
-    bool match(const Token& token) {
-        return getToken() == token;
-    }
+    // Smallest part of a file lexed on its own thread
+    static constexpr size_t minimalChunkSize = 1 << 20;
+    // Tokens pushed to a queue at once, a few pages of them
+    static constexpr size_t queueBatchSize = 1 << 12;
+
+    explicit Lexer(const SourceFile& source) : _text(source.getText()), _source(source) {}
+    // Lexes the characters from `begin` to `end` as if they were the whole file
+    Lexer(const SourceFile& source, size_t begin, size_t end)
+        : _pos(static_cast<int64_t>(begin)),
+          _text(source.getText().substr(0, end)),
+          _source(source) {}
 
     Token getToken();
+    // Appends the rest of the file, up to and including EndOfFile
     void getTokens(std::vector<Token>& tokens);
+    // Pushes the rest of the file in batches of `batchSize` tokens, the last one ending with EndOfFile,
+    // and closes the queue. A lexing error ends the stream with EndOfFile before it is rethrown.
+    void getTokens(TokenQueue& queue, size_t batchSize);
 
-    void revertTo(const Token& token);
+    // Same tokens as getTokens of a new lexer, from chunks of the file split at line ends outside
+    // strings and lexed on up to `threadCount` threads
+    static void getTokensInParallel(const SourceFile& source, std::vector<Token>& tokens, size_t threadCount);
 
 protected:
-    std::unordered_map<std::string, LexemType> _keywords;
     int64_t _pos{0};
-    int64_t _line{1};
-    int64_t _column{0};
+    std::string_view _text;
     const SourceFile& _source;
 
     char peek() {
         ++_pos;
-        ++_column;
-        if (_pos <= static_cast<int64_t>(_source.getText().size())) {
-            return _source.getText()[_pos - 1];
+        if (_pos <= static_cast<int64_t>(_text.size())) {
+            return _text[_pos - 1];
         }
         return '\0';
     }
     [[nodiscard]] char peekCurrent() const {
-        if (_pos <= static_cast<int64_t>(_source.getText().size())) {
-            return _source.getText()[_pos - 1];
+        if (_pos <= static_cast<int64_t>(_text.size())) {
+            return _text[_pos - 1];
         }
         return '\0';
     }
 
     Token getString();
 
-    Token getIdentifier(char firstChar);
+    // The first character is already consumed by the ones below
+    Token getIdentifier();
 
-    Token getNumber(char firstChar);
+    Token getNumber();
+
+    // Fits 32 bits, a SourceFile is at most SourceFile::maxSize bytes
+    [[nodiscard]] SourceLocation getLocation(int64_t start, int64_t length) const {
+        return {&_source, static_cast<uint32_t>(start), static_cast<uint32_t>(length)};
+    }
 
     inline int64_t getPrevPos() const {
         return _pos - 1;
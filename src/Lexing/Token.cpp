@@ -0,0 +1,39 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Token.hpp"
+
+#include "Misc/SourceManager.hpp"
+
+int64_t SourceLocation::getStartLine() const {
+    return isValid() ? static_cast<int64_t>(_sourceFile->getLineNumber(_offset)) : -1;
+}
+int64_t SourceLocation::getEndLine() const {
+    return isValid() ? static_cast<int64_t>(_sourceFile->getLineNumber(getAbsoluteEnd())) : -1;
+}
+int64_t SourceLocation::getStartColumn() const {
+    return isValid() ? static_cast<int64_t>(_sourceFile->getColumn(_offset)) : -1;
+}
+int64_t SourceLocation::getEndColumn() const {
+    return isValid() ? static_cast<int64_t>(_sourceFile->getColumn(getAbsoluteEnd())) : -1;
+}
+
+std::string_view SourceLocation::getText() const {
+    if (!isValid()) {
+        return {};
+    }
+    return std::string_view(_sourceFile->getText()).substr(_offset, _length);
+}
+
+std::string SourceLocation::toString() const {
+    if (isValid()) {
+        return std::to_string(getAbsoluteStart()) + ", " +
+               std::to_string(getAbsoluteEnd()) + ", " +
+               std::to_string(getStartLine()) + ", " +
+               std::to_string(getEndLine()) + ", " +
+               std::to_string(getStartColumn()) + ", " +
+               std::to_string(getEndColumn());
+    } else {
+        return "Invalid location";
+    }
+}
@@ -4,9 +4,10 @@
 #ifndef VUG_TOKEN_HPP
 #define VUG_TOKEN_HPP
 
+#include <array>
 #include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 enum class [[maybe_unused]] LexemType : uint32_t {
     Identifier,
@@ -61,143 +62,114 @@ enum class [[maybe_unused]] LexemType : uint32_t {
     EndOfFile,
 };
 
-inline std::unordered_map<LexemType, std::string> TokenTypeNames = {
-        {LexemType::Identifier, "Identifier"},
-        {LexemType::Number, "Number"},
-        {LexemType::String, "String"},
-        {LexemType::Mod, "Module"},
-        {LexemType::Var, "Var"},
-        {LexemType::Func, "Function"},
-        {LexemType::Type, "Type"},
-        {LexemType::Decl, "Declare"},
-        {LexemType::While, "While"},
-        {LexemType::If, "If"},
-        {LexemType::Else, "Else"},
-        {LexemType::Plus, "+"},
-        {LexemType::Minus, "-"},
-        {LexemType::Multiply, "*"},
-        {LexemType::Divide, "/"},
-        {LexemType::Remainder, "%"},
-        {LexemType::Not, "!"},
-        {LexemType::LogicOr, "||"},
-        {LexemType::LogicAnd, "&&"},
-        {LexemType::BitOr, "|"},
-        {LexemType::BitXor, "^"},
-        {LexemType::BitAnd, "&"},
-        {LexemType::Assign, "="},
-        {LexemType::Equal, "=="},
-        {LexemType::Unequal, "!="},
-        {LexemType::Less, "<"},
-        {LexemType::LessEqual, "<="},
-        {LexemType::Greater, ">"},
-        {LexemType::GreaterEqual, ">="},
-        {LexemType::Arrow, "->"},
-        {LexemType::LeftRoundBracket, "("},
-        {LexemType::RightRoundBracket, ")"},
-        {LexemType::LeftCurlyBracket, "{"},
-        {LexemType::RightCurlyBracket, "}"},
-        {LexemType::Comma, "Comma"},
-        {LexemType::Semicolon, "Semicolon"},
-        {LexemType::EndOfFile, "EOF"},
+// Indexed by LexemType
+inline constexpr std::array<std::string_view, static_cast<size_t>(LexemType::EndOfFile) + 1> TokenTypeNames = {
+        "Identifier",
+        "Number",
+        "String",
+        "Module",
+        "Var",
+        "Function",
+        "Type",
+        "Declare",
+        "If",
+        "Else",
+        "While",
+        "Break",
+        "Return",
+        "+",
+        "-",
+        "*",
+        "/",
+        "%",
+        "!",
+        "||",
+        "&&",
+        "|",
+        "^",
+        "&",
+        "=",
+        "==",
+        "!=",
+        "<",
+        "<=",
+        ">",
+        ">=",
+        "->",
+        "(",
+        ")",
+        "[",
+        "]",
+        "{",
+        "}",
+        "Comma",
+        "Semicolon",
+        "EOF",
 };
+static_assert(TokenTypeNames.back() == "EOF", "a LexemType has no name");
+
+constexpr std::string_view getTokenTypeName(LexemType type) {
+    return TokenTypeNames[static_cast<size_t>(type)];
+}
 
 class SourceFile;
+// Characters of a source file, from `offset` on. Lines and columns are looked up in the file when asked for
 class SourceLocation {
 public:
     SourceLocation(const SourceFile* sourceFile,
-                   int64_t absoluteStart,
-                   int64_t absoluteEnd,
-                   int64_t startLine,
-                   int64_t endLine,
-                   int64_t startColumn,
-                   int64_t endColumn)
+                   uint32_t offset,
+                   uint32_t length)
         : _sourceFile(sourceFile),
-          _absoluteStart(absoluteStart),
-          _absoluteEnd(absoluteEnd),
-          _startLine(startLine),
-          _endLine(endLine),
-          _startColumn(startColumn),
-          _endColumn(endColumn),
-          _isValid(true) {}
+          _offset(offset),
+          _length(length) {}
 
+    // From the start of `start` to the end of `end`
     SourceLocation(const SourceLocation& start,
                    const SourceLocation& end)
-        : _sourceFile(start._sourceFile),
-          _absoluteStart(start._absoluteStart),
-          _absoluteEnd(end._absoluteEnd),
-          _startLine(start._startLine),
-          _endLine(end._endLine),
-          _startColumn(start._startColumn),
-          _endColumn(end._endColumn),
-          _isValid(start.isValid() && end.isValid()) {}
+        : _sourceFile(start.isValid() && end.isValid() ? start._sourceFile : nullptr),
+          _offset(start._offset),
+          _length(end._offset + end._length - start._offset) {}
 
     explicit SourceLocation()
         : _sourceFile(nullptr),
-          _absoluteStart(-1),
-          _absoluteEnd(-1),
-          _startLine(-1),
-          _endLine(-1),
-          _startColumn(-1),
-          _endColumn(-1),
-          _isValid(false) {}
+          _offset(0),
+          _length(0) {}
 
     [[nodiscard]] inline const SourceFile* getSourceFile() const {
         return _sourceFile;
     }
     [[nodiscard]] inline int64_t getAbsoluteStart() const {
-        return _absoluteStart;
+        return isValid() ? _offset : -1;
     }
+    // Offset of the last character
     [[nodiscard]] inline int64_t getAbsoluteEnd() const {
-        return _absoluteEnd;
-    }
-    [[nodiscard]] inline int64_t getStartLine() const {
-        return _startLine;
-    }
-    [[nodiscard]] inline int64_t getEndLine() const {
-        return _endLine;
-    }
-    [[nodiscard]] inline int64_t getStartColumn() const {
-        return _startColumn;
-    }
-    [[nodiscard]] inline int64_t getEndColumn() const {
-        return _endColumn;
+        return isValid() ? static_cast<int64_t>(_offset) + _length - 1 : -1;
     }
+    [[nodiscard]] int64_t getStartLine() const;
+    [[nodiscard]] int64_t getEndLine() const;
+    [[nodiscard]] int64_t getStartColumn() const;
+    [[nodiscard]] int64_t getEndColumn() const;
     [[nodiscard]] inline bool isValid() const {
-        return _isValid;
+        return _sourceFile != nullptr;
     }
+    [[nodiscard]] std::string_view getText() const;
 
-    [[nodiscard]] inline std::string toString() const {
-        if (_isValid) {
-            return std::to_string(_absoluteStart) + ", " +
-                   std::to_string(_absoluteEnd) + ", " +
-                   std::to_string(_startLine) + ", " +
-                   std::to_string(_endLine) + ", " +
-                   std::to_string(_startColumn) + ", " +
-                   std::to_string(_endColumn);
-        } else {
-            return "Invalid location";
-        }
-    }
+    [[nodiscard]] std::string toString() const;
 
 private:
+    // The file rather than its FileId, so a location resolves its text and lines without a SourceManager
     const SourceFile* _sourceFile;
-    int64_t _absoluteStart;
-    int64_t _absoluteEnd;
-    int64_t _startLine;
-    int64_t _endLine;
-    int64_t _startColumn;
-    int64_t _endColumn;
-    bool _isValid;
+    uint32_t _offset;
+    uint32_t _length;
 };
 
+// A lexeme of the source file, its value is the text it covers
 class Token {
 public:
     Token(LexemType type,
-          SourceLocation sourceLocation,
-          const std::string&& value = "")
+          SourceLocation sourceLocation)
         : _type(type),
-          _sourceLocation(sourceLocation),
-          _value(value) {}
+          _sourceLocation(sourceLocation) {}
 
     [[nodiscard]] LexemType getType() const {
         return _type;
@@ -207,13 +179,19 @@ public:
         return _sourceLocation;
     }
 
-    [[nodiscard]] const std::string& getValue() const {
-        return _value;
+    // Without the quotes for strings
+    [[nodiscard]] std::string_view getValue() const {
+        auto text = _sourceLocation.getText();
+        if (_type == LexemType::String && text.size() >= 2) {
+            return text.substr(1, text.size() - 2);
+        }
+        return text;
     }
 
     [[nodiscard]] inline std::string toString() const {
-        return "Type: " + TokenTypeNames[_type] +
-               " Value: " + (!_value.empty() ? _value : "Empty") +
+        auto value = getValue();
+        return "Type: " + std::string(getTokenTypeName(_type)) +
+               " Value: " + (!value.empty() ? std::string(value) : "Empty") +
                " Location: (" + _sourceLocation.toString() + ")";
     }
 
@@ -226,7 +204,7 @@ public:
 
     bool operator==(const Token& rhs) const {
         return _type == rhs._type &&
-               _value == rhs._value;
+               getValue() == rhs.getValue();
     }
     bool operator!=(const Token& rhs) const {
         return !(rhs == *this);
@@ -235,7 +213,6 @@ public:
 protected:
     LexemType _type;
     SourceLocation _sourceLocation;
-    std::string _value;
 };
 
 #endif// VUG_TOKEN_HPP
@@ -4,17 +4,41 @@
 #include "Diagnostic/DiagnosticManager.hpp"
 
 
+#include <charconv>
+#include <chrono>
+#include <exception>
 #include <filesystem>
+#include <format>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <thread>
 
+#include "AST/FlatAST.hpp"
+#include "CodeGen/ElfObjectWriter.hpp"
+#include "CodeGen/NativeCodeGenerator.hpp"
+#include "CodeGen/PerfMap.hpp"
 #include "Diagnostic/Logger.hpp"
 #include "Evaluator/Evaluator.hpp"
+#include "Evaluator/FlatEvaluator.hpp"
+#include "JIT/TraceJit.hpp"
 #include "Lexing/Lexer.hpp"
+#include "Misc/PassManager.hpp"
 #include "Misc/Printer.hpp"
+#include "Misc/SingleProducerQueue.hpp"
 #include "Misc/SourceManager.hpp"
 #include "Misc/Stack.hpp"
+#include "Optimization/CompileTimeEvaluation.hpp"
+#include "Optimization/ConstantPropagation.hpp"
+#include "Optimization/DeadCodeElimination.hpp"
+#include "Optimization/Inliner.hpp"
+#include "Optimization/LoopUnrolling.hpp"
+#include "Optimization/LoopUnswitching.hpp"
+#include "Optimization/RangeAnalysis.hpp"
+#include "Optimization/ScalarEvolution.hpp"
+#include "Optimization/StrengthReduction.hpp"
+#include "Optimization/ValueNumbering.hpp"
 #include "Parsing/Parser.hpp"
 #include "Semantic/Passes/GlobalScopePass.hpp"
 #include "Semantic/Passes/LocalScopePass.hpp"
@@ -22,65 +46,256 @@
 #include "Semantic/SymbolContext.hpp"
 #include "Semantic/SymbolTable.hpp"
 
+static void addOptimizationPasses(PassManager& passManager, OptimizationLevel level, size_t unrollFactor) {
+    if (level == OptimizationLevel::O0) {
+        return;
+    }
+    if (level == OptimizationLevel::O1) {
+        passManager.add<ConstantPropagation>();
+        passManager.add<Inliner>();
+        passManager.add<StrengthReduction>();
+        passManager.add<ValueNumbering>();
+        passManager.add<DeadCodeElimination>();
+        return;
+    }
+
+    // Range analysis propagates constants again over what compile-time evaluation and the inliner left
+    passManager.add<ConstantPropagation>();
+    passManager.add<CompileTimeEvaluation>();
+    passManager.add<Inliner>();
+    passManager.add<RangeAnalysis>();
+    passManager.add<LoopUnswitching>();
+    passManager.add<ScalarEvolution>();
+    passManager.add<LoopUnrolling>(unrollFactor);
+    passManager.add<StrengthReduction>();
+    passManager.add<ValueNumbering>();
+    passManager.add<DeadCodeElimination>();
+}
+
+// The whole of `text` as a count, nothing when it is not one
+static std::optional<size_t> parseCount(std::string_view text) {
+    size_t count = 0;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), count);
+    if (error != std::errc() || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return count;
+}
+
+// Lexes on one thread while this one parses, and defines each function on a third once it is parsed
+static NodePtr<Node> parseInPipeline(const SourceFile& file,
+                                     SymbolContext& context,
+                                     DiagnosticManager& diagnosticManager) {
+    auto tokens = TokenQueue();
+    std::exception_ptr lexingError;
+    auto lexing = std::thread([&] {
+        try {
+            Lexer(file).getTokens(tokens, Lexer::queueBatchSize);
+        } catch (...) {
+            lexingError = std::current_exception();
+        }
+    });
+
+    auto functions = SingleProducerQueue<FunctionDeclaration*>();
+    auto defining = std::thread([&] {
+        while (auto function = functions.pop()) {
+            ModuleDefinitionPass::defineFunction(**function, context);
+        }
+    });
+
+    auto parser = Parser(tokens, diagnosticManager, &functions);
+    auto ast = parser.program();
+    functions.close();
+    defining.join();
+    lexing.join();
+
+    if (lexingError != nullptr) {
+        std::rethrow_exception(lexingError);
+    }
+    return ast;
+}
+
 int main(int argc, char* argv[]) {
     setStackBottom();
 
     auto diag = Logger<LogLevel::Verbose>();
 
-    std::string input;
+    std::string inputPath;
+    std::string outputPath;
+    bool emitObject = false;
+    bool traceJit = false;
+    bool flatEvaluation = false;
+    bool deoptimizationStats = false;
+    auto optimizationLevel = OptimizationLevel::O0;
+    bool timePasses = false;
+    size_t lexingThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    bool pipeline = false;
+    bool optimizationReport = false;
+    size_t unrollFactor = LoopUnrolling::defaultFactor;
+    auto perfMapFormat = PerfMap::Format::None;
 
-    if (argc > 1) {
-        std::ifstream inputFile(argv[1]);
+    for (int index = 1; index < argc; ++index) {
+        std::string_view argument = argv[index];
 
-        if (!inputFile.is_open()) {
-            std::cerr << "Input file couldn't be open";
-            return -1;
+        if (argument == "--emit-obj") {
+            emitObject = true;
+        } else if (argument == "-O0") {
+            optimizationLevel = OptimizationLevel::O0;
+        } else if (argument == "-O1") {
+            optimizationLevel = OptimizationLevel::O1;
+        } else if (argument == "-O2" || argument == "--optimize") {
+            optimizationLevel = OptimizationLevel::O2;
+        } else if (argument == "--time-passes") {
+            timePasses = true;
+        } else if (argument == "--lex-threads") {
+            auto threads = index + 1 < argc ? parseCount(argv[++index]) : std::nullopt;
+            if (!threads.has_value() || *threads == 0) {
+                diag.log<LogLevel::Fatal>("--lex-threads expects a number of threads, at least 1");
+            }
+            lexingThreads = *threads;
+        } else if (argument == "--pipeline") {
+            pipeline = true;
+        } else if (argument == "--opt-report") {
+            optimizationReport = true;
+        } else if (argument == "--unroll-factor") {
+            auto factor = index + 1 < argc ? parseCount(argv[++index]) : std::nullopt;
+            if (!factor.has_value()) {
+                diag.log<LogLevel::Fatal>("--unroll-factor expects a number of copies");
+            }
+            unrollFactor = *factor;
+        } else if (argument == "--trace-jit") {
+            traceJit = true;
+        } else if (argument == "--flat") {
+            flatEvaluation = true;
+        } else if (argument == "--deopt-stats") {
+            deoptimizationStats = true;
+        } else if (argument == "--perf-map") {
+            perfMapFormat = perfMapFormat | PerfMap::Format::Map;
+        } else if (argument == "--jitdump") {
+            perfMapFormat = perfMapFormat | PerfMap::Format::Jitdump;
+        } else if (argument == "-o" && index + 1 < argc) {
+            outputPath = argv[++index];
+        } else {
+            inputPath = argument;
         }
+    }
 
-        input.resize(std::filesystem::file_size(argv[1]));
-        inputFile.read(input.data(), static_cast<std::streamsize>(input.size()));
-    } else {
+    if (inputPath.empty()) {
         diag.log<LogLevel::Fatal>("Path to source file not provided");
     }
+    if (flatEvaluation && traceJit) {
+        diag.log<LogLevel::Fatal>("The trace JIT can't run a flat AST");
+    }
+    if (outputPath.empty()) {
+        outputPath = std::filesystem::path(inputPath).replace_extension(".o").string();
+    }
 
-    auto file = SourceFile(std::filesystem::path(argv[1]).filename().string(), std::move(input));
-    auto lex = Lexer(file);
-
-    std::vector<Token> tokens;
-    lex.getTokens(tokens);
-    // for (const auto& token : tokens) {
-    //     //std::cout << token.toString() << std::endl;
-    // }
+    auto sourceManager = SourceManager();
+    std::string loadError;
+    auto fileId = sourceManager.loadFile(inputPath, loadError);
+    if (!fileId.has_value()) {
+        std::cerr << "Input file " << loadError;
+        return -1;
+    }
 
-    DiagnosticManager diagnosticManager(DiagnosticMessage::Severity::Hint);
-    auto parse = Parser(lex, diagnosticManager);
+    const auto& file = sourceManager.getFile(*fileId);
+    DiagnosticManager diagnosticManager(optimizationReport ? DiagnosticMessage::Severity::Info
+                                                           : DiagnosticMessage::Severity::Hint);
+    // Outlives everything that may point to a node, passes create their nodes in it too
+    auto arena = ASTArena();
+    auto arenaScope = ASTArena::Scope(arena);
+    auto symbolTable = SymbolTable();
+    auto context = SymbolContext(symbolTable);
 
-    auto ast = parse.program();
+    std::vector<Token> tokens;
+    NodePtr<Node> ast;
+    auto frontEndStart = std::chrono::steady_clock::now();
+    if (pipeline) {
+        ast = parseInPipeline(file, context, diagnosticManager);
+    } else {
+        Lexer::getTokensInParallel(file, tokens, lexingThreads);
+    }
+    std::chrono::duration<double> frontEndTime = std::chrono::steady_clock::now() - frontEndStart;
+    if (!pipeline) {
+        ast = Parser(tokens, diagnosticManager).program();
+    }
 
     auto printer = Printer(*ast, 2);
     printer.print();
 
-    auto symbolTable = SymbolTable();
-    auto context = SymbolContext(symbolTable);
+    auto passManager = PassManager(*ast, context, diagnosticManager);
+    passManager.add<ModuleDefinitionPass>();
+    passManager.add<GlobalScopePass>();
+    passManager.add<LocalScopePass>();
+    addOptimizationPasses(passManager, optimizationLevel, unrollFactor);
 
-    auto pass1 = ModuleDefinitionPass(*ast, context, diagnosticManager);
-    auto pass2 = GlobalScopePass(*ast, context, diagnosticManager);
-    auto pass3 = LocalScopePass(*ast, context, diagnosticManager);
-    pass1.analyze();
-    pass2.analyze();
-    pass3.analyze();
+    auto isValid = passManager.run();
+    if (timePasses) {
+        if (pipeline) {
+            std::cerr << std::format("Lexing and parsing in a pipeline: {:.3f} ms\n", frontEndTime.count() * 1e3);
+        } else {
+            std::cerr << std::format("Lexing: {} tokens in {:.3f} ms, {:.1f} MB/s\n",
+                                     tokens.size(),
+                                     frontEndTime.count() * 1e3,
+                                     static_cast<double>(file.getText().size()) / 1e6 / frontEndTime.count());
+        }
+        passManager.printTimings(std::cerr);
+        std::cerr << std::format("AST arena: {} KiB\n", arena.getAllocatedBytes() / 1024);
+    }
+    if (!isValid) {
+        return 0;
+    }
+
+    if (emitObject) {
+        auto generator = NativeCodeGenerator(*ast, diagnosticManager);
+        auto objectCode = generator.generate();
 
-    if (diagnosticManager.error_count() > 0 || diagnosticManager.fatal_count() > 0) {
+        if (diagnosticManager.error_count() > 0) {
+            return 0;
+        }
+
+        std::ofstream outputFile(outputPath, std::ios::binary);
+        if (!outputFile.is_open()) {
+            std::cerr << "Output file couldn't be open";
+            return -1;
+        }
+        ElfObjectWriter(objectCode).write(outputFile);
+        return 0;
+    }
+
+    if (flatEvaluation) {
+        auto flattenStart = std::chrono::steady_clock::now();
+        auto flatAst = FlatAST::flatten(*ast);
+        std::chrono::duration<double> flattenTime = std::chrono::steady_clock::now() - flattenStart;
+        if (timePasses) {
+            std::cerr << std::format("Flattening: {} nodes, {} KiB of tables in {:.3f} ms\n",
+                                     flatAst.getNodeCount(),
+                                     flatAst.getTableBytes() / 1024,
+                                     flattenTime.count() * 1e3);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        FlatEvaluator(flatAst).evaluate();
+        std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+
+        std::wcout << "Run time: " << duration.count() << std::endl;
         return 0;
     }
+
     auto start = std::chrono::high_resolution_clock::now();
 
-    auto evaluator = Evaluator(*ast, context);
+    auto perfMap = PerfMap(perfMapFormat);
+    auto jit = TraceJit(perfMap);
+
+    auto evaluator = Evaluator(*ast, context, traceJit ? &jit : nullptr);
     evaluator.evaluate();
 
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> duration = end - start;
 
     std::wcout << "Run time: " << duration.count() << std::endl;
+    if (traceJit && deoptimizationStats) {
+        jit.printDeoptimizations(std::cerr);
+    }
     return 0;
 }
@@ -0,0 +1,55 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "AllocationCounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+// Per thread, so counting costs no synchronization
+thread_local bool isCounting = false;
+thread_local size_t allocationCount = 0;
+thread_local size_t allocatedBytes = 0;
+}// namespace
+
+AllocationCounter::AllocationCounter()
+    : _start{allocationCount, allocatedBytes},
+      _wasCounting(isCounting) {
+    isCounting = true;
+}
+AllocationCounter::~AllocationCounter() {
+    isCounting = _wasCounting;
+}
+
+AllocationCount AllocationCounter::getCount() const {
+    return {allocationCount - _start.count, allocatedBytes - _start.bytes};
+}
+
+// Array, nothrow and sized forms of the standard library forward to these two
+void* operator new(std::size_t size) {
+    if (isCounting) {
+        ++allocationCount;
+        allocatedBytes += size;
+    }
+
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (auto* memory = std::malloc(size)) {
+            return memory;
+        }
+        auto handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
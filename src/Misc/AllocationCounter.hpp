@@ -0,0 +1,31 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_ALLOCATIONCOUNTER_HPP
+#define VUG_ALLOCATIONCOUNTER_HPP
+
+#include <cstddef>
+
+struct AllocationCount {
+    size_t count{0};
+    size_t bytes{0};
+};
+
+// Counts the heap allocations the calling thread makes through `operator new` while it lives.
+// Outside of one, allocating only tests a flag.
+class AllocationCounter {
+public:
+    AllocationCounter();
+    ~AllocationCounter();
+
+    AllocationCounter(const AllocationCounter&) = delete;
+    AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+    [[nodiscard]] AllocationCount getCount() const;
+
+private:
+    AllocationCount _start;
+    bool _wasCounting;
+};
+
+#endif//VUG_ALLOCATIONCOUNTER_HPP
@@ -0,0 +1,81 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PassManager.hpp"
+
+#include <format>
+#include <stdexcept>
+
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Misc/AllocationCounter.hpp"
+
+bool PassManager::run() {
+    for (size_t index = 0; index < _passes.size(); ++index) {
+        if (!_passes[index].isAnalysis && hasErrors()) {
+            return false;
+        }
+        provideRequired(index);
+        runPass(index);
+    }
+    return !hasErrors();
+}
+
+void PassManager::printTimings(std::ostream& output) const {
+    output << std::format("{:<28}{:>16}{:>14}{:>14}\n", "Pass", "Wall time (ms)", "Allocations", "Bytes");
+
+    auto total = Timing{"Total", {}, 0, 0};
+    for (const auto& timing: _timings) {
+        output << std::format("{:<28}{:>16.3f}{:>14}{:>14}\n",
+                              timing.name,
+                              timing.duration.count(),
+                              timing.allocations,
+                              timing.allocatedBytes);
+        total.duration += timing.duration;
+        total.allocations += timing.allocations;
+        total.allocatedBytes += timing.allocatedBytes;
+    }
+    output << std::format("{:<28}{:>16.3f}{:>14}{:>14}\n",
+                          total.name,
+                          total.duration.count(),
+                          total.allocations,
+                          total.allocatedBytes);
+}
+
+void PassManager::provideRequired(size_t index) {
+    auto required = static_cast<uint32_t>(_passes[index].required);
+    for (uint32_t bit = 1; bit != 0 && bit <= required; bit <<= 1) {
+        auto property = static_cast<PassProperty>(bit);
+        if ((required & bit) == 0 || _valid & property) {
+            continue;
+        }
+
+        auto provider = index;
+        while (provider > 0 && !(_passes[provider - 1].provided & property)) {
+            --provider;
+        }
+        if (provider == 0) {
+            throw std::logic_error(std::format("No pass before '{}' provides what it requires", _passes[index].name));
+        }
+        provideRequired(provider - 1);
+        runPass(provider - 1);
+    }
+}
+
+void PassManager::runPass(size_t index) {
+    const auto& pass = _passes[index];
+
+    auto counter = AllocationCounter();
+    auto start = std::chrono::steady_clock::now();
+    pass.run();
+    auto end = std::chrono::steady_clock::now();
+    auto allocations = counter.getCount();
+
+    _timings.push_back({pass.name, end - start, allocations.count, allocations.bytes});
+
+    _valid = static_cast<PassProperty>((static_cast<uint32_t>(_valid) & ~static_cast<uint32_t>(pass.invalidated)) |
+                                       static_cast<uint32_t>(pass.provided));
+}
+
+bool PassManager::hasErrors() const {
+    return _diagnosticManager.error_count() > 0 || _diagnosticManager.fatal_count() > 0;
+}
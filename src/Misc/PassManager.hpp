@@ -0,0 +1,108 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_PASSMANAGER_HPP
+#define VUG_PASSMANAGER_HPP
+
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "AST/ASTNodesForward.hpp"
+#include "Misc/PassProperty.hpp"
+
+class DiagnosticManager;
+class SymbolContext;
+
+enum class OptimizationLevel {
+    // Semantic passes only
+    O0,
+    // Passes that don't copy loops or evaluate code
+    O1,
+    // Every pass
+    O2,
+};
+
+// Runs passes over the AST in the order they were added. Each pass class declares its `name` and the
+// PassProperty sets it `required`, `provided` and `invalidated`; a required property that a pass
+// invalidated since is provided again by rerunning the last earlier pass providing it.
+// Semantic passes (the ones that `analyze`) always run, so each reports its errors even after a syntax
+// error; a pass rewriting the AST only runs while no error has been reported.
+class PassManager {
+public:
+    PassManager(Node& ast,
+                SymbolContext& context,
+                DiagnosticManager& diagnosticManager)
+        : _ast(ast),
+          _context(context),
+          _diagnosticManager(diagnosticManager) {}
+
+    // The pass is constructed when it runs, from the AST, the symbol context when it takes one,
+    // the diagnostic manager and `arguments`
+    template<typename PassType, typename... Arguments>
+    void add(Arguments... arguments) {
+        _passes.push_back({PassType::name,
+                           PassType::required,
+                           PassType::provided,
+                           PassType::invalidated,
+                           requires(PassType pass) { pass.analyze(); },
+                           [this, arguments...]() {
+                               auto pass = create<PassType>(arguments...);
+                               if constexpr (requires { pass.analyze(); }) {
+                                   pass.analyze();
+                               } else {
+                                   pass.run();
+                               }
+                           }});
+    }
+
+    // Returns false when a pass or the parser reported an error
+    bool run();
+
+    // Wall time and heap allocations of every pass run, in order
+    void printTimings(std::ostream& output) const;
+
+protected:
+    struct Pass {
+        std::string_view name;
+        PassProperty required;
+        PassProperty provided;
+        PassProperty invalidated;
+        // Only reports errors, runs on an AST that has some
+        bool isAnalysis;
+        std::function<void()> run;
+    };
+    struct Timing {
+        std::string_view name;
+        std::chrono::duration<double, std::milli> duration;
+        size_t allocations;
+        size_t allocatedBytes;
+    };
+
+    Node& _ast;
+    SymbolContext& _context;
+    DiagnosticManager& _diagnosticManager;
+
+    std::vector<Pass> _passes;
+    std::vector<Timing> _timings;
+    PassProperty _valid{PassProperty::None};
+
+    template<typename PassType, typename... Arguments>
+    PassType create(const Arguments&... arguments) {
+        if constexpr (std::is_constructible_v<PassType, Node&, SymbolContext&, DiagnosticManager&, const Arguments&...>) {
+            return PassType(_ast, _context, _diagnosticManager, arguments...);
+        } else {
+            return PassType(_ast, _diagnosticManager, arguments...);
+        }
+    }
+
+    // Reruns earlier providers of what the pass at `index` requires and isn't valid anymore
+    void provideRequired(size_t index);
+    void runPass(size_t index);
+    [[nodiscard]] bool hasErrors() const;
+};
+
+#endif//VUG_PASSMANAGER_HPP
@@ -0,0 +1,29 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_PASSPROPERTY_HPP
+#define VUG_PASSPROPERTY_HPP
+
+#include <cstdint>
+
+// Facts about the AST that passes provide, rely on and invalidate
+enum class PassProperty : uint32_t {
+    None = 0,
+    // Module symbols exist
+    ModulesDefined = 1 << 0,
+    // Functions have symbols and signatures
+    GlobalsResolved = 1 << 1,
+    // Every identifier and expression is attributed
+    LocalsResolved = 1 << 2,
+    // Every expression with a value known at compile time is a literal
+    ConstantsPropagated = 1 << 3,
+};
+
+constexpr PassProperty operator|(PassProperty lhs, PassProperty rhs) {
+    return static_cast<PassProperty>(static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+}
+constexpr bool operator&(PassProperty lhs, PassProperty rhs) {
+    return (static_cast<uint32_t>(lhs) & static_cast<uint32_t>(rhs)) != 0;
+}
+
+#endif//VUG_PASSPROPERTY_HPP
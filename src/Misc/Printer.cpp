@@ -154,7 +154,7 @@ void Printer::visit(BinaryOperation& node) {
     std::cout << spaces
               << (node.exprType != nullptr ? "(" + node.exprType->getTypeName() + ")" : "")
               << "BinOp: "
-              << TokenTypeNames[node.operationToken]
+              << getTokenTypeName(node.operationToken)
               << std::endl;
 
     visit(*node.left);
@@ -171,7 +171,7 @@ void Printer::visit(PrefixOperation& node) {
     std::cout << spaces
               << (node.exprType != nullptr ? "(" + node.exprType->getTypeName() + ")" : "")
               << "PrefixOp: "
-              << TokenTypeNames[node.operationType]
+              << getTokenTypeName(node.operationType)
               << std::endl;
 
     visit(*node.right);
@@ -0,0 +1,75 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_SINGLEPRODUCERQUEUE_HPP
+#define VUG_SINGLEPRODUCERQUEUE_HPP
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+// Unbounded queue between one producing and one consuming thread, without locks. Values are linked one
+// node after another; the producer links a node behind the last one, the consumer follows the links and
+// waits on the link of the last node while the queue is empty.
+template<typename T>
+class SingleProducerQueue {
+public:
+    SingleProducerQueue() : _head(new Node), _tail(_head) {}
+    ~SingleProducerQueue() {
+        delete _retired;
+        while (_head != nullptr) {
+            auto next = _head->next.load(std::memory_order_relaxed);
+            delete _head;
+            _head = next;
+        }
+    }
+
+    SingleProducerQueue(const SingleProducerQueue&) = delete;
+    SingleProducerQueue& operator=(const SingleProducerQueue&) = delete;
+
+    // Producer side
+    void push(T value) {
+        link(new Node{std::move(value)});
+    }
+    // Nothing is pushed after it
+    void close() {
+        link(new Node);
+    }
+
+    // Consumer side. Blocks until there is a value, nullptr once the queue is closed.
+    // The value stays valid until pop is called twice more.
+    T* pop() {
+        auto next = _head->next.load(std::memory_order_acquire);
+        while (next == nullptr) {
+            _head->next.wait(nullptr, std::memory_order_acquire);
+            next = _head->next.load(std::memory_order_acquire);
+        }
+
+        delete _retired;
+        _retired = _head;
+        _head = next;
+        return _head->value.has_value() ? &*_head->value : nullptr;
+    }
+
+private:
+    struct Node {
+        // Empty in the node close links
+        std::optional<T> value;
+        std::atomic<Node*> next{nullptr};
+    };
+
+    // Last node popped, the consumer's
+    Node* _head;
+    // Node popped before it, still in use by whoever popped it
+    Node* _retired{nullptr};
+    // Last node pushed, the producer's
+    Node* _tail;
+
+    void link(Node* node) {
+        _tail->next.store(node, std::memory_order_release);
+        _tail->next.notify_one();
+        _tail = node;
+    }
+};
+
+#endif//VUG_SINGLEPRODUCERQUEUE_HPP
@@ -3,10 +3,185 @@
 
 #include "SourceManager.hpp"
 
-void SourceManager::insertSourceFile(SourceFile file) {
-    _files.insert({file.getName(), std::move(file)});
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceFile::SourceFile(FileId id, std::string name, std::string text)
+    : _id(id),
+      _name(std::move(name)),
+      _ownedText(std::move(text)),
+      _text(_ownedText) {
+    if (_text.size() > maxSize) {
+        throw std::length_error("Source text doesn't fit 32-bit locations");
+    }
+}
+
+#ifdef _WIN32
+SourceFile::~SourceFile() {
+    if (_mapping != nullptr) {
+        UnmapViewOfFile(_mapping);
+    }
+}
+
+std::unique_ptr<SourceFile> SourceFile::map(FileId id, const std::filesystem::path& path, std::string& error) {
+    error = "couldn't be opened";
+    auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    if (static_cast<uint64_t>(size.QuadPart) > maxSize) {
+        CloseHandle(file);
+        error = "is larger than 4 GiB";
+        return nullptr;
+    }
+
+    auto sourceFile = std::unique_ptr<SourceFile>(new SourceFile(id, path.filename().string()));
+    if (size.QuadPart > 0) {
+        auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            sourceFile->_mapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        if (sourceFile->_mapping == nullptr) {
+            CloseHandle(file);
+            return nullptr;
+        }
+        sourceFile->_mappedSize = static_cast<size_t>(size.QuadPart);
+        sourceFile->_text = std::string_view(static_cast<const char*>(sourceFile->_mapping), sourceFile->_mappedSize);
+    }
+    CloseHandle(file);
+    return sourceFile;
+}
+#endif
+#ifndef _WIN32
+SourceFile::~SourceFile() {
+    if (_mapping != nullptr) {
+        munmap(_mapping, _mappedSize);
+    }
+}
+
+std::unique_ptr<SourceFile> SourceFile::map(FileId id, const std::filesystem::path& path, std::string& error) {
+    error = "couldn't be opened";
+    auto descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return nullptr;
+    }
+    struct stat status {};
+    if (fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode)) {
+        close(descriptor);
+        return nullptr;
+    }
+    if (static_cast<uint64_t>(status.st_size) > maxSize) {
+        close(descriptor);
+        error = "is larger than 4 GiB";
+        return nullptr;
+    }
+
+    auto sourceFile = std::unique_ptr<SourceFile>(new SourceFile(id, path.filename().string()));
+    // Empty files can't be mapped and need no mapping
+    if (status.st_size > 0) {
+        auto mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping == MAP_FAILED) {
+            close(descriptor);
+            return nullptr;
+        }
+        sourceFile->_mapping = mapping;
+        sourceFile->_mappedSize = static_cast<size_t>(status.st_size);
+        sourceFile->_text = std::string_view(static_cast<const char*>(mapping), sourceFile->_mappedSize);
+    }
+    close(descriptor);
+    return sourceFile;
+}
+#endif
+
+std::string_view SourceFile::getLine(uint64_t line) const {
+    const auto& lineStarts = getLineStarts();
+    if (line == 0 || line > lineStarts.size()) {
+        return {};
+    }
+
+    auto start = lineStarts[line - 1];
+    auto end = _text.find_first_of("\r\n", start);
+    if (end == std::string_view::npos) {
+        end = _text.size();
+    }
+    return _text.substr(start, end - start);
+}
+uint64_t SourceFile::getLineNumber(uint32_t offset) const {
+    const auto& lineStarts = getLineStarts();
+    return std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin();
+}
+uint64_t SourceFile::getColumn(uint32_t offset) const {
+    return offset - getLineStarts()[getLineNumber(offset) - 1] + 1;
+}
+
+const std::vector<uint32_t>& SourceFile::getLineStarts() const {
+    std::call_once(_lineStartsFlag, [this] {
+        _lineStarts.push_back(0);
+
+        // Without carriage returns every line ends at a '\n' memchr finds
+        if (!_text.empty() && std::memchr(_text.data(), '\r', _text.size()) == nullptr) {
+            const auto* end = _text.data() + _text.size();
+            for (const auto* position = _text.data(); position < end;) {
+                const auto* newline = static_cast<const char*>(std::memchr(position, '\n', end - position));
+                if (newline == nullptr) {
+                    break;
+                }
+                position = newline + 1;
+                _lineStarts.push_back(static_cast<uint32_t>(position - _text.data()));
+            }
+            return;
+        }
+
+        for (size_t index = 0; index < _text.size(); ++index) {
+            if (_text[index] == '\r' && index + 1 < _text.size() && _text[index + 1] == '\n') {
+                ++index;
+            }
+            if (_text[index] == '\r' || _text[index] == '\n') {
+                _lineStarts.push_back(static_cast<uint32_t>(index + 1));
+            }
+        }
+    });
+    return _lineStarts;
+}
+
+std::optional<FileId> SourceManager::loadFile(const std::filesystem::path& path, std::string& error) {
+    auto file = SourceFile::map(static_cast<FileId>(_files.size()), path, error);
+    if (file == nullptr) {
+        return std::nullopt;
+    }
+    _files.push_back(std::move(file));
+    return _files.back()->getId();
+}
+
+FileId SourceManager::addFile(std::string name, std::string text) {
+    auto id = static_cast<FileId>(_files.size());
+    _files.push_back(std::make_unique<SourceFile>(id, std::move(name), std::move(text)));
+    return id;
 }
 
-SourceFile SourceManager::findSourceFile(const std::string& file) {
-    return _files.find(file)->second;
+const SourceFile* SourceManager::findSourceFile(const std::string& name) const {
+    for (const auto& file: _files) {
+        if (file->getName() == name) {
+            return file.get();
+        }
+    }
+    return nullptr;
 }
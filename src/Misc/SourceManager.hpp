@@ -4,59 +4,84 @@
 #ifndef VUG_SOURCEMANAGER_HPP
 #define VUG_SOURCEMANAGER_HPP
 
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
+// Index of a file in its SourceManager
+using FileId = uint32_t;
+
+// Tokens and locations point into the text, so a file neither moves nor copies
 class SourceFile {
 public:
-    SourceFile(std::string name, std::string text)
-        : _name(std::move(name)),
-          _text(std::move(text)) {
-        size_t start = 0;
-
-        while (start < _text.size()) {
-            size_t end = _text.find_first_of("\r\n", start);
-
-            if (end == std::string::npos) {
-                _textLines.emplace_back(_text.data() + start, _text.size() - start);
-                break;
-            }
-
-            _textLines.emplace_back(_text.data() + start, end - start);
-            if (_text[end] == '\r' &&
-                end + 1 < _text.size() &&
-                _text[end + 1] == '\n') {
-                end++;
-            }
-
-            start = end + 1;
-        }
-    }
+    // Locations address the text with 32-bit offsets
+    static constexpr uint64_t maxSize = UINT32_MAX;
+
+    // Text held in memory, at most `maxSize` bytes
+    SourceFile(FileId id, std::string name, std::string text);
+    ~SourceFile();
 
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    // Maps the file read-only instead of reading it. nullptr with the reason in `error` when it can't be
+    // opened or is larger than `maxSize`. The file must not be truncated while it is mapped.
+    static std::unique_ptr<SourceFile> map(FileId id, const std::filesystem::path& path, std::string& error);
+
+    [[nodiscard]] FileId getId() const {
+        return _id;
+    }
     [[nodiscard]] const std::string& getName() const {
         return _name;
     }
-    [[nodiscard]] const std::string& getText() const {
+    [[nodiscard]] std::string_view getText() const {
         return _text;
     }
-    [[nodiscard]] inline std::string_view getLine(uint64_t line) const {
-        return _textLines[line - 1];
-    }
+    // Lines are numbered from 1 and end before "\n", "\r\n" or "\r"
+    [[nodiscard]] std::string_view getLine(uint64_t line) const;
+    [[nodiscard]] uint64_t getLineNumber(uint32_t offset) const;
+    // Columns are numbered from 1, in bytes
+    [[nodiscard]] uint64_t getColumn(uint32_t offset) const;
 
 private:
+    FileId _id;
     std::string _name;
-    std::string _text;
-    std::vector<std::string_view> _textLines;
+    std::string _ownedText;
+    std::string_view _text;
+    void* _mapping{nullptr};
+    size_t _mappedSize{0};
+
+    // Offset of the first character of each line, built by the first query about lines
+    mutable std::vector<uint32_t> _lineStarts;
+    mutable std::once_flag _lineStartsFlag;
+
+    SourceFile(FileId id, std::string name)
+        : _id(id),
+          _name(std::move(name)) {}
+
+    const std::vector<uint32_t>& getLineStarts() const;
 };
 
 class SourceManager {
 public:
     SourceManager() = default;
 
-    void insertSourceFile(SourceFile file);
-    SourceFile findSourceFile(const std::string& name);
+    // Named by the file name, nullopt with the reason in `error` when the file can't be loaded
+    std::optional<FileId> loadFile(const std::filesystem::path& path, std::string& error);
+    FileId addFile(std::string name, std::string text);
+
+    [[nodiscard]] const SourceFile& getFile(FileId id) const {
+        return *_files[id];
+    }
+    [[nodiscard]] const SourceFile* findSourceFile(const std::string& name) const;
 
 private:
-    std::unordered_map<std::string, SourceFile> _files;
+    std::vector<std::unique_ptr<SourceFile>> _files;
 };
 
 #endif//VUG_SOURCEMANAGER_HPP
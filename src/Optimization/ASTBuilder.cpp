@@ -0,0 +1,115 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ASTBuilder.hpp"
+
+#include "Semantic/SymbolContext.hpp"
+#include "Semantic/Type.hpp"
+
+bool ASTBuilder::canMaterialize(const Type* type) {
+    if (type->isInteger()) {
+        auto integerType = static_cast<const IntegerType*>(type);
+        return integerType->getBits() == 32 && integerType->isIsSigned();
+    }
+    return type->getKind() == TypeKind::Primitive;
+}
+
+LocalVariableSymbol* ASTBuilder::createVariable(std::string name, TypeSymbol* typeSymbol) {
+    auto symbol = _context.addSymbol<LocalVariableSymbol>(std::move(name));
+    symbol->setTypeSymbol(typeSymbol);
+    return symbol;
+}
+LocalVariableSymbol* ASTBuilder::createVariable(std::string name, const Type* type) {
+    if (!canMaterialize(type)) {
+        throw std::logic_error("Unsupported operation");
+    }
+
+    auto typeSymbol = type->isInteger() ? _context.getIntType(32, true) : _context.getBoolType();
+    return createVariable(std::move(name), const_cast<TypeSymbol*>(typeSymbol));
+}
+
+NodePtr<Expression> ASTBuilder::constant(int64_t value, const Type* type, SourceLocation sourceLocation) {
+    if (!canMaterialize(type)) {
+        throw std::logic_error("Unsupported operation");
+    }
+
+    auto intType = _context.getIntType(32, true)->getType();
+
+    if (!type->isInteger()) {
+        // There are no boolean literals, comparing zeros gives either value
+        return binaryOperation(value != 0 ? LexemType::Equal : LexemType::Unequal,
+                               constant(0, intType, sourceLocation),
+                               constant(0, intType, sourceLocation),
+                               sourceLocation);
+    }
+
+    if (value == INT32_MIN) {
+        // The literal of the minimum doesn't fit in int32 before negation
+        return binaryOperation(LexemType::Minus,
+                               constant(INT32_MIN + 1, intType, sourceLocation),
+                               constant(1, intType, sourceLocation),
+                               sourceLocation);
+    }
+    if (value < 0) {
+        return prefixOperation(LexemType::Minus, constant(-value, intType, sourceLocation), sourceLocation);
+    }
+
+    auto number = makeNode<Number>(ASTArena::current().copy(std::to_string(value)), sourceLocation);
+    number->exprType = intType;
+    return number;
+}
+NodePtr<Identifier> ASTBuilder::identifier(LocalVariableSymbol& symbol, SourceLocation sourceLocation) {
+    auto identifier = makeNode<Identifier>(ASTArena::current().copy(symbol.getName()), sourceLocation);
+    identifier->symbolRef = &symbol;
+    identifier->exprType = symbol.getTypeSymbol()->getType();
+    return identifier;
+}
+NodePtr<BinaryOperation> ASTBuilder::binaryOperation(LexemType operation,
+                                                     NodePtr<Expression> left,
+                                                     NodePtr<Expression> right,
+                                                     SourceLocation sourceLocation) {
+    auto result = left->exprType->binaryOperationType(operation, *right->exprType);
+    if (!result.isTypesCorrect) {
+        throw std::logic_error("Unsupported operation");
+    }
+
+    auto node = makeNode<BinaryOperation>(operation, std::move(left), std::move(right), sourceLocation);
+    node->exprType = result.resultType;
+    return node;
+}
+NodePtr<PrefixOperation> ASTBuilder::prefixOperation(LexemType operation,
+                                                     NodePtr<Expression> right,
+                                                     SourceLocation sourceLocation) {
+    auto result = right->exprType->prefixOperationType(operation);
+    if (!result.isTypesCorrect) {
+        throw std::logic_error("Unsupported operation");
+    }
+
+    auto node = makeNode<PrefixOperation>(operation, std::move(right), sourceLocation);
+    node->exprType = result.resultType;
+    return node;
+}
+
+NodePtr<LocalVariableDeclaration> ASTBuilder::declaration(LocalVariableSymbol& symbol,
+                                                          NodePtr<Expression> value,
+                                                          SourceLocation sourceLocation) {
+    auto& arena = ASTArena::current();
+    auto node = makeNode<LocalVariableDeclaration>(arena.copy(symbol.getTypeSymbol()->getName()),
+                                                   arena.copy(symbol.getName()),
+                                                   std::move(value),
+                                                   sourceLocation);
+    node->symbolRef = &symbol;
+    return node;
+}
+NodePtr<Assign> ASTBuilder::assign(LocalVariableSymbol& symbol,
+                                   NodePtr<Expression> value,
+                                   SourceLocation sourceLocation) {
+    auto node = makeNode<Assign>(ASTArena::current().copy(symbol.getName()), std::move(value), sourceLocation);
+    node->symbolRef = &symbol;
+    return node;
+}
+NodePtr<Break> ASTBuilder::breakLoop(While& loop, SourceLocation sourceLocation) {
+    auto node = makeNode<Break>(sourceLocation);
+    node->breakedStmt = &loop;
+    return node;
+}
@@ -0,0 +1,50 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_ASTBUILDER_HPP
+#define VUG_ASTBUILDER_HPP
+
+#include <memory>
+#include <string>
+
+#include "AST/ASTNodes.hpp"
+
+class SymbolContext;
+
+// Creates nodes for the optimization passes, which run after semantic analysis:
+// every node comes out with its type and symbols already resolved.
+class ASTBuilder {
+public:
+    explicit ASTBuilder(SymbolContext& context)
+        : _context(context) {}
+
+    // Constants can only be spelled for the types the language has literals for (int32 and bool)
+    [[nodiscard]] static bool canMaterialize(const Type* type);
+
+    LocalVariableSymbol* createVariable(std::string name, TypeSymbol* typeSymbol);
+    // Only for materializable types
+    LocalVariableSymbol* createVariable(std::string name, const Type* type);
+
+    NodePtr<Expression> constant(int64_t value, const Type* type, SourceLocation sourceLocation);
+    NodePtr<Identifier> identifier(LocalVariableSymbol& symbol, SourceLocation sourceLocation);
+    NodePtr<BinaryOperation> binaryOperation(LexemType operation,
+                                             NodePtr<Expression> left,
+                                             NodePtr<Expression> right,
+                                             SourceLocation sourceLocation);
+    NodePtr<PrefixOperation> prefixOperation(LexemType operation,
+                                             NodePtr<Expression> right,
+                                             SourceLocation sourceLocation);
+
+    NodePtr<LocalVariableDeclaration> declaration(LocalVariableSymbol& symbol,
+                                                  NodePtr<Expression> value,
+                                                  SourceLocation sourceLocation);
+    NodePtr<Assign> assign(LocalVariableSymbol& symbol,
+                           NodePtr<Expression> value,
+                           SourceLocation sourceLocation);
+    NodePtr<Break> breakLoop(While& loop, SourceLocation sourceLocation);
+
+protected:
+    SymbolContext& _context;
+};
+
+#endif//VUG_ASTBUILDER_HPP
@@ -0,0 +1,149 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ASTCloner.hpp"
+
+#include "Misc/Stack.hpp"
+#include "Semantic/SymbolContext.hpp"
+
+LocalVariableSymbol* ASTCloner::getMappedSymbol(LocalVariableSymbol* symbol) const {
+    auto mapped = _symbols.find(symbol);
+    return mapped != _symbols.end() ? mapped->second : symbol;
+}
+
+NodePtr<Expression> ASTCloner::clone(Expression& node) {
+    stackGuard();
+
+    visit(node);
+    return std::move(_expression);
+}
+NodePtr<Statement> ASTCloner::clone(Statement& node) {
+    stackGuard();
+
+    visit(node);
+    return std::move(_statement);
+}
+NodePtr<StatementsBlock> ASTCloner::clone(StatementsBlock& node) {
+    stackGuard();
+
+    visit(node);
+    return NodePtr<StatementsBlock>(static_cast<StatementsBlock*>(_statement.release()));
+}
+void ASTCloner::visit(Node& node) {
+    stackGuard();
+
+    node.accept(*this);
+}
+
+void ASTCloner::visit(Number& node) {
+    stackGuard();
+
+    auto clone = makeNode<Number>(node.number, node.sourceLocation);
+    clone->exprType = node.exprType;
+    _expression = std::move(clone);
+}
+void ASTCloner::visit(Identifier& node) {
+    stackGuard();
+
+    auto clone = makeNode<Identifier>(node.name, node.sourceLocation);
+    clone->symbolRef = getMappedSymbol(node.symbolRef);
+    clone->exprType = node.exprType;
+    _expression = std::move(clone);
+}
+void ASTCloner::visit(BinaryOperation& node) {
+    stackGuard();
+
+    auto left = clone(*node.left);
+    auto right = clone(*node.right);
+
+    auto clone = makeNode<BinaryOperation>(node.operationToken, std::move(left), std::move(right), node.sourceLocation);
+    clone->exprType = node.exprType;
+    clone->isLeftNonNegative = node.isLeftNonNegative;
+    _expression = std::move(clone);
+}
+void ASTCloner::visit(PrefixOperation& node) {
+    stackGuard();
+
+    auto clone = makeNode<PrefixOperation>(node.operationType, this->clone(*node.right), node.sourceLocation);
+    clone->exprType = node.exprType;
+    _expression = std::move(clone);
+}
+void ASTCloner::visit(CallFunction& node) {
+    stackGuard();
+
+    NodeList<Expression> arguments;
+    for (const auto& argument: node.arguments) {
+        arguments.push_back(clone(*argument));
+    }
+
+    auto clone = makeNode<CallFunction>(node.name, std::move(arguments), node.sourceLocation);
+    clone->symbolRef = node.symbolRef;
+    clone->exprType = node.exprType;
+    _expression = std::move(clone);
+}
+
+void ASTCloner::visit(Assign& node) {
+    stackGuard();
+
+    auto clone = makeNode<Assign>(node.name, this->clone(*node.value), node.sourceLocation);
+    clone->symbolRef = getMappedSymbol(node.symbolRef);
+    _statement = std::move(clone);
+}
+void ASTCloner::visit(Break& node) {
+    stackGuard();
+
+    auto clone = makeNode<Break>(node.sourceLocation);
+    auto loop = _loops.find(node.breakedStmt);
+    clone->breakedStmt = loop != _loops.end() ? loop->second : node.breakedStmt;
+    _statement = std::move(clone);
+}
+void ASTCloner::visit(If& node) {
+    stackGuard();
+
+    auto condition = clone(*node.condition);
+    auto then = clone(*node.then);
+    auto elseThen = node.elseThen != nullptr ? clone(*node.elseThen) : nullptr;
+
+    _statement = makeNode<If>(std::move(condition), std::move(then), std::move(elseThen), node.sourceLocation);
+}
+void ASTCloner::visit(LocalVariableDeclaration& node) {
+    stackGuard();
+
+    auto value = clone(*node.value);
+
+    auto symbol = _context.addSymbol<LocalVariableSymbol>(node.symbolRef->getName());
+    symbol->setTypeSymbol(node.symbolRef->getTypeSymbol());
+    mapSymbol(*node.symbolRef, *symbol);
+
+    auto clone = makeNode<LocalVariableDeclaration>(node.type, node.name, std::move(value), node.sourceLocation);
+    clone->symbolRef = symbol;
+    _statement = std::move(clone);
+}
+void ASTCloner::visit(Print& node) {
+    stackGuard();
+
+    _statement = makeNode<Print>(clone(*node.expression), node.sourceLocation);
+}
+void ASTCloner::visit(Return& node) {
+    stackGuard();
+
+    _statement = makeNode<Return>(clone(*node.returnExpression), node.sourceLocation);
+}
+void ASTCloner::visit(StatementsBlock& node) {
+    stackGuard();
+
+    NodeList<Statement> statements;
+    for (const auto& statement: node.statements) {
+        statements.push_back(clone(*statement));
+    }
+
+    _statement = makeNode<StatementsBlock>(std::move(statements), node.sourceLocation);
+}
+void ASTCloner::visit(While& node) {
+    stackGuard();
+
+    auto clone = makeNode<While>(this->clone(*node.condition), nullptr, node.sourceLocation);
+    _loops[&node] = clone.get();
+    clone->body = this->clone(*node.body);
+    _statement = std::move(clone);
+}
@@ -0,0 +1,59 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_ASTCLONER_HPP
+#define VUG_ASTCLONER_HPP
+
+#include <memory>
+#include <unordered_map>
+
+#include "AST/ASTNodes.hpp"
+#include "AST/ASTWalker.hpp"
+
+class SymbolContext;
+
+// Deep copy of checked statements and expressions.
+// Locals declared inside the copy get fresh symbols and breaks follow the copied loops;
+// anything declared outside keeps its symbol unless mapped explicitly.
+class ASTCloner : public ASTWalker {
+public:
+    explicit ASTCloner(SymbolContext& context)
+        : _context(context) {}
+
+    void mapSymbol(const LocalVariableSymbol& from, LocalVariableSymbol& to) {
+        _symbols[&from] = &to;
+    }
+    [[nodiscard]] LocalVariableSymbol* getMappedSymbol(LocalVariableSymbol* symbol) const;
+
+    NodePtr<Expression> clone(Expression& node);
+    NodePtr<Statement> clone(Statement& node);
+    NodePtr<StatementsBlock> clone(StatementsBlock& node);
+
+    void visit(Number& node) override;
+    void visit(Identifier& node) override;
+    void visit(BinaryOperation& node) override;
+    void visit(PrefixOperation& node) override;
+    void visit(CallFunction& node) override;
+
+    void visit(Assign& node) override;
+    void visit(Break& node) override;
+    void visit(If& node) override;
+    void visit(LocalVariableDeclaration& node) override;
+    void visit(Print& node) override;
+    void visit(Return& node) override;
+    void visit(StatementsBlock& node) override;
+    void visit(While& node) override;
+
+protected:
+    SymbolContext& _context;
+
+    std::unordered_map<const LocalVariableSymbol*, LocalVariableSymbol*> _symbols;
+    std::unordered_map<const Statement*, Statement*> _loops;
+
+    NodePtr<Expression> _expression;
+    NodePtr<Statement> _statement;
+
+    void visit(Node& node) override;
+};
+
+#endif//VUG_ASTCLONER_HPP
@@ -0,0 +1,119 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CallGraph.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "AST/ASTTraversal.hpp"
+#include "Misc/Stack.hpp"
+
+namespace {
+    // Tarjan's algorithm, strongly connected components come out callees first
+    class CycleFinder {
+    public:
+        explicit CycleFinder(std::vector<CallGraph::Function*>& order)
+            : _order(order) {}
+
+        void visit(CallGraph::Function* function) {
+            stackGuard();
+
+            _indices[function] = _lowLinks[function] = _nextIndex++;
+            _stack.push_back(function);
+            _onStack.insert(function);
+
+            for (auto callee: function->callees) {
+                if (!_indices.contains(callee)) {
+                    visit(callee);
+                    _lowLinks[function] = std::min(_lowLinks[function], _lowLinks[callee]);
+                } else if (_onStack.contains(callee)) {
+                    _lowLinks[function] = std::min(_lowLinks[function], _indices[callee]);
+                }
+            }
+
+            if (_lowLinks[function] == _indices[function]) {
+                std::vector<CallGraph::Function*> component;
+                CallGraph::Function* member;
+                do {
+                    member = _stack.back();
+                    _stack.pop_back();
+                    _onStack.erase(member);
+                    component.push_back(member);
+                } while (member != function);
+
+                for (auto componentMember: component) {
+                    componentMember->isRecursive =
+                            component.size() > 1 ||
+                            std::find(function->callees.begin(), function->callees.end(), function) != function->callees.end();
+                    _order.push_back(componentMember);
+                }
+            }
+        }
+
+        [[nodiscard]] bool isVisited(CallGraph::Function* function) const {
+            return _indices.contains(function);
+        }
+
+    private:
+        std::vector<CallGraph::Function*>& _order;
+        std::unordered_map<CallGraph::Function*, size_t> _indices;
+        std::unordered_map<CallGraph::Function*, size_t> _lowLinks;
+        std::vector<CallGraph::Function*> _stack;
+        std::unordered_set<CallGraph::Function*> _onStack;
+        size_t _nextIndex{0};
+    };
+}// namespace
+
+CallGraph::CallGraph(Node& ast) {
+    collectFunctions(ast);
+
+    for (const auto& function: _functions) {
+        collectCalls(*function, *function->declaration->definition);
+
+        std::unordered_set<Function*> callees;
+        for (auto call: function->calls) {
+            auto callee = getFunction(call->symbolRef);
+            if (callee != nullptr && callees.insert(callee).second) {
+                function->callees.push_back(callee);
+            }
+        }
+    }
+
+    auto finder = CycleFinder(_bottomUpOrder);
+    for (const auto& function: _functions) {
+        if (!finder.isVisited(function.get())) {
+            finder.visit(function.get());
+        }
+    }
+}
+
+CallGraph::Function* CallGraph::getFunction(const FunctionSymbol* symbol) const {
+    auto function = _symbols.find(symbol);
+    return function != _symbols.end() ? function->second : nullptr;
+}
+
+void CallGraph::collectFunctions(Node& node) {
+    stackGuard();
+
+    if (node.kind == Node::Kind::FunctionDeclaration) {
+        auto& declaration = static_cast<FunctionDeclaration&>(node);
+
+        _functions.push_back(std::make_unique<Function>(&declaration));
+        _symbols[declaration.symbolRef] = _functions.back().get();
+    } else if (node.kind == Node::Kind::ModuleDeclaration || node.kind == Node::Kind::DeclarationsBlock) {
+        forEachChild(node, [this](Node& child) {
+            collectFunctions(child);
+        });
+    }
+}
+void CallGraph::collectCalls(Function& function, Node& node) {
+    stackGuard();
+
+    forEachChild(node, [this, &function](Node& child) {
+        collectCalls(function, child);
+    });
+    if (node.kind == Node::Kind::CallFunction) {
+        function.calls.push_back(&static_cast<CallFunction&>(node));
+    }
+}
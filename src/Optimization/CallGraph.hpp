@@ -0,0 +1,43 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_CALLGRAPH_HPP
+#define VUG_CALLGRAPH_HPP
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "AST/ASTNodesForward.hpp"
+
+class FunctionSymbol;
+
+// Functions of a checked program and the calls between them, as they were when the graph was built
+class CallGraph {
+public:
+    struct Function {
+        FunctionDeclaration* declaration;
+        std::vector<CallFunction*> calls;
+        std::vector<Function*> callees;
+        // Part of a cycle of calls, including calling itself
+        bool isRecursive{false};
+    };
+
+    explicit CallGraph(Node& ast);
+
+    [[nodiscard]] Function* getFunction(const FunctionSymbol* symbol) const;
+    // Callees come before their callers, functions of one cycle in no particular order
+    [[nodiscard]] const std::vector<Function*>& getBottomUpOrder() const {
+        return _bottomUpOrder;
+    }
+
+protected:
+    std::vector<std::unique_ptr<Function>> _functions;
+    std::unordered_map<const FunctionSymbol*, Function*> _symbols;
+    std::vector<Function*> _bottomUpOrder;
+
+    void collectFunctions(Node& node);
+    void collectCalls(Function& function, Node& node);
+};
+
+#endif//VUG_CALLGRAPH_HPP
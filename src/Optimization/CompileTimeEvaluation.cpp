@@ -0,0 +1,159 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CompileTimeEvaluation.hpp"
+
+#include <algorithm>
+
+#include "AST/ASTTraversal.hpp"
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Evaluator/Evaluator.hpp"
+#include "Evaluator/Objects/BooleanObject.hpp"
+#include "Evaluator/Objects/IntegerObject.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/ConstantFolding.hpp"
+
+namespace {
+    bool containsPrint(Node& node) {
+        stackGuard();
+
+        bool result = node.kind == Node::Kind::Print;
+        forEachChild(node, [&result](Node& child) {
+            result = result || containsPrint(child);
+        });
+        return result;
+    }
+}// namespace
+
+void CompileTimeEvaluation::run() {
+    stackGuard();
+
+    _callGraph = std::make_unique<CallGraph>(_ast);
+    findImpureFunctions();
+
+    for (auto function: _callGraph->getBottomUpOrder()) {
+        evaluateCalls(*function->declaration->definition);
+    }
+}
+
+void CompileTimeEvaluation::findImpureFunctions() {
+    stackGuard();
+
+    for (auto function: _callGraph->getBottomUpOrder()) {
+        if (containsPrint(*function->declaration->definition)) {
+            _impureFunctions.insert(function);
+        }
+    }
+
+    // Callers of impure functions are impure, cycles may take several rounds
+    bool isChanged = true;
+    while (isChanged) {
+        isChanged = false;
+        for (auto function: _callGraph->getBottomUpOrder()) {
+            if (_impureFunctions.contains(function)) {
+                continue;
+            }
+            auto isImpure = std::any_of(function->callees.begin(), function->callees.end(), [this](auto callee) {
+                return _impureFunctions.contains(callee);
+            });
+            if (isImpure) {
+                _impureFunctions.insert(function);
+                isChanged = true;
+            }
+        }
+    }
+}
+void CompileTimeEvaluation::evaluateCalls(Node& node) {
+    stackGuard();
+
+    forEachExpressionSlot(node, [this](NodePtr<Expression>& expression) {
+        evaluateCalls(expression);
+    });
+    forEachChild(node, [this](Node& child) {
+        if (child.isStatement()) {
+            evaluateCalls(child);
+        }
+    });
+}
+void CompileTimeEvaluation::evaluateCalls(NodePtr<Expression>& node) {
+    stackGuard();
+
+    // Arguments first, so nested calls may become literals
+    forEachExpressionSlot(*node, [this](NodePtr<Expression>& expression) {
+        evaluateCalls(expression);
+    });
+
+    if (node->kind != Node::Kind::CallFunction) {
+        return;
+    }
+    auto& call = static_cast<CallFunction&>(*node);
+
+    auto callee = _callGraph->getFunction(call.symbolRef);
+    if (callee == nullptr ||
+        _impureFunctions.contains(callee) ||
+        !ASTBuilder::canMaterialize(call.exprType)) {
+        return;
+    }
+
+    std::vector<int64_t> arguments;
+    for (const auto& argument: call.arguments) {
+        auto value = getConstantValue(*argument);
+        if (!value || !ASTBuilder::canMaterialize(argument->exprType)) {
+            return;
+        }
+        arguments.push_back(*value);
+    }
+
+    auto result = evaluateCall(call, arguments);
+    if (result) {
+        node = _builder.constant(*result, call.exprType, call.sourceLocation);
+    }
+}
+std::optional<int64_t> CompileTimeEvaluation::evaluateCall(const CallFunction& node, const std::vector<int64_t>& arguments) {
+    stackGuard();
+
+    auto key = std::make_pair(static_cast<const FunctionSymbol*>(node.symbolRef), arguments);
+    auto cached = _results.find(key);
+    if (cached != _results.end()) {
+        return cached->second;
+    }
+    if (_steps >= totalStepBudget) {
+        return std::nullopt;
+    }
+
+    std::vector<std::unique_ptr<Object>> objects;
+    for (size_t index = 0; index < arguments.size(); ++index) {
+        if (node.arguments[index]->exprType->isInteger()) {
+            objects.push_back(std::make_unique<IntegerObject<int32_t>>(static_cast<int32_t>(arguments[index])));
+        } else {
+            objects.push_back(std::make_unique<BooleanObject>(arguments[index] != 0));
+        }
+    }
+
+    auto evaluator = Evaluator(_ast, _context);
+    auto object = evaluator.evaluateCall(*node.symbolRef,
+                                         std::move(objects),
+                                         std::min(callStepBudget, totalStepBudget - _steps));
+    _steps += evaluator.getSteps();
+
+    std::optional<int64_t> result;
+    if (object != nullptr) {
+        result = node.exprType->isInteger() ? object->to<const IntegerObject<int32_t>&>().getValue()
+                                            : object->to<const BooleanObject&>().getValue();
+    }
+    _results[key] = result;
+
+    auto diagnostic = Diagnostic();
+    diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Info,
+                                            result ? std::format("evaluated call to '{}' at compile time: {} ({} steps)",
+                                                                 node.name,
+                                                                 *result,
+                                                                 evaluator.getSteps())
+                                                   : std::format("call to '{}' left to run time after {} steps",
+                                                                 node.name,
+                                                                 evaluator.getSteps()),
+                                            {node.sourceLocation}));
+    _diagnosticManager.report(diagnostic);
+
+    return result;
+}
@@ -0,0 +1,65 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_COMPILETIMEEVALUATION_HPP
+#define VUG_COMPILETIMEEVALUATION_HPP
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "AST/ASTArena.hpp"
+#include "AST/ASTNodesForward.hpp"
+#include "Misc/PassProperty.hpp"
+#include "Optimization/ASTBuilder.hpp"
+#include "Optimization/CallGraph.hpp"
+
+class DiagnosticManager;
+class SymbolContext;
+
+// Replaces calls of pure functions with literal arguments by their result, computed by the evaluator.
+// A function is pure when neither it nor anything it calls prints. Calls that trap, recurse too deep
+// or run out of steps keep being calls and behave at run time as they always did.
+class CompileTimeEvaluation {
+public:
+    static constexpr std::string_view name = "compile-time-evaluation";
+    static constexpr auto required = PassProperty::LocalsResolved | PassProperty::ConstantsPropagated;
+    static constexpr auto provided = PassProperty::None;
+    static constexpr auto invalidated = PassProperty::ConstantsPropagated;
+
+    // Budgets in evaluated statements and expressions
+    static constexpr uint64_t callStepBudget = 10'000'000;
+    static constexpr uint64_t totalStepBudget = 50'000'000;
+
+    CompileTimeEvaluation(Node& ast,
+                          SymbolContext& context,
+                          DiagnosticManager& diagnosticManager)
+        : _ast(ast),
+          _context(context),
+          _builder(context),
+          _diagnosticManager(diagnosticManager) {}
+
+    void run();
+
+protected:
+    Node& _ast;
+    SymbolContext& _context;
+    ASTBuilder _builder;
+    DiagnosticManager& _diagnosticManager;
+
+    std::unique_ptr<CallGraph> _callGraph;
+    std::unordered_set<const CallGraph::Function*> _impureFunctions;
+    // Results by callee and arguments, calls that couldn't be evaluated have no value
+    std::map<std::pair<const FunctionSymbol*, std::vector<int64_t>>, std::optional<int64_t>> _results;
+    uint64_t _steps{0};
+
+    void findImpureFunctions();
+    void evaluateCalls(Node& node);
+    void evaluateCalls(NodePtr<Expression>& node);
+    std::optional<int64_t> evaluateCall(const CallFunction& node, const std::vector<int64_t>& arguments);
+};
+
+#endif//VUG_COMPILETIMEEVALUATION_HPP
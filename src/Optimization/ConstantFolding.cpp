@@ -0,0 +1,186 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ConstantFolding.hpp"
+
+#include "AST/ASTNodes.hpp"
+#include "Misc/Stack.hpp"
+#include "Semantic/Type.hpp"
+
+namespace {
+    bool isSigned(const Type* type) {
+        return !type->isInteger() || static_cast<const IntegerType*>(type)->isIsSigned();
+    }
+    int64_t getMinimum(const Type* type) {
+        auto bits = static_cast<const IntegerType*>(type)->getBits();
+        return static_cast<int64_t>(UINT64_MAX << (bits - 1));
+    }
+}// namespace
+
+int64_t wrapValue(int64_t value, const Type* type) {
+    if (!type->isInteger()) {
+        return value != 0;
+    }
+
+    auto integerType = static_cast<const IntegerType*>(type);
+    auto bits = integerType->getBits();
+    if (bits >= 64) {
+        return value;
+    }
+
+    auto shift = 64 - bits;
+    auto raw = static_cast<uint64_t>(value) << shift;
+    return integerType->isIsSigned() ? static_cast<int64_t>(raw) >> shift
+                                     : static_cast<int64_t>(raw >> shift);
+}
+bool mayDivisionTrap(int64_t right, const Type* operandType) {
+    return right == 0 || (right == -1 && isSigned(operandType));
+}
+
+std::optional<int64_t> foldBinaryOperation(LexemType operation, int64_t left, int64_t right, const Type* operandType) {
+    if (!operandType->isInteger()) {
+        switch (operation) {
+            case LexemType::LogicAnd:
+                return left != 0 && right != 0;
+            case LexemType::LogicOr:
+                return left != 0 || right != 0;
+            default:
+                return std::nullopt;
+        }
+    }
+
+    auto isSignedOperation = isSigned(operandType);
+    auto unsignedLeft = static_cast<uint64_t>(left);
+    auto unsignedRight = static_cast<uint64_t>(right);
+
+    switch (operation) {
+        case LexemType::Equal:
+            return left == right;
+        case LexemType::Unequal:
+            return left != right;
+        case LexemType::Less:
+            return isSignedOperation ? left < right : unsignedLeft < unsignedRight;
+        case LexemType::LessEqual:
+            return isSignedOperation ? left <= right : unsignedLeft <= unsignedRight;
+        case LexemType::Greater:
+            return isSignedOperation ? left > right : unsignedLeft > unsignedRight;
+        case LexemType::GreaterEqual:
+            return isSignedOperation ? left >= right : unsignedLeft >= unsignedRight;
+        case LexemType::Plus:
+            return wrapValue(static_cast<int64_t>(unsignedLeft + unsignedRight), operandType);
+        case LexemType::Minus:
+            return wrapValue(static_cast<int64_t>(unsignedLeft - unsignedRight), operandType);
+        case LexemType::Multiply:
+            return wrapValue(static_cast<int64_t>(unsignedLeft * unsignedRight), operandType);
+        case LexemType::Divide:
+        case LexemType::Remainder:
+            if (right == 0 || (isSignedOperation && right == -1 && left == getMinimum(operandType))) {
+                return std::nullopt;
+            }
+            if (isSignedOperation) {
+                return wrapValue(operation == LexemType::Divide ? left / right : left % right, operandType);
+            }
+            return wrapValue(static_cast<int64_t>(operation == LexemType::Divide ? unsignedLeft / unsignedRight
+                                                                                 : unsignedLeft % unsignedRight),
+                             operandType);
+        default:
+            return std::nullopt;
+    }
+}
+std::optional<int64_t> foldPrefixOperation(LexemType operation, int64_t value, const Type* type) {
+    switch (operation) {
+        case LexemType::Minus:
+            return type->isInteger() ? std::optional(wrapValue(static_cast<int64_t>(0 - static_cast<uint64_t>(value)), type))
+                                     : std::nullopt;
+        case LexemType::Not:
+            return type->isInteger() ? std::nullopt : std::optional<int64_t>(value == 0);
+        default:
+            return std::nullopt;
+    }
+}
+
+std::optional<int64_t> getConstantValue(const Expression& expression) {
+    stackGuard();
+
+    switch (expression.kind) {
+        case Node::Kind::Number: {
+            const auto& number = static_cast<const Number&>(expression).number;
+            if (number.size() > 10) {
+                return std::nullopt;
+            }
+            auto value = std::stoll(std::string(number));
+            if (value > INT32_MAX) {
+                return std::nullopt;
+            }
+            return value;
+        }
+        case Node::Kind::PrefixOperation: {
+            const auto& operation = static_cast<const PrefixOperation&>(expression);
+            auto value = getConstantValue(*operation.right);
+            if (!value) {
+                return std::nullopt;
+            }
+            return foldPrefixOperation(operation.operationType, *value, operation.exprType);
+        }
+        case Node::Kind::BinaryOperation: {
+            const auto& operation = static_cast<const BinaryOperation&>(expression);
+            auto left = getConstantValue(*operation.left);
+            auto right = getConstantValue(*operation.right);
+            if (!left || !right) {
+                return std::nullopt;
+            }
+            return foldBinaryOperation(operation.operationToken, *left, *right, operation.left->exprType);
+        }
+        default:
+            return std::nullopt;
+    }
+}
+bool isSpeculatable(const Expression& expression) {
+    stackGuard();
+
+    switch (expression.kind) {
+        case Node::Kind::Number:
+        case Node::Kind::Identifier:
+            return true;
+        case Node::Kind::PrefixOperation: {
+            const auto& operation = static_cast<const PrefixOperation&>(expression);
+            auto isInteger = operation.right->exprType->isInteger();
+            auto isDefined = (operation.operationType == LexemType::Minus && isInteger) ||
+                             (operation.operationType == LexemType::Not && !isInteger);
+            return isDefined && isSpeculatable(*operation.right);
+        }
+        case Node::Kind::BinaryOperation: {
+            const auto& operation = static_cast<const BinaryOperation&>(expression);
+            auto operandType = operation.left->exprType;
+            if (!isSpeculatable(*operation.left) || !isSpeculatable(*operation.right)) {
+                return false;
+            }
+            if (!operandType->isInteger()) {
+                return operation.operationToken == LexemType::LogicAnd || operation.operationToken == LexemType::LogicOr;
+            }
+
+            switch (operation.operationToken) {
+                case LexemType::Divide:
+                case LexemType::Remainder: {
+                    // A trap must stay where it is
+                    auto divisor = getConstantValue(*operation.right);
+                    return divisor && !mayDivisionTrap(*divisor, operandType);
+                }
+                case LexemType::Equal:
+                case LexemType::Unequal:
+                case LexemType::Less:
+                case LexemType::LessEqual:
+                case LexemType::Greater:
+                case LexemType::GreaterEqual:
+                case LexemType::Plus:
+                case LexemType::Minus:
+                case LexemType::Multiply:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,29 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_CONSTANTFOLDING_HPP
+#define VUG_CONSTANTFOLDING_HPP
+
+#include <cstdint>
+#include <optional>
+
+#include "AST/ASTNodesForward.hpp"
+#include "Lexing/Token.hpp"
+
+class Type;
+
+// Folding follows the evaluator: integers wrap to the width of their type and booleans are 0 or 1.
+// Operations the evaluator rejects or that trap (division by zero, minimum / -1) don't fold.
+std::optional<int64_t> foldBinaryOperation(LexemType operation, int64_t left, int64_t right, const Type* operandType);
+std::optional<int64_t> foldPrefixOperation(LexemType operation, int64_t value, const Type* type);
+int64_t wrapValue(int64_t value, const Type* type);
+// Whether the division of any `left` by `right` may trap
+bool mayDivisionTrap(int64_t right, const Type* operandType);
+
+// Value of an expression built from literals only
+std::optional<int64_t> getConstantValue(const Expression& expression);
+// Evaluating the expression has no effect but its value: no calls, no traps and no operations the evaluator rejects,
+// so it may be evaluated earlier, more often or not at all
+bool isSpeculatable(const Expression& expression);
+
+#endif//VUG_CONSTANTFOLDING_HPP
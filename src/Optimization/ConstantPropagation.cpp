@@ -0,0 +1,456 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ConstantPropagation.hpp"
+
+#include <algorithm>
+
+#include "AST/ASTTraversal.hpp"
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/ConstantFolding.hpp"
+
+ConstantPropagation::Value ConstantPropagation::Value::meet(const Value& other) const {
+    if (kind == Kind::Undefined) {
+        return other;
+    }
+    if (other.kind == Kind::Undefined || *this == other) {
+        return *this;
+    }
+    return {Kind::Overdefined, 0};
+}
+
+void ConstantPropagation::run() {
+    stackGuard();
+
+    _callGraph = std::make_unique<CallGraph>(_ast);
+
+    auto mainMembers = static_cast<ModuleDeclaration&>(_ast).symbolRef->findMember("main");
+    if (mainMembers.empty() || mainMembers[0]->getKind() != Symbol::Kind::Function) {
+        return;
+    }
+    auto main = _callGraph->getFunction(static_cast<FunctionSymbol*>(mainMembers[0]));
+    if (main == nullptr) {
+        return;
+    }
+
+    _functions[main].isReachable = true;
+    enqueue(*main);
+    while (!_worklist.empty()) {
+        auto function = _worklist.back();
+        _worklist.pop_back();
+        analyzeFunction(*function);
+    }
+
+    // Values only move down the lattice, so one more round at the fixpoint sees the final ones
+    _values.clear();
+    _reached.clear();
+    for (auto function: _callGraph->getBottomUpOrder()) {
+        if (_functions[function].isReachable) {
+            analyzeFunction(*function);
+        }
+    }
+    _worklist.clear();
+
+    for (auto function: _callGraph->getBottomUpOrder()) {
+        if (!_functions[function].isReachable) {
+            continue;
+        }
+
+        auto removed = rewriteBlock(*function->declaration->definition);
+        if (removed > 0) {
+            auto diagnostic = Diagnostic();
+            diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Info,
+                                                    std::format("constant propagation removed {} nodes from '{}'",
+                                                                removed,
+                                                                function->declaration->name),
+                                                    {function->declaration->sourceLocation}));
+            _diagnosticManager.report(diagnostic);
+        }
+    }
+}
+
+void ConstantPropagation::meet(std::optional<State>& state, const std::optional<State>& other) {
+    if (!other) {
+        return;
+    }
+    if (!state) {
+        state = other;
+        return;
+    }
+
+    for (const auto& [symbol, value]: *other) {
+        auto& current = (*state)[symbol];
+        current = current.meet(value);
+    }
+}
+
+void ConstantPropagation::enqueue(CallGraph::Function& function) {
+    if (std::find(_worklist.begin(), _worklist.end(), &function) == _worklist.end()) {
+        _worklist.push_back(&function);
+    }
+}
+void ConstantPropagation::analyzeFunction(CallGraph::Function& function) {
+    stackGuard();
+
+    _currentFunction = &function;
+
+    std::optional<State> state = State();
+    for (const auto parameter: function.declaration->symbolRef->getArguments()) {
+        (*state)[parameter] = _parameters[parameter];
+    }
+    analyzeBlock(*function.declaration->definition, state);
+
+    _currentFunction = nullptr;
+}
+void ConstantPropagation::analyzeBlock(StatementsBlock& node, std::optional<State>& state) {
+    stackGuard();
+
+    for (const auto& statement: node.statements) {
+        if (!state) {
+            return;
+        }
+        analyzeStatement(*statement, state);
+    }
+}
+void ConstantPropagation::analyzeStatement(Statement& node, std::optional<State>& state) {
+    stackGuard();
+
+    _reached.insert(&node);
+
+    switch (node.kind) {
+        case Node::Kind::StatementBlock:
+            analyzeBlock(static_cast<StatementsBlock&>(node), state);
+            break;
+        case Node::Kind::Assign: {
+            auto& assign = static_cast<Assign&>(node);
+            auto value = evaluate(*assign.value, *state);
+            (*state)[assign.symbolRef] = value;
+            break;
+        }
+        case Node::Kind::LocalVarDeclaration: {
+            auto& declaration = static_cast<LocalVariableDeclaration&>(node);
+            auto value = evaluate(*declaration.value, *state);
+            (*state)[declaration.symbolRef] = value;
+            break;
+        }
+        case Node::Kind::Print:
+            evaluate(*static_cast<Print&>(node).expression, *state);
+            break;
+        case Node::Kind::Return: {
+            auto value = evaluate(*static_cast<Return&>(node).returnExpression, *state);
+
+            auto& function = _functions[_currentFunction];
+            auto result = function.result.meet(value);
+            if (result != function.result) {
+                function.result = result;
+                for (auto caller: function.callers) {
+                    enqueue(*caller);
+                }
+            }
+            state.reset();
+            break;
+        }
+        case Node::Kind::Break:
+            meet(_breakStates[static_cast<Break&>(node).breakedStmt], state);
+            state.reset();
+            break;
+        case Node::Kind::If: {
+            auto& ifNode = static_cast<If&>(node);
+            auto condition = evaluate(*ifNode.condition, *state);
+
+            std::optional<State> thenState;
+            std::optional<State> elseState;
+            if (condition.kind == Value::Kind::Overdefined || (condition.isConstant() && condition.constant != 0)) {
+                thenState = state;
+            }
+            if (condition.kind == Value::Kind::Overdefined || (condition.isConstant() && condition.constant == 0)) {
+                elseState = state;
+            }
+
+            if (thenState) {
+                analyzeBlock(*ifNode.then, thenState);
+            }
+            if (elseState && ifNode.elseThen != nullptr) {
+                analyzeStatement(*ifNode.elseThen, elseState);
+            }
+
+            state = std::move(thenState);
+            meet(state, elseState);
+            break;
+        }
+        case Node::Kind::While: {
+            auto& loop = static_cast<While&>(node);
+            auto head = state;
+            std::optional<State> exit;
+            _breakStates[&loop].reset();
+
+            while (true) {
+                auto condition = evaluate(*loop.condition, *head);
+
+                std::optional<State> body;
+                if (condition.kind == Value::Kind::Overdefined || (condition.isConstant() && condition.constant != 0)) {
+                    body = head;
+                }
+                if (condition.kind == Value::Kind::Overdefined || (condition.isConstant() && condition.constant == 0)) {
+                    meet(exit, head);
+                }
+
+                if (body) {
+                    analyzeBlock(*loop.body, body);
+                }
+
+                auto next = head;
+                meet(next, body);
+                if (next == head) {
+                    break;
+                }
+                head = std::move(next);
+            }
+
+            meet(exit, _breakStates[&loop]);
+            state = std::move(exit);
+            break;
+        }
+        default:
+            break;
+    }
+}
+ConstantPropagation::Value ConstantPropagation::evaluate(Expression& node, State& state) {
+    stackGuard();
+
+    Value value;
+    switch (node.kind) {
+        case Node::Kind::Number: {
+            auto constant = getConstantValue(node);
+            value = constant ? Value{Value::Kind::Constant, *constant} : Value{Value::Kind::Overdefined, 0};
+            break;
+        }
+        case Node::Kind::Identifier: {
+            auto local = state.find(static_cast<Identifier&>(node).symbolRef);
+            if (local != state.end()) {
+                value = local->second;
+            }
+            break;
+        }
+        case Node::Kind::PrefixOperation: {
+            auto& operation = static_cast<PrefixOperation&>(node);
+            auto right = evaluate(*operation.right, state);
+
+            if (right.isConstant()) {
+                auto folded = foldPrefixOperation(operation.operationType, right.constant, operation.exprType);
+                value = folded ? Value{Value::Kind::Constant, *folded} : Value{Value::Kind::Overdefined, 0};
+            } else {
+                value = right;
+            }
+            break;
+        }
+        case Node::Kind::BinaryOperation: {
+            auto& operation = static_cast<BinaryOperation&>(node);
+            auto left = evaluate(*operation.left, state);
+            auto right = evaluate(*operation.right, state);
+
+            auto isAbsorbed = [&](int64_t absorbing) {
+                return (left.isConstant() && left.constant == absorbing) ||
+                       (right.isConstant() && right.constant == absorbing);
+            };
+
+            if (operation.operationToken == LexemType::LogicAnd && isAbsorbed(0)) {
+                value = {Value::Kind::Constant, 0};
+            } else if (operation.operationToken == LexemType::LogicOr && isAbsorbed(1)) {
+                value = {Value::Kind::Constant, 1};
+            } else if (operation.operationToken == LexemType::Multiply && isAbsorbed(0)) {
+                value = {Value::Kind::Constant, 0};
+            } else if (left.kind == Value::Kind::Overdefined || right.kind == Value::Kind::Overdefined) {
+                value = {Value::Kind::Overdefined, 0};
+            } else if (left.isConstant() && right.isConstant()) {
+                auto folded = foldBinaryOperation(operation.operationToken,
+                                                  left.constant,
+                                                  right.constant,
+                                                  operation.left->exprType);
+                value = folded ? Value{Value::Kind::Constant, *folded} : Value{Value::Kind::Overdefined, 0};
+            }
+            break;
+        }
+        case Node::Kind::CallFunction:
+            value = evaluateCall(static_cast<CallFunction&>(node), state);
+            break;
+        default:
+            value = {Value::Kind::Overdefined, 0};
+            break;
+    }
+
+    auto& recorded = _values[&node];
+    recorded = recorded.meet(value);
+    return value;
+}
+ConstantPropagation::Value ConstantPropagation::evaluateCall(CallFunction& node, State& state) {
+    stackGuard();
+
+    std::vector<Value> arguments;
+    for (const auto& argument: node.arguments) {
+        arguments.push_back(evaluate(*argument, state));
+    }
+
+    auto callee = _callGraph->getFunction(node.symbolRef);
+    if (callee == nullptr) {
+        return {Value::Kind::Overdefined, 0};
+    }
+
+    auto& function = _functions[callee];
+    function.callers.insert(_currentFunction);
+
+    auto isChanged = !function.isReachable;
+    function.isReachable = true;
+
+    const auto& parameters = node.symbolRef->getArguments();
+    for (size_t index = 0; index < parameters.size(); ++index) {
+        auto& parameter = _parameters[parameters[index]];
+        auto value = parameter.meet(arguments[index]);
+        if (value != parameter) {
+            parameter = value;
+            isChanged = true;
+        }
+    }
+
+    if (isChanged) {
+        enqueue(*callee);
+    }
+    return function.result;
+}
+
+size_t ConstantPropagation::rewriteBlock(StatementsBlock& node) {
+    stackGuard();
+
+    size_t removed = 0;
+    for (auto statement = node.statements.begin(); statement != node.statements.end();) {
+        if (!_reached.contains(statement->get())) {
+            removed += getNodeCount(**statement);
+            statement = node.statements.erase(statement);
+            continue;
+        }
+
+        removed += rewriteStatement(*statement);
+        if (*statement == nullptr) {
+            statement = node.statements.erase(statement);
+        } else {
+            ++statement;
+        }
+    }
+    return removed;
+}
+size_t ConstantPropagation::rewriteStatement(NodePtr<Statement>& node) {
+    stackGuard();
+
+    switch (node->kind) {
+        case Node::Kind::StatementBlock:
+            return rewriteBlock(static_cast<StatementsBlock&>(*node));
+        case Node::Kind::Assign:
+            return rewriteExpression(static_cast<Assign&>(*node).value);
+        case Node::Kind::LocalVarDeclaration:
+            return rewriteExpression(static_cast<LocalVariableDeclaration&>(*node).value);
+        case Node::Kind::Print:
+            return rewriteExpression(static_cast<Print&>(*node).expression);
+        case Node::Kind::Return:
+            return rewriteExpression(static_cast<Return&>(*node).returnExpression);
+        case Node::Kind::If: {
+            auto& ifNode = static_cast<If&>(*node);
+            auto condition = getValue(*ifNode.condition);
+
+            if (condition.isConstant() && isRemovable(*ifNode.condition)) {
+                auto count = getNodeCount(*node);
+                node = condition.constant != 0 ? std::move(ifNode.then) : std::move(ifNode.elseThen);
+                if (node == nullptr) {
+                    return count;
+                }
+                auto removed = count - getNodeCount(*node);
+                return removed + rewriteStatement(node);
+            }
+
+            auto removed = rewriteExpression(ifNode.condition) + rewriteBlock(*ifNode.then);
+            if (ifNode.elseThen != nullptr) {
+                if (_reached.contains(ifNode.elseThen.get())) {
+                    removed += rewriteStatement(ifNode.elseThen);
+                } else {
+                    removed += getNodeCount(*ifNode.elseThen);
+                    ifNode.elseThen = nullptr;
+                }
+            }
+            return removed;
+        }
+        case Node::Kind::While: {
+            auto& loop = static_cast<While&>(*node);
+            auto condition = getValue(*loop.condition);
+
+            if (condition.isConstant() && condition.constant == 0 && isRemovable(*loop.condition)) {
+                auto count = getNodeCount(*node);
+                node = nullptr;
+                return count;
+            }
+            return rewriteExpression(loop.condition) + rewriteBlock(*loop.body);
+        }
+        default:
+            return 0;
+    }
+}
+size_t ConstantPropagation::rewriteExpression(NodePtr<Expression>& node) {
+    stackGuard();
+
+    auto value = getValue(*node);
+    if (value.isConstant() && ASTBuilder::canMaterialize(node->exprType) && isRemovable(*node)) {
+        auto replacement = _builder.constant(value.constant, node->exprType, node->sourceLocation);
+        auto count = getNodeCount(*node);
+        auto replacementCount = getNodeCount(*replacement);
+
+        if (replacementCount >= count) {
+            return 0;
+        }
+        node = std::move(replacement);
+        return count - replacementCount;
+    }
+
+    size_t removed = 0;
+    switch (node->kind) {
+        case Node::Kind::BinaryOperation:
+            removed += rewriteExpression(static_cast<BinaryOperation&>(*node).left);
+            removed += rewriteExpression(static_cast<BinaryOperation&>(*node).right);
+            break;
+        case Node::Kind::PrefixOperation:
+            removed += rewriteExpression(static_cast<PrefixOperation&>(*node).right);
+            break;
+        case Node::Kind::CallFunction:
+            for (auto& argument: static_cast<CallFunction&>(*node).arguments) {
+                removed += rewriteExpression(argument);
+            }
+            break;
+        default:
+            break;
+    }
+    return removed;
+}
+ConstantPropagation::Value ConstantPropagation::getValue(const Expression& node) const {
+    auto value = _values.find(&node);
+    return value != _values.end() ? value->second : Value();
+}
+bool ConstantPropagation::isRemovable(const Expression& node) const {
+    stackGuard();
+
+    switch (node.kind) {
+        case Node::Kind::CallFunction:
+            return false;
+        case Node::Kind::PrefixOperation:
+            return isRemovable(*static_cast<const PrefixOperation&>(node).right);
+        case Node::Kind::BinaryOperation: {
+            const auto& operation = static_cast<const BinaryOperation&>(node);
+            if (operation.operationToken == LexemType::Divide || operation.operationToken == LexemType::Remainder) {
+                auto right = getValue(*operation.right);
+                if (!right.isConstant() || mayDivisionTrap(right.constant, operation.left->exprType)) {
+                    return false;
+                }
+            }
+            return isRemovable(*operation.left) && isRemovable(*operation.right);
+        }
+        default:
+            return true;
+    }
+}
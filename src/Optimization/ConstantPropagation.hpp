@@ -0,0 +1,104 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_CONSTANTPROPAGATION_HPP
+#define VUG_CONSTANTPROPAGATION_HPP
+
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "AST/ASTArena.hpp"
+#include "AST/ASTNodesForward.hpp"
+#include "Misc/PassProperty.hpp"
+#include "Optimization/ASTBuilder.hpp"
+#include "Optimization/CallGraph.hpp"
+
+class DiagnosticManager;
+class SymbolContext;
+
+// Interprocedural sparse conditional constant propagation.
+// Starting from main, locals are tracked along the structured control flow of each function and
+// branches on known conditions are followed one way only; parameters meet over every call reached
+// and results over every return. Known values then replace expressions, and statements, branches
+// and loops that never run are deleted.
+class ConstantPropagation {
+public:
+    static constexpr std::string_view name = "constant-propagation";
+    static constexpr auto required = PassProperty::LocalsResolved;
+    static constexpr auto provided = PassProperty::ConstantsPropagated;
+    static constexpr auto invalidated = PassProperty::None;
+
+    struct Value {
+        enum class Kind {
+            // Not seen yet, optimistically any constant
+            Undefined,
+            Constant,
+            Overdefined,
+        };
+
+        Kind kind{Kind::Undefined};
+        int64_t constant{0};
+
+        [[nodiscard]] bool isConstant() const {
+            return kind == Kind::Constant;
+        }
+        [[nodiscard]] Value meet(const Value& other) const;
+        bool operator==(const Value& other) const = default;
+    };
+
+    ConstantPropagation(Node& ast,
+                        SymbolContext& context,
+                        DiagnosticManager& diagnosticManager)
+        : _ast(ast),
+          _builder(context),
+          _diagnosticManager(diagnosticManager) {}
+
+    void run();
+
+protected:
+    // Values of locals on one path, no state means the path never gets there
+    using State = std::unordered_map<const LocalVariableSymbol*, Value>;
+
+    struct FunctionState {
+        bool isReachable{false};
+        Value result;
+        std::unordered_set<CallGraph::Function*> callers;
+    };
+
+    Node& _ast;
+    ASTBuilder _builder;
+    DiagnosticManager& _diagnosticManager;
+
+    std::unique_ptr<CallGraph> _callGraph;
+    std::unordered_map<const CallGraph::Function*, FunctionState> _functions;
+    std::unordered_map<const LocalVariableSymbol*, Value> _parameters;
+    std::vector<CallGraph::Function*> _worklist;
+    CallGraph::Function* _currentFunction{nullptr};
+
+    // Meet over every evaluation, filled by the last round over the reachable functions
+    std::unordered_map<const Expression*, Value> _values;
+    std::unordered_set<const Statement*> _reached;
+    std::unordered_map<const Statement*, std::optional<State>> _breakStates;
+
+    static void meet(std::optional<State>& state, const std::optional<State>& other);
+
+    void enqueue(CallGraph::Function& function);
+    void analyzeFunction(CallGraph::Function& function);
+    void analyzeBlock(StatementsBlock& node, std::optional<State>& state);
+    void analyzeStatement(Statement& node, std::optional<State>& state);
+    Value evaluate(Expression& node, State& state);
+    Value evaluateCall(CallFunction& node, State& state);
+
+    size_t rewriteBlock(StatementsBlock& node);
+    // Resets the statement when it is deleted
+    size_t rewriteStatement(NodePtr<Statement>& node);
+    size_t rewriteExpression(NodePtr<Expression>& node);
+    [[nodiscard]] Value getValue(const Expression& node) const;
+    [[nodiscard]] bool isRemovable(const Expression& node) const;
+};
+
+#endif//VUG_CONSTANTPROPAGATION_HPP
@@ -0,0 +1,263 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DeadCodeElimination.hpp"
+
+#include <algorithm>
+
+#include "AST/ASTTraversal.hpp"
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/ConstantFolding.hpp"
+#include "Semantic/Symbol.hpp"
+
+void DeadCodeElimination::run() {
+    stackGuard();
+
+    _callGraph = std::make_unique<CallGraph>(_ast);
+    findReachableFunctions();
+
+    for (auto function: _callGraph->getBottomUpOrder()) {
+        if (!_reachable.empty() && !_reachable.contains(function)) {
+            continue;
+        }
+
+        auto& definition = *function->declaration->definition;
+        _removed = 0;
+        removeUnreachable(definition);
+        analyzeBlock(definition, {}, true);
+
+        if (_removed > 0) {
+            auto diagnostic = Diagnostic();
+            diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Info,
+                                                    std::format("dead code elimination removed {} statements from '{}'",
+                                                                _removed,
+                                                                function->declaration->name),
+                                                    {function->declaration->sourceLocation}));
+            _diagnosticManager.report(diagnostic);
+        }
+    }
+
+    if (!_reachable.empty()) {
+        removeFunctions(*static_cast<ModuleDeclaration&>(_ast).body);
+    }
+}
+
+void DeadCodeElimination::findReachableFunctions() {
+    auto mainMembers = static_cast<ModuleDeclaration&>(_ast).symbolRef->findMember("main");
+    if (mainMembers.empty() || mainMembers[0]->getKind() != Symbol::Kind::Function) {
+        return;
+    }
+    auto main = _callGraph->getFunction(static_cast<FunctionSymbol*>(mainMembers[0]));
+    if (main == nullptr) {
+        return;
+    }
+
+    std::vector<CallGraph::Function*> worklist{main};
+    _reachable.insert(main);
+    while (!worklist.empty()) {
+        auto function = worklist.back();
+        worklist.pop_back();
+
+        for (auto callee: function->callees) {
+            if (_reachable.insert(callee).second) {
+                worklist.push_back(callee);
+            }
+        }
+    }
+}
+void DeadCodeElimination::removeFunctions(DeclarationsBlock& node) {
+    stackGuard();
+
+    std::erase_if(node.declarations, [this](NodePtr<Declaration>& declaration) {
+        if (declaration->kind == Node::Kind::ModuleDeclaration) {
+            removeFunctions(*static_cast<ModuleDeclaration&>(*declaration).body);
+        } else if (declaration->kind == Node::Kind::DeclarationsBlock) {
+            removeFunctions(static_cast<DeclarationsBlock&>(*declaration));
+        }
+        if (declaration->kind != Node::Kind::FunctionDeclaration) {
+            return false;
+        }
+
+        auto& function = static_cast<FunctionDeclaration&>(*declaration);
+        if (_reachable.contains(_callGraph->getFunction(function.symbolRef))) {
+            return false;
+        }
+
+        auto diagnostic = Diagnostic();
+        diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Info,
+                                                std::format("removed unreachable function '{}'", function.name),
+                                                {function.sourceLocation}));
+        _diagnosticManager.report(diagnostic);
+        return true;
+    });
+}
+
+void DeadCodeElimination::removeUnreachable(Node& node) {
+    stackGuard();
+
+    forEachChild(node, [this](Node& child) {
+        if (child.isStatement()) {
+            removeUnreachable(child);
+        }
+    });
+
+    if (node.kind != Node::Kind::StatementBlock) {
+        return;
+    }
+    auto& statements = static_cast<StatementsBlock&>(node).statements;
+    auto terminator = std::find_if(statements.begin(), statements.end(), [](const auto& statement) {
+        return isTerminator(*statement);
+    });
+    if (terminator != statements.end()) {
+        _removed += static_cast<size_t>(statements.end() - terminator - 1);
+        statements.erase(terminator + 1, statements.end());
+    }
+}
+bool DeadCodeElimination::isTerminator(const Statement& node) {
+    switch (node.kind) {
+        case Node::Kind::Return:
+        case Node::Kind::Break:
+            return true;
+        case Node::Kind::StatementBlock: {
+            const auto& statements = static_cast<const StatementsBlock&>(node).statements;
+            return !statements.empty() && isTerminator(*statements.back());
+        }
+        case Node::Kind::If: {
+            const auto& ifNode = static_cast<const If&>(node);
+            return ifNode.elseThen != nullptr && isTerminator(*ifNode.then) && isTerminator(*ifNode.elseThen);
+        }
+        default:
+            return false;
+    }
+}
+
+DeadCodeElimination::Liveness DeadCodeElimination::analyzeBlock(StatementsBlock& node, Liveness live, bool isRewriting) {
+    stackGuard();
+
+    for (auto statement = node.statements.rbegin(); statement != node.statements.rend(); ++statement) {
+        live = analyzeStatement(*statement, std::move(live), isRewriting);
+    }
+
+    if (isRewriting) {
+        std::erase(node.statements, nullptr);
+    }
+    return live;
+}
+DeadCodeElimination::Liveness DeadCodeElimination::analyzeStatement(NodePtr<Statement>& node,
+                                                                    Liveness live,
+                                                                    bool isRewriting) {
+    stackGuard();
+
+    switch (node->kind) {
+        case Node::Kind::StatementBlock:
+            return analyzeBlock(static_cast<StatementsBlock&>(*node), std::move(live), isRewriting);
+        case Node::Kind::Assign: {
+            auto& assign = static_cast<Assign&>(*node);
+            if (!live.contains(assign.symbolRef) && isSpeculatable(*assign.value)) {
+                if (isRewriting) {
+                    node.reset();
+                    ++_removed;
+                }
+                return live;
+            }
+
+            if (isRewriting) {
+                _assigned.insert(assign.symbolRef);
+            }
+            live.erase(assign.symbolRef);
+            addReads(*assign.value, live);
+            return live;
+        }
+        case Node::Kind::LocalVarDeclaration: {
+            auto& declaration = static_cast<LocalVariableDeclaration&>(*node);
+            if (!live.contains(declaration.symbolRef) && isSpeculatable(*declaration.value)) {
+                if (!isRewriting) {
+                    return live;
+                }
+
+                // Assignments that stay still need the local declared, with any value
+                auto type = declaration.value->exprType;
+                if (!_assigned.contains(declaration.symbolRef)) {
+                    node.reset();
+                    ++_removed;
+                } else if (ASTBuilder::canMaterialize(type) && !getConstantValue(*declaration.value)) {
+                    declaration.value = _builder.constant(0, type, declaration.value->sourceLocation);
+                } else if (!ASTBuilder::canMaterialize(type)) {
+                    addReads(*declaration.value, live);
+                }
+                return live;
+            }
+
+            live.erase(declaration.symbolRef);
+            addReads(*declaration.value, live);
+            return live;
+        }
+        case Node::Kind::Print:
+            addReads(*static_cast<Print&>(*node).expression, live);
+            return live;
+        case Node::Kind::Return: {
+            // Locals die with the frame
+            Liveness returned;
+            addReads(*static_cast<Return&>(*node).returnExpression, returned);
+            return returned;
+        }
+        case Node::Kind::Break:
+            return _breakLiveness[static_cast<Break&>(*node).breakedStmt];
+        case Node::Kind::If: {
+            auto& ifNode = static_cast<If&>(*node);
+            auto result = analyzeBlock(*ifNode.then, live, isRewriting);
+            if (ifNode.elseThen != nullptr) {
+                live = analyzeStatement(ifNode.elseThen, std::move(live), isRewriting);
+            }
+            result.insert(live.begin(), live.end());
+
+            // Nothing left to branch to
+            auto isEmpty = ifNode.then->statements.empty() &&
+                           (ifNode.elseThen == nullptr ||
+                            (ifNode.elseThen->kind == Node::Kind::StatementBlock &&
+                             static_cast<StatementsBlock&>(*ifNode.elseThen).statements.empty()));
+            if (isRewriting && isEmpty && isSpeculatable(*ifNode.condition)) {
+                node.reset();
+                ++_removed;
+                return result;
+            }
+
+            addReads(*ifNode.condition, result);
+            return result;
+        }
+        case Node::Kind::While: {
+            auto& loop = static_cast<While&>(*node);
+            _breakLiveness[&loop] = live;
+
+            // Locals live at the condition grow until the body adds no more
+            auto header = live;
+            addReads(*loop.condition, header);
+            while (true) {
+                auto next = analyzeBlock(*loop.body, header, false);
+                next.insert(header.begin(), header.end());
+                if (next.size() == header.size()) {
+                    break;
+                }
+                header = std::move(next);
+            }
+
+            if (isRewriting) {
+                analyzeBlock(*loop.body, header, true);
+            }
+            return header;
+        }
+        default:
+            return live;
+    }
+}
+void DeadCodeElimination::addReads(Node& node, Liveness& live) {
+    stackGuard();
+
+    if (node.kind == Node::Kind::Identifier) {
+        live.insert(static_cast<Identifier&>(node).symbolRef);
+    }
+    forEachChild(node, [&live](Node& child) {
+        addReads(child, live);
+    });
+}
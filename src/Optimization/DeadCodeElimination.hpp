@@ -0,0 +1,67 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_DEADCODEELIMINATION_HPP
+#define VUG_DEADCODEELIMINATION_HPP
+
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "AST/ASTArena.hpp"
+#include "AST/ASTNodesForward.hpp"
+#include "Misc/PassProperty.hpp"
+#include "Optimization/ASTBuilder.hpp"
+#include "Optimization/CallGraph.hpp"
+
+class DiagnosticManager;
+class SymbolContext;
+
+// Deletes functions main never calls, statements after a return or break, and stores of values
+// no later statement reads. Liveness of locals is computed backwards over the structured control
+// flow, with loops iterated to a fixpoint. Stores whose value has effects (calls, possible traps) stay.
+class DeadCodeElimination {
+public:
+    static constexpr std::string_view name = "dead-code-elimination";
+    static constexpr auto required = PassProperty::LocalsResolved;
+    static constexpr auto provided = PassProperty::None;
+    static constexpr auto invalidated = PassProperty::None;
+
+    DeadCodeElimination(Node& ast,
+                        SymbolContext& context,
+                        DiagnosticManager& diagnosticManager)
+        : _ast(ast),
+          _builder(context),
+          _diagnosticManager(diagnosticManager) {}
+
+    void run();
+
+protected:
+    using Liveness = std::unordered_set<const LocalVariableSymbol*>;
+
+    Node& _ast;
+    ASTBuilder _builder;
+    DiagnosticManager& _diagnosticManager;
+
+    std::unique_ptr<CallGraph> _callGraph;
+    std::unordered_set<const CallGraph::Function*> _reachable;
+    // Live locals after each loop, where its breaks continue
+    std::unordered_map<const Statement*, Liveness> _breakLiveness;
+    // Locals with an assignment that stays, their declaration can't go
+    std::unordered_set<const LocalVariableSymbol*> _assigned;
+    size_t _removed{0};
+
+    void findReachableFunctions();
+    void removeFunctions(DeclarationsBlock& node);
+
+    void removeUnreachable(Node& node);
+    [[nodiscard]] static bool isTerminator(const Statement& node);
+
+    // Live locals before the code given the ones after it, dead stores are only deleted when rewriting
+    Liveness analyzeBlock(StatementsBlock& node, Liveness live, bool isRewriting);
+    Liveness analyzeStatement(NodePtr<Statement>& node, Liveness live, bool isRewriting);
+    static void addReads(Node& node, Liveness& live);
+};
+
+#endif//VUG_DEADCODEELIMINATION_HPP
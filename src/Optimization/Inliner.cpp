@@ -0,0 +1,300 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Inliner.hpp"
+
+#include "AST/ASTTraversal.hpp"
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/ASTCloner.hpp"
+#include "Semantic/SymbolContext.hpp"
+
+namespace {
+    size_t countReturns(Node& node) {
+        stackGuard();
+
+        size_t count = node.kind == Node::Kind::Return ? 1 : 0;
+        forEachChild(node, [&count](Node& child) {
+            count += countReturns(child);
+        });
+        return count;
+    }
+    bool hasReturnInLoop(Node& node, bool isInLoop) {
+        stackGuard();
+
+        if (node.kind == Node::Kind::Return) {
+            return isInLoop;
+        }
+
+        bool result = false;
+        forEachChild(node, [&](Node& child) {
+            result = result || hasReturnInLoop(child, isInLoop || node.kind == Node::Kind::While);
+        });
+        return result;
+    }
+}// namespace
+
+void Inliner::run() {
+    stackGuard();
+
+    _callGraph = std::make_unique<CallGraph>(_ast);
+
+    for (auto function: _callGraph->getBottomUpOrder()) {
+        _caller = function;
+        _callerSize = getNodeCount(*function->declaration->definition);
+
+        inlineCalls(*function->declaration->definition);
+        _sizes[function] = _callerSize;
+    }
+
+    _caller = nullptr;
+}
+
+void Inliner::inlineCalls(StatementsBlock& block) {
+    stackGuard();
+
+    for (size_t index = 0; index < block.statements.size(); ++index) {
+        auto statement = block.statements[index].get();
+
+        while (statement != nullptr) {
+            auto nested = statement;
+            statement = nullptr;
+
+            switch (nested->kind) {
+                case Node::Kind::StatementBlock:
+                    inlineCalls(static_cast<StatementsBlock&>(*nested));
+                    break;
+                case Node::Kind::If: {
+                    auto& ifNode = static_cast<If&>(*nested);
+                    inlineCalls(*ifNode.then);
+                    // Conditions of else-if branches can't be hoisted, their blocks can be visited
+                    statement = ifNode.elseThen.get();
+                    break;
+                }
+                case Node::Kind::While:
+                    inlineCalls(*static_cast<While&>(*nested).body);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        index += inlineCalls(block, index);
+    }
+}
+size_t Inliner::inlineCalls(StatementsBlock& block, size_t index) {
+    stackGuard();
+
+    auto& statement = *block.statements[index];
+
+    // Loop conditions run on every iteration and can't move in front of the loop
+    NodePtr<Expression>* expression;
+    switch (statement.kind) {
+        case Node::Kind::Assign:
+            expression = &static_cast<Assign&>(statement).value;
+            break;
+        case Node::Kind::LocalVarDeclaration:
+            expression = &static_cast<LocalVariableDeclaration&>(statement).value;
+            break;
+        case Node::Kind::Print:
+            expression = &static_cast<Print&>(statement).expression;
+            break;
+        case Node::Kind::Return:
+            expression = &static_cast<Return&>(statement).returnExpression;
+            break;
+        case Node::Kind::If:
+            expression = &static_cast<If&>(statement).condition;
+            break;
+        default:
+            return 0;
+    }
+
+    std::vector<NodePtr<Expression>*> calls;
+    bool mayTrap = false;
+    collectCalls(*expression, calls, mayTrap);
+
+    // Calls before an inlined one are hoisted as well to keep their order
+    size_t hoistedCount = 0;
+    for (size_t position = 0; position < calls.size(); ++position) {
+        if (isInlinable(static_cast<CallFunction&>(**calls[position]))) {
+            hoistedCount = position + 1;
+        }
+    }
+
+    NodeList<Statement> hoisted;
+    for (size_t position = 0; position < hoistedCount; ++position) {
+        auto& slot = *calls[position];
+        auto& call = static_cast<CallFunction&>(*slot);
+        auto sourceLocation = call.sourceLocation;
+        auto result = _builder.createVariable(std::string(call.name), call.symbolRef->getTypeSymbol());
+
+        if (isInlinable(call)) {
+            auto callee = _callGraph->getFunction(call.symbolRef);
+            _callerSize += _sizes[callee];
+
+            auto diagnostic = Diagnostic();
+            diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Info,
+                                                    std::format("inlined '{}' into '{}' (size {})",
+                                                                callee->declaration->name,
+                                                                _caller->declaration->name,
+                                                                _sizes[callee]),
+                                                    {sourceLocation}));
+            _diagnosticManager.report(diagnostic);
+
+            for (auto& inlined: expandCall(call, *result)) {
+                hoisted.push_back(std::move(inlined));
+            }
+        } else {
+            hoisted.push_back(_builder.declaration(*result, std::move(slot), sourceLocation));
+        }
+
+        slot = _builder.identifier(*result, sourceLocation);
+    }
+
+    auto hoistedSize = hoisted.size();
+    block.statements.insert(block.statements.begin() + static_cast<ptrdiff_t>(index),
+                            std::make_move_iterator(hoisted.begin()),
+                            std::make_move_iterator(hoisted.end()));
+    return hoistedSize;
+}
+void Inliner::collectCalls(NodePtr<Expression>& expression,
+                           std::vector<NodePtr<Expression>*>& calls,
+                           bool& mayTrap) {
+    stackGuard();
+
+    // Nothing evaluated after a possible division trap moves in front of it
+    if (mayTrap) {
+        return;
+    }
+
+    switch (expression->kind) {
+        case Node::Kind::BinaryOperation: {
+            auto& operation = static_cast<BinaryOperation&>(*expression);
+            collectCalls(operation.left, calls, mayTrap);
+            collectCalls(operation.right, calls, mayTrap);
+            if (operation.operationToken == LexemType::Divide || operation.operationToken == LexemType::Remainder) {
+                mayTrap = true;
+            }
+            break;
+        }
+        case Node::Kind::PrefixOperation:
+            collectCalls(static_cast<PrefixOperation&>(*expression).right, calls, mayTrap);
+            break;
+        case Node::Kind::CallFunction:
+            for (auto& argument: static_cast<CallFunction&>(*expression).arguments) {
+                collectCalls(argument, calls, mayTrap);
+            }
+            if (!mayTrap) {
+                calls.push_back(&expression);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+bool Inliner::isInlinable(const CallFunction& call) const {
+    auto callee = _callGraph->getFunction(call.symbolRef);
+    if (callee == nullptr || callee->isRecursive) {
+        return false;
+    }
+
+    auto size = _sizes.find(callee);
+    if (size == _sizes.end() || size->second > calleeSizeLimit || _callerSize + size->second > callerSizeLimit) {
+        return false;
+    }
+
+    auto& definition = *callee->declaration->definition;
+    if (definition.statements.empty() ||
+        definition.statements.back()->kind != Node::Kind::Return ||
+        hasReturnInLoop(definition, false)) {
+        return false;
+    }
+
+    // Early returns need the result declared before the body
+    return countReturns(definition) == 1 ||
+           ASTBuilder::canMaterialize(call.symbolRef->getTypeSymbol()->getType());
+}
+NodeList<Statement> Inliner::expandCall(CallFunction& call, LocalVariableSymbol& result) {
+    stackGuard();
+
+    const auto& declaration = *_callGraph->getFunction(call.symbolRef)->declaration;
+    const auto& parameters = call.symbolRef->getArguments();
+
+    auto cloner = ASTCloner(_context);
+    NodeList<Statement> statements;
+
+    for (size_t index = 0; index < parameters.size(); ++index) {
+        auto parameter = _builder.createVariable(parameters[index]->getName(), parameters[index]->getTypeSymbol());
+        cloner.mapSymbol(*parameters[index], *parameter);
+        statements.push_back(_builder.declaration(*parameter,
+                                                  std::move(call.arguments[index]),
+                                                  declaration.parameters[index]->sourceLocation));
+    }
+
+    auto body = cloner.clone(*declaration.definition);
+
+    if (countReturns(*body) == 1) {
+        auto returnNode = std::move(body->statements.back());
+        body->statements.pop_back();
+
+        for (auto& statement: body->statements) {
+            statements.push_back(std::move(statement));
+        }
+        statements.push_back(_builder.declaration(result,
+                                                  std::move(static_cast<Return&>(*returnNode).returnExpression),
+                                                  returnNode->sourceLocation));
+    } else {
+        auto type = result.getTypeSymbol()->getType();
+        statements.push_back(_builder.declaration(result,
+                                                  _builder.constant(0, type, call.sourceLocation),
+                                                  call.sourceLocation));
+
+        auto loop = makeNode<While>(_builder.constant(1, _context.getBoolType()->getType(), body->sourceLocation),
+                                    nullptr,
+                                    body->sourceLocation);
+        replaceReturns(*body, result, *loop);
+        loop->body = std::move(body);
+        statements.push_back(std::move(loop));
+    }
+
+    return statements;
+}
+void Inliner::replaceReturns(StatementsBlock& block, LocalVariableSymbol& result, While& loop) {
+    stackGuard();
+
+    for (auto& statement: block.statements) {
+        switch (statement->kind) {
+            case Node::Kind::Return: {
+                auto& returnNode = static_cast<Return&>(*statement);
+                auto sourceLocation = returnNode.sourceLocation;
+
+                NodeList<Statement> statements;
+                statements.push_back(_builder.assign(result, std::move(returnNode.returnExpression), sourceLocation));
+                statements.push_back(_builder.breakLoop(loop, sourceLocation));
+                statement = makeNode<StatementsBlock>(std::move(statements), sourceLocation);
+                break;
+            }
+            case Node::Kind::StatementBlock:
+                replaceReturns(static_cast<StatementsBlock&>(*statement), result, loop);
+                break;
+            case Node::Kind::If: {
+                auto ifNode = static_cast<If*>(statement.get());
+                while (ifNode != nullptr) {
+                    replaceReturns(*ifNode->then, result, loop);
+
+                    auto elseThen = ifNode->elseThen.get();
+                    ifNode = nullptr;
+                    if (elseThen != nullptr && elseThen->kind == Node::Kind::StatementBlock) {
+                        replaceReturns(static_cast<StatementsBlock&>(*elseThen), result, loop);
+                    } else if (elseThen != nullptr && elseThen->kind == Node::Kind::If) {
+                        ifNode = static_cast<If*>(elseThen);
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
@@ -0,0 +1,69 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_INLINER_HPP
+#define VUG_INLINER_HPP
+
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "AST/ASTArena.hpp"
+#include "AST/ASTNodesForward.hpp"
+#include "Misc/PassProperty.hpp"
+#include "Optimization/ASTBuilder.hpp"
+#include "Optimization/CallGraph.hpp"
+
+class DiagnosticManager;
+class SymbolContext;
+
+// Copies the bodies of small non-recursive functions into their callers, callees first.
+// A statement using such a call first evaluates its calls into temporaries, in the original order;
+// the inlined body then declares its parameters as fresh locals and writes its result into the temporary.
+// Bodies that return before their end run inside a one-iteration loop that breaks at every return.
+class Inliner {
+public:
+    static constexpr std::string_view name = "inliner";
+    static constexpr auto required = PassProperty::LocalsResolved;
+    static constexpr auto provided = PassProperty::None;
+    static constexpr auto invalidated = PassProperty::ConstantsPropagated;
+
+    // Sizes in AST nodes
+    static constexpr size_t calleeSizeLimit = 64;
+    static constexpr size_t callerSizeLimit = 2048;
+
+    Inliner(Node& ast,
+            SymbolContext& context,
+            DiagnosticManager& diagnosticManager)
+        : _ast(ast),
+          _context(context),
+          _builder(context),
+          _diagnosticManager(diagnosticManager) {}
+
+    void run();
+
+protected:
+    Node& _ast;
+    SymbolContext& _context;
+    ASTBuilder _builder;
+    DiagnosticManager& _diagnosticManager;
+
+    std::unique_ptr<CallGraph> _callGraph;
+    CallGraph::Function* _caller{nullptr};
+    size_t _callerSize{0};
+    std::unordered_map<const CallGraph::Function*, size_t> _sizes;
+
+    void inlineCalls(StatementsBlock& block);
+    // Returns the number of statements inserted in front of the statement
+    size_t inlineCalls(StatementsBlock& block, size_t index);
+    void collectCalls(NodePtr<Expression>& expression,
+                      std::vector<NodePtr<Expression>*>& calls,
+                      bool& mayTrap);
+
+    [[nodiscard]] bool isInlinable(const CallFunction& call) const;
+    NodeList<Statement> expandCall(CallFunction& call, LocalVariableSymbol& result);
+    void replaceReturns(StatementsBlock& block, LocalVariableSymbol& result, While& loop);
+};
+
+#endif//VUG_INLINER_HPP
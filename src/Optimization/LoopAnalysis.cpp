@@ -0,0 +1,196 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LoopAnalysis.hpp"
+
+#include "AST/ASTTraversal.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/ASTBuilder.hpp"
+#include "Optimization/ConstantFolding.hpp"
+
+namespace {
+    LexemType mirror(LexemType comparison) {
+        switch (comparison) {
+            case LexemType::Less:
+                return LexemType::Greater;
+            case LexemType::LessEqual:
+                return LexemType::GreaterEqual;
+            case LexemType::Greater:
+                return LexemType::Less;
+            case LexemType::GreaterEqual:
+                return LexemType::LessEqual;
+            default:
+                return comparison;
+        }
+    }
+    std::optional<int64_t> getInitialValue(const Statement* previous, const LocalVariableSymbol* variable) {
+        if (previous == nullptr) {
+            return std::nullopt;
+        }
+        if (previous->kind == Node::Kind::LocalVarDeclaration) {
+            const auto& declaration = static_cast<const LocalVariableDeclaration&>(*previous);
+            return declaration.symbolRef == variable ? getConstantValue(*declaration.value) : std::nullopt;
+        }
+        if (previous->kind == Node::Kind::Assign) {
+            const auto& assign = static_cast<const Assign&>(*previous);
+            return assign.symbolRef == variable ? getConstantValue(*assign.value) : std::nullopt;
+        }
+        return std::nullopt;
+    }
+    // Iterations until the condition fails, unless the variable wraps before that
+    std::optional<uint64_t> getTripCount(int64_t initial, int64_t bound, int64_t step, LexemType comparison) {
+        auto isUp = step > 0;
+        auto distance = isUp ? bound - initial : initial - bound;
+        auto stride = isUp ? step : -step;
+
+        uint64_t count;
+        switch (comparison) {
+            case LexemType::Less:
+            case LexemType::Greater:
+                count = distance <= 0 ? 0 : static_cast<uint64_t>((distance + stride - 1) / stride);
+                break;
+            case LexemType::LessEqual:
+            case LexemType::GreaterEqual:
+                count = distance < 0 ? 0 : static_cast<uint64_t>(distance / stride + 1);
+                break;
+            default:
+                return std::nullopt;
+        }
+
+        auto last = initial + static_cast<int64_t>(count) * step;
+        if (last > INT32_MAX || last < INT32_MIN) {
+            return std::nullopt;
+        }
+        return count;
+    }
+}// namespace
+
+std::optional<CountedLoop> analyzeCountedLoop(While& loop, const Statement* previous) {
+    stackGuard();
+
+    if (loop.condition->kind != Node::Kind::BinaryOperation || loop.body->statements.empty() ||
+        loop.body->statements.back()->kind != Node::Kind::Assign) {
+        return std::nullopt;
+    }
+    auto& condition = static_cast<BinaryOperation&>(*loop.condition);
+    auto& increment = static_cast<Assign&>(*loop.body->statements.back());
+    auto step = getInductionStep(increment);
+    auto type = increment.symbolRef->getTypeSymbol()->getType();
+    if (!step || *step == 0 || !type->isInteger() || !ASTBuilder::canMaterialize(type)) {
+        return std::nullopt;
+    }
+
+    auto isVariable = [&increment](const Expression& expression) {
+        return expression.kind == Node::Kind::Identifier &&
+               static_cast<const Identifier&>(expression).symbolRef == increment.symbolRef;
+    };
+    LexemType comparison;
+    Expression* bound;
+    if (isVariable(*condition.left)) {
+        comparison = condition.operationToken;
+        bound = condition.right.get();
+    } else if (isVariable(*condition.right)) {
+        comparison = mirror(condition.operationToken);
+        bound = condition.left.get();
+    } else {
+        return std::nullopt;
+    }
+
+    auto isUp = comparison == LexemType::Less || comparison == LexemType::LessEqual;
+    auto isDown = comparison == LexemType::Greater || comparison == LexemType::GreaterEqual;
+    if ((!isUp || *step < 0) && (!isDown || *step > 0)) {
+        return std::nullopt;
+    }
+
+    // The increment has to be the only assignment of the variable
+    std::unordered_set<const LocalVariableSymbol*> assigned;
+    for (size_t index = 0; index + 1 < loop.body->statements.size(); ++index) {
+        collectAssigned(*loop.body->statements[index], assigned);
+    }
+    if (assigned.contains(increment.symbolRef)) {
+        return std::nullopt;
+    }
+    assigned.insert(increment.symbolRef);
+    if (!isSpeculatable(*bound) || isReading(*bound, assigned)) {
+        return std::nullopt;
+    }
+
+    auto initialValue = getInitialValue(previous, increment.symbolRef);
+    auto boundValue = getConstantValue(*bound);
+    auto tripCount = initialValue && boundValue ? getTripCount(*initialValue, *boundValue, *step, comparison)
+                                                : std::nullopt;
+    return CountedLoop{&loop,
+                       increment.symbolRef,
+                       *step,
+                       comparison,
+                       bound,
+                       &increment,
+                       hasBreak(*loop.body, loop),
+                       initialValue,
+                       boundValue,
+                       tripCount};
+}
+
+std::optional<int64_t> getInductionStep(const Assign& node) {
+    if (node.value->kind != Node::Kind::BinaryOperation) {
+        return std::nullopt;
+    }
+    const auto& operation = static_cast<const BinaryOperation&>(*node.value);
+    auto isSymbol = [&node](const Expression& expression) {
+        return expression.kind == Node::Kind::Identifier &&
+               static_cast<const Identifier&>(expression).symbolRef == node.symbolRef;
+    };
+
+    if (operation.operationToken == LexemType::Plus && isSymbol(*operation.left)) {
+        return getConstantValue(*operation.right);
+    }
+    if (operation.operationToken == LexemType::Plus && isSymbol(*operation.right)) {
+        return getConstantValue(*operation.left);
+    }
+    if (operation.operationToken == LexemType::Minus && isSymbol(*operation.left)) {
+        auto step = getConstantValue(*operation.right);
+        return step ? std::optional(-*step) : std::nullopt;
+    }
+    return std::nullopt;
+}
+void collectAssigned(Node& node, std::unordered_set<const LocalVariableSymbol*>& assigned) {
+    stackGuard();
+
+    if (node.kind == Node::Kind::Assign) {
+        assigned.insert(static_cast<Assign&>(node).symbolRef);
+    } else if (node.kind == Node::Kind::LocalVarDeclaration) {
+        assigned.insert(static_cast<LocalVariableDeclaration&>(node).symbolRef);
+    }
+
+    forEachChild(node, [&assigned](Node& child) {
+        if (child.isStatement()) {
+            collectAssigned(child, assigned);
+        }
+    });
+}
+bool isReading(Node& node, const std::unordered_set<const LocalVariableSymbol*>& symbols) {
+    stackGuard();
+
+    if (node.kind == Node::Kind::Identifier && symbols.contains(static_cast<Identifier&>(node).symbolRef)) {
+        return true;
+    }
+
+    bool result = false;
+    forEachChild(node, [&](Node& child) {
+        result = result || isReading(child, symbols);
+    });
+    return result;
+}
+bool hasBreak(Node& node, const While& loop) {
+    stackGuard();
+
+    if (node.kind == Node::Kind::Break) {
+        return static_cast<Break&>(node).breakedStmt == &loop;
+    }
+
+    bool result = false;
+    forEachChild(node, [&](Node& child) {
+        result = result || hasBreak(child, loop);
+    });
+    return result;
+}
@@ -0,0 +1,47 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_LOOPANALYSIS_HPP
+#define VUG_LOOPANALYSIS_HPP
+
+#include <cstdint>
+#include <optional>
+#include <unordered_set>
+
+#include "AST/ASTNodesForward.hpp"
+#include "Lexing/Token.hpp"
+
+class LocalVariableSymbol;
+
+// A loop `while (i < bound) { ...; i = i + step; }` over an int32 local: the body ends with the only
+// assignment of `i` in the loop and `bound` is speculatable and doesn't change in the loop.
+// `<` and `<=` count up with a positive step, `>` and `>=` down with a negative one.
+struct CountedLoop {
+    While* loop;
+    LocalVariableSymbol* variable;
+    int64_t step;
+    // With the variable on the left
+    LexemType comparison;
+    Expression* bound;
+    Assign* increment;
+    // Whether a break leaves this loop
+    bool hasBreak;
+
+    // Known when the statement in front of the loop sets the variable to a constant and the bound is one
+    std::optional<int64_t> initialValue;
+    std::optional<int64_t> boundValue;
+    // Known when both values are and the variable doesn't wrap on the way
+    std::optional<uint64_t> tripCount;
+};
+
+// `previous` is the statement in front of the loop, if any
+std::optional<CountedLoop> analyzeCountedLoop(While& loop, const Statement* previous);
+
+// Step of `symbol = symbol + constant`, `symbol = constant + symbol` or `symbol = symbol - constant`
+std::optional<int64_t> getInductionStep(const Assign& node);
+// Locals assigned or declared in the subtree
+void collectAssigned(Node& node, std::unordered_set<const LocalVariableSymbol*>& assigned);
+bool isReading(Node& node, const std::unordered_set<const LocalVariableSymbol*>& symbols);
+bool hasBreak(Node& node, const While& loop);
+
+#endif//VUG_LOOPANALYSIS_HPP
@@ -0,0 +1,161 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LoopUnrolling.hpp"
+
+#include <algorithm>
+
+#include "AST/ASTTraversal.hpp"
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/ASTCloner.hpp"
+#include "Optimization/CallGraph.hpp"
+
+void LoopUnrolling::run() {
+    stackGuard();
+
+    auto callGraph = CallGraph(_ast);
+    for (auto function: callGraph.getBottomUpOrder()) {
+        unrollLoops(*function->declaration->definition);
+    }
+}
+
+void LoopUnrolling::unrollLoops(Node& node) {
+    stackGuard();
+
+    // Inner loops first, the outer ones see their final size
+    forEachChild(node, [this](Node& child) {
+        if (child.isStatement()) {
+            unrollLoops(child);
+        }
+    });
+
+    if (node.kind != Node::Kind::StatementBlock) {
+        return;
+    }
+    auto& statements = static_cast<StatementsBlock&>(node).statements;
+    for (size_t index = 0; index < statements.size(); ++index) {
+        if (statements[index]->kind != Node::Kind::While) {
+            continue;
+        }
+
+        auto counted = analyzeCountedLoop(static_cast<While&>(*statements[index]),
+                                          index > 0 ? statements[index - 1].get() : nullptr);
+        if (!counted || counted->hasBreak) {
+            continue;
+        }
+
+        auto size = getNodeCount(*counted->loop->body);
+        if (counted->tripCount && *counted->tripCount > 0 && *counted->tripCount * size <= fullUnrollSizeLimit) {
+            auto copies = fullyUnroll(*counted);
+            auto count = copies.size();
+            statements.erase(statements.begin() + static_cast<ptrdiff_t>(index));
+            statements.insert(statements.begin() + static_cast<ptrdiff_t>(index),
+                              std::make_move_iterator(copies.begin()),
+                              std::make_move_iterator(copies.end()));
+            index += count - 1;
+            continue;
+        }
+
+        // The copies are held to the size a full unrolling may reach
+        auto factor = std::min(_factor, fullUnrollSizeLimit / size);
+        if (factor < 2 || size > bodySizeLimit || (counted->tripCount && *counted->tripCount < factor)) {
+            continue;
+        }
+        auto unrolled = partiallyUnroll(*counted, factor);
+        if (unrolled != nullptr) {
+            statements.insert(statements.begin() + static_cast<ptrdiff_t>(index), std::move(unrolled));
+            ++index;
+        }
+    }
+}
+NodeList<Statement> LoopUnrolling::fullyUnroll(const CountedLoop& counted) {
+    stackGuard();
+
+    // The condition is speculatable, skipping its checks changes nothing
+    NodeList<Statement> statements;
+    appendCopies(statements, *counted.loop->body, *counted.tripCount);
+
+    report(counted, std::format("fully unrolled loop with trip count {}", *counted.tripCount));
+    return statements;
+}
+NodePtr<While> LoopUnrolling::partiallyUnroll(const CountedLoop& counted, size_t factor) {
+    stackGuard();
+
+    // The unrolled loop runs while the last copy would still pass the original condition
+    auto distance = static_cast<int64_t>(factor - 1) * counted.step;
+    if (distance > INT32_MAX || distance < -INT32_MAX) {
+        return nullptr;
+    }
+
+    auto type = counted.variable->getTypeSymbol()->getType();
+    auto sourceLocation = counted.loop->condition->sourceLocation;
+    auto cloner = ASTCloner(_context);
+
+    NodePtr<Expression> condition;
+    if (counted.boundValue) {
+        auto bound = *counted.boundValue - distance;
+        if (bound > INT32_MAX || bound < INT32_MIN) {
+            return nullptr;
+        }
+        condition = _builder.binaryOperation(counted.comparison,
+                                             _builder.identifier(*counted.variable, sourceLocation),
+                                             _builder.constant(bound, type, sourceLocation),
+                                             sourceLocation);
+    } else {
+        // The adjusted bound must not wrap, bounds it would wrap for leave everything to the original loop
+        auto guard = counted.step > 0
+                             ? _builder.binaryOperation(LexemType::GreaterEqual,
+                                                        cloner.clone(*counted.bound),
+                                                        _builder.constant(INT32_MIN + distance, type, sourceLocation),
+                                                        sourceLocation)
+                             : _builder.binaryOperation(LexemType::LessEqual,
+                                                        cloner.clone(*counted.bound),
+                                                        _builder.constant(INT32_MAX + distance, type, sourceLocation),
+                                                        sourceLocation);
+        auto bound = _builder.binaryOperation(distance > 0 ? LexemType::Minus : LexemType::Plus,
+                                              cloner.clone(*counted.bound),
+                                              _builder.constant(distance > 0 ? distance : -distance, type, sourceLocation),
+                                              sourceLocation);
+        condition = _builder.binaryOperation(LexemType::LogicAnd,
+                                             std::move(guard),
+                                             _builder.binaryOperation(counted.comparison,
+                                                                      _builder.identifier(*counted.variable, sourceLocation),
+                                                                      std::move(bound),
+                                                                      sourceLocation),
+                                             sourceLocation);
+    }
+    NodeList<Statement> statements;
+    appendCopies(statements, *counted.loop->body, factor);
+
+    auto unrolled = makeNode<While>(std::move(condition), nullptr, counted.loop->sourceLocation);
+    unrolled->body = makeNode<StatementsBlock>(std::move(statements), counted.loop->body->sourceLocation);
+
+    auto message = counted.tripCount ? std::format("unrolled loop by {} (trip count {})", factor, *counted.tripCount)
+                                     : std::format("unrolled loop by {}", factor);
+    if (factor < _factor) {
+        message += std::format(", factor {} would exceed the size limit", _factor);
+    }
+    report(counted, message);
+    return unrolled;
+}
+
+void LoopUnrolling::appendCopies(NodeList<Statement>& statements, StatementsBlock& body, size_t count) {
+    stackGuard();
+
+    // Every copy declares its own locals
+    for (size_t copy = 0; copy < count; ++copy) {
+        auto cloner = ASTCloner(_context);
+        auto clone = cloner.clone(body);
+        for (auto& statement: clone->statements) {
+            statements.push_back(std::move(statement));
+        }
+    }
+}
+void LoopUnrolling::report(const CountedLoop& counted, const std::string& message) {
+    auto diagnostic = Diagnostic();
+    diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Info,
+                                            message,
+                                            {counted.loop->sourceLocation}));
+    _diagnosticManager.report(diagnostic);
+}
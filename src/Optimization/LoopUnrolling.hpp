@@ -0,0 +1,66 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_LOOPUNROLLING_HPP
+#define VUG_LOOPUNROLLING_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AST/ASTArena.hpp"
+#include "AST/ASTNodesForward.hpp"
+#include "Misc/PassProperty.hpp"
+#include "Optimization/ASTBuilder.hpp"
+#include "Optimization/LoopAnalysis.hpp"
+
+class DiagnosticManager;
+class SymbolContext;
+
+// Unrolls counted loops without breaks. A loop with a small known trip count is replaced by that many
+// copies of its body. Otherwise a loop running `factor` copies per condition check goes in front of
+// it, for as long as `factor` more iterations certainly remain; the original loop runs the rest. The
+// copies are held to `fullUnrollSizeLimit` nodes, a bigger factor is lowered for the loop.
+class LoopUnrolling {
+public:
+    static constexpr std::string_view name = "loop-unrolling";
+    static constexpr auto required = PassProperty::LocalsResolved;
+    static constexpr auto provided = PassProperty::None;
+    static constexpr auto invalidated = PassProperty::ConstantsPropagated;
+
+    static constexpr size_t defaultFactor = 4;
+    // Sizes in AST nodes
+    static constexpr size_t bodySizeLimit = 64;
+    static constexpr size_t fullUnrollSizeLimit = 256;
+
+    LoopUnrolling(Node& ast,
+                  SymbolContext& context,
+                  DiagnosticManager& diagnosticManager,
+                  size_t factor = defaultFactor)
+        : _ast(ast),
+          _context(context),
+          _builder(context),
+          _diagnosticManager(diagnosticManager),
+          _factor(factor) {}
+
+    void run();
+
+protected:
+    Node& _ast;
+    SymbolContext& _context;
+    ASTBuilder _builder;
+    DiagnosticManager& _diagnosticManager;
+    size_t _factor;
+
+    void unrollLoops(Node& node);
+    // Returns the statements replacing the loop
+    NodeList<Statement> fullyUnroll(const CountedLoop& counted);
+    // Returns the loop running `factor` copies to put in front of the original one, if its bound can be adjusted
+    NodePtr<While> partiallyUnroll(const CountedLoop& counted, size_t factor);
+
+    void appendCopies(NodeList<Statement>& statements, StatementsBlock& body, size_t count);
+    void report(const CountedLoop& counted, const std::string& message);
+};
+
+#endif//VUG_LOOPUNROLLING_HPP
@@ -0,0 +1,135 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LoopUnswitching.hpp"
+
+#include "AST/ASTTraversal.hpp"
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/ASTCloner.hpp"
+#include "Optimization/CallGraph.hpp"
+#include "Optimization/ConstantFolding.hpp"
+#include "Optimization/LoopAnalysis.hpp"
+
+void LoopUnswitching::run() {
+    stackGuard();
+
+    auto callGraph = CallGraph(_ast);
+    for (auto function: callGraph.getBottomUpOrder()) {
+        _budget = functionGrowthLimit;
+        unswitchLoops(*function->declaration->definition);
+    }
+}
+
+void LoopUnswitching::unswitchLoops(Node& node) {
+    stackGuard();
+
+    // Inner loops first, an if they hoist may then leave the outer loop too
+    forEachChild(node, [this](Node& child) {
+        if (child.isStatement()) {
+            unswitchLoops(child);
+        }
+    });
+
+    if (node.kind != Node::Kind::StatementBlock) {
+        return;
+    }
+    for (auto& statement: static_cast<StatementsBlock&>(node).statements) {
+        if (statement->kind != Node::Kind::While) {
+            continue;
+        }
+
+        auto unswitched = unswitch(statement);
+        if (unswitched == nullptr) {
+            continue;
+        }
+        statement = std::move(unswitched);
+
+        // Both copies may have more ifs to hoist
+        auto& branches = static_cast<If&>(*statement);
+        unswitchLoops(*branches.then);
+        unswitchLoops(*branches.elseThen);
+    }
+}
+NodePtr<If> LoopUnswitching::unswitch(NodePtr<Statement>& loop) {
+    stackGuard();
+
+    auto& original = static_cast<While&>(*loop);
+    auto size = getNodeCount(original);
+    if (size > loopSizeLimit || size > _budget) {
+        return nullptr;
+    }
+
+    Symbols assigned;
+    collectAssigned(*original.body, assigned);
+    auto originalSlot = findInvariantIf(*original.body, assigned);
+    if (originalSlot == nullptr) {
+        return nullptr;
+    }
+    _budget -= size;
+
+    // The copy has fresh symbols for its own locals, which are assigned in it just like the originals,
+    // so the same if is found there
+    auto cloner = ASTCloner(_context);
+    auto copy = cloner.clone(original);
+    auto& copyLoop = static_cast<While&>(*copy);
+    Symbols copyAssigned;
+    collectAssigned(*copyLoop.body, copyAssigned);
+    auto copySlot = findInvariantIf(*copyLoop.body, copyAssigned);
+
+    auto hoisted = NodePtr<If>(static_cast<If*>(originalSlot->release()));
+    *originalSlot = std::move(hoisted->then);
+    auto copyIf = NodePtr<If>(static_cast<If*>(copySlot->release()));
+    if (copyIf->elseThen != nullptr) {
+        *copySlot = std::move(copyIf->elseThen);
+    } else {
+        *copySlot = makeNode<StatementsBlock>(NodeList<Statement>(), copyIf->sourceLocation);
+    }
+
+    auto diagnostic = Diagnostic();
+    diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Info,
+                                            "unswitched loop on a condition it doesn't change",
+                                            {original.sourceLocation}));
+    _diagnosticManager.report(diagnostic);
+
+    auto sourceLocation = original.sourceLocation;
+    NodeList<Statement> thenStatements;
+    thenStatements.push_back(std::move(loop));
+    NodeList<Statement> elseStatements;
+    elseStatements.push_back(std::move(copy));
+    return makeNode<If>(std::move(hoisted->condition),
+                        makeNode<StatementsBlock>(std::move(thenStatements), sourceLocation),
+                        makeNode<StatementsBlock>(std::move(elseStatements), sourceLocation),
+                        sourceLocation);
+}
+
+NodePtr<Statement>* LoopUnswitching::findInvariantIf(NodePtr<Statement>& statement, const Symbols& assigned) {
+    stackGuard();
+
+    switch (statement->kind) {
+        case Node::Kind::StatementBlock:
+            return findInvariantIf(static_cast<StatementsBlock&>(*statement), assigned);
+        case Node::Kind::If: {
+            auto& node = static_cast<If&>(*statement);
+            if (isSpeculatable(*node.condition) && !isReading(*node.condition, assigned)) {
+                return &statement;
+            }
+            if (auto found = findInvariantIf(*node.then, assigned)) {
+                return found;
+            }
+            return node.elseThen != nullptr ? findInvariantIf(node.elseThen, assigned) : nullptr;
+        }
+        default:
+            return nullptr;
+    }
+}
+NodePtr<Statement>* LoopUnswitching::findInvariantIf(StatementsBlock& block, const Symbols& assigned) {
+    stackGuard();
+
+    for (auto& statement: block.statements) {
+        if (auto found = findInvariantIf(statement, assigned)) {
+            return found;
+        }
+    }
+    return nullptr;
+}
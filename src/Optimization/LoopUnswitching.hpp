@@ -0,0 +1,61 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_LOOPUNSWITCHING_HPP
+#define VUG_LOOPUNSWITCHING_HPP
+
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+
+#include "AST/ASTArena.hpp"
+#include "AST/ASTNodesForward.hpp"
+#include "Misc/PassProperty.hpp"
+
+class DiagnosticManager;
+class LocalVariableSymbol;
+class SymbolContext;
+
+// Moves an `if` out of a loop when its condition is speculatable and reads no local the loop assigns:
+// `while (c) { a; if (p) { b } else { d } e }` becomes `if (p) { while (c) { a; { b } e } } else { while (c) { a; { d } e } }`.
+// Ifs inside inner loops are left to those loops. Each copy is unswitched again while the budget lasts.
+class LoopUnswitching {
+public:
+    static constexpr std::string_view name = "loop-unswitching";
+    static constexpr auto required = PassProperty::LocalsResolved;
+    static constexpr auto provided = PassProperty::None;
+    static constexpr auto invalidated = PassProperty::None;
+
+    // Sizes in AST nodes
+    static constexpr size_t loopSizeLimit = 96;
+    static constexpr size_t functionGrowthLimit = 384;
+
+    LoopUnswitching(Node& ast,
+                    SymbolContext& context,
+                    DiagnosticManager& diagnosticManager)
+        : _ast(ast),
+          _context(context),
+          _diagnosticManager(diagnosticManager) {}
+
+    void run();
+
+protected:
+    using Symbols = std::unordered_set<const LocalVariableSymbol*>;
+
+    Node& _ast;
+    SymbolContext& _context;
+    DiagnosticManager& _diagnosticManager;
+
+    // Nodes the current function may still grow by
+    size_t _budget{0};
+
+    void unswitchLoops(Node& node);
+    // Returns the if replacing the loop
+    NodePtr<If> unswitch(NodePtr<Statement>& loop);
+
+    // First if in the subtree, outside of inner loops, whose condition doesn't change in the loop
+    static NodePtr<Statement>* findInvariantIf(NodePtr<Statement>& statement, const Symbols& assigned);
+    static NodePtr<Statement>* findInvariantIf(StatementsBlock& block, const Symbols& assigned);
+};
+
+#endif//VUG_LOOPUNSWITCHING_HPP
@@ -0,0 +1,677 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "RangeAnalysis.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <format>
+
+#include "AST/ASTTraversal.hpp"
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/CallGraph.hpp"
+#include "Optimization/ConstantFolding.hpp"
+#include "Optimization/LoopAnalysis.hpp"
+
+namespace {
+    bool isComparison(LexemType operation) {
+        switch (operation) {
+            case LexemType::Less:
+            case LexemType::LessEqual:
+            case LexemType::Greater:
+            case LexemType::GreaterEqual:
+            case LexemType::Equal:
+            case LexemType::Unequal:
+                return true;
+            default:
+                return false;
+        }
+    }
+    // `!(a operation b)` is `a negate(operation) b`
+    LexemType negate(LexemType operation) {
+        switch (operation) {
+            case LexemType::Less:
+                return LexemType::GreaterEqual;
+            case LexemType::LessEqual:
+                return LexemType::Greater;
+            case LexemType::Greater:
+                return LexemType::LessEqual;
+            case LexemType::GreaterEqual:
+                return LexemType::Less;
+            case LexemType::Equal:
+                return LexemType::Unequal;
+            default:
+                return LexemType::Equal;
+        }
+    }
+    // `a operation b` is `b mirror(operation) a`
+    LexemType mirror(LexemType operation) {
+        switch (operation) {
+            case LexemType::Less:
+                return LexemType::Greater;
+            case LexemType::LessEqual:
+                return LexemType::GreaterEqual;
+            case LexemType::Greater:
+                return LexemType::Less;
+            case LexemType::GreaterEqual:
+                return LexemType::LessEqual;
+            default:
+                return operation;
+        }
+    }
+    // Values of `range` for which `value operation bound` may hold
+    std::optional<ValueRange> narrow(LexemType operation, const ValueRange& range, const ValueRange& bound) {
+        auto result = range;
+        switch (operation) {
+            case LexemType::Less:
+                result.max = std::min(range.max, bound.max - 1);
+                break;
+            case LexemType::LessEqual:
+                result.max = std::min(range.max, bound.max);
+                break;
+            case LexemType::Greater:
+                result.min = std::max(range.min, bound.min + 1);
+                break;
+            case LexemType::GreaterEqual:
+                result.min = std::max(range.min, bound.min);
+                break;
+            case LexemType::Equal:
+                return range.intersect(bound);
+            case LexemType::Unequal:
+                if (bound.isConstant() && range.min == bound.min) {
+                    ++result.min;
+                } else if (bound.isConstant() && range.max == bound.min) {
+                    --result.max;
+                }
+                break;
+            default:
+                break;
+        }
+        return result.min <= result.max ? std::optional(result) : std::nullopt;
+    }
+    const Type* getType(const LocalVariableSymbol* symbol) {
+        return symbol->getTypeSymbol()->getType();
+    }
+}// namespace
+
+std::optional<ValueRange> ValueRange::getFull(const Type* type) {
+    if (!type->isInteger()) {
+        return std::nullopt;
+    }
+    auto integerType = static_cast<const IntegerType*>(type);
+    auto bits = integerType->getBits();
+    if (bits > 32) {
+        return std::nullopt;
+    }
+    if (integerType->isIsSigned()) {
+        return ValueRange{-(int64_t{1} << (bits - 1)), (int64_t{1} << (bits - 1)) - 1};
+    }
+    return ValueRange{0, (int64_t{1} << bits) - 1};
+}
+ValueRange ValueRange::join(const ValueRange& other) const {
+    return {std::min(min, other.min), std::max(max, other.max)};
+}
+std::optional<ValueRange> ValueRange::intersect(const ValueRange& other) const {
+    auto result = ValueRange{std::max(min, other.min), std::min(max, other.max)};
+    return result.min <= result.max ? std::optional(result) : std::nullopt;
+}
+
+ValueRange getBinaryOperationRange(LexemType operation, const ValueRange& left, const ValueRange& right, const Type* type) {
+    auto full = *ValueRange::getFull(type);
+    auto result = full;
+
+    // Ends of 32-bit ranges, only products may leave int64
+    auto fromCorners = [&](auto&& combine) {
+        int64_t corners[4];
+        auto index = 0;
+        for (auto a: {left.min, left.max}) {
+            for (auto b: {right.min, right.max}) {
+                if (!combine(a, b, corners[index++])) {
+                    return full;
+                }
+            }
+        }
+        return ValueRange{*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4)};
+    };
+
+    switch (operation) {
+        case LexemType::Plus:
+            result = {left.min + right.min, left.max + right.max};
+            break;
+        case LexemType::Minus:
+            result = {left.min - right.max, left.max - right.min};
+            break;
+        case LexemType::Multiply:
+            result = fromCorners([](int64_t a, int64_t b, int64_t& product) {
+                return !__builtin_mul_overflow(a, b, &product);
+            });
+            break;
+        case LexemType::Divide:
+            // Truncating division is monotonic in each operand while the divisor keeps its sign
+            if (right.min > 0 || right.max < 0) {
+                result = fromCorners([](int64_t a, int64_t b, int64_t& quotient) {
+                    quotient = a / b;
+                    return true;
+                });
+            }
+            break;
+        case LexemType::Remainder:
+            if (right.min > 0 || right.max < 0) {
+                auto largest = std::max(std::abs(right.min), std::abs(right.max)) - 1;
+                result = {left.min >= 0 ? 0 : std::max(left.min, -largest), left.max <= 0 ? 0 : std::min(left.max, largest)};
+            }
+            break;
+        case LexemType::BitAnd:
+            if (left.min >= 0 && right.min >= 0) {
+                result = {0, std::min(left.max, right.max)};
+            } else if (left.min >= 0 || right.min >= 0) {
+                result = {0, left.min >= 0 ? left.max : right.max};
+            }
+            break;
+        case LexemType::BitOr:
+        case LexemType::BitXor:
+            if (left.min >= 0 && right.min >= 0) {
+                auto width = std::bit_width(static_cast<uint64_t>(std::max(left.max, right.max)));
+                result = {0, static_cast<int64_t>((uint64_t{1} << width) - 1)};
+            }
+            break;
+        default:
+            break;
+    }
+
+    // Results that may wrap can be anything
+    return result.min < full.min || result.max > full.max ? full : result;
+}
+ValueRange getPrefixOperationRange(LexemType operation, const ValueRange& right, const Type* type) {
+    auto full = *ValueRange::getFull(type);
+    if (operation != LexemType::Minus) {
+        return full;
+    }
+    auto result = ValueRange{-right.max, -right.min};
+    return result.min < full.min || result.max > full.max ? full : result;
+}
+std::optional<bool> compareRanges(LexemType operation, const ValueRange& left, const ValueRange& right) {
+    switch (operation) {
+        case LexemType::Less:
+            return left.max < right.min ? std::optional(true) : left.min >= right.max ? std::optional(false) : std::nullopt;
+        case LexemType::LessEqual:
+            return left.max <= right.min ? std::optional(true) : left.min > right.max ? std::optional(false) : std::nullopt;
+        case LexemType::Greater:
+        case LexemType::GreaterEqual:
+            return compareRanges(mirror(operation), right, left);
+        case LexemType::Equal:
+            if (left.isConstant() && left == right) {
+                return true;
+            }
+            return left.intersect(right) ? std::nullopt : std::optional(false);
+        case LexemType::Unequal: {
+            auto equal = compareRanges(LexemType::Equal, left, right);
+            return equal ? std::optional(!*equal) : std::nullopt;
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+void RangeAnalysis::run() {
+    stackGuard();
+
+    auto callGraph = CallGraph(_ast);
+    for (auto function: callGraph.getBottomUpOrder()) {
+        _decisions.clear();
+        _nonNegativeDividends.clear();
+        _breakStates.clear();
+
+        // Parameters may hold anything
+        std::optional<State> state = State();
+        analyzeBlock(*function->declaration->definition, state);
+
+        _removed = 0;
+        _narrowed = 0;
+        rewriteBlock(*function->declaration->definition);
+
+        if (_removed > 0 || _narrowed > 0) {
+            auto diagnostic = Diagnostic();
+            diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Info,
+                                                    std::format("range analysis removed {} conditions and narrowed {} divisions in '{}'",
+                                                                _removed,
+                                                                _narrowed,
+                                                                function->declaration->name),
+                                                    {function->declaration->sourceLocation}));
+            _diagnosticManager.report(diagnostic);
+        }
+    }
+}
+
+void RangeAnalysis::join(std::optional<State>& state, const std::optional<State>& other) {
+    if (!other) {
+        return;
+    }
+    if (!state) {
+        state = other;
+        return;
+    }
+
+    // A local missing on either side may hold anything
+    for (auto local = state->begin(); local != state->end();) {
+        auto otherLocal = other->find(local->first);
+        if (otherLocal == other->end()) {
+            local = state->erase(local);
+            continue;
+        }
+        local->second = local->second.join(otherLocal->second);
+        ++local;
+    }
+}
+void RangeAnalysis::widen(State& head, const State& next) {
+    for (auto local = head.begin(); local != head.end();) {
+        auto nextLocal = next.find(local->first);
+        if (nextLocal == next.end()) {
+            local = head.erase(local);
+            continue;
+        }
+        auto full = *ValueRange::getFull(getType(local->first));
+        if (nextLocal->second.min < local->second.min) {
+            local->second.min = full.min;
+        }
+        if (nextLocal->second.max > local->second.max) {
+            local->second.max = full.max;
+        }
+        ++local;
+    }
+}
+
+void RangeAnalysis::analyzeBlock(StatementsBlock& node, std::optional<State>& state) {
+    stackGuard();
+
+    for (const auto& statement: node.statements) {
+        if (!state) {
+            return;
+        }
+        analyzeStatement(*statement, state);
+    }
+}
+void RangeAnalysis::analyzeStatement(Statement& node, std::optional<State>& state) {
+    stackGuard();
+
+    auto store = [&state](const LocalVariableSymbol* symbol, std::optional<ValueRange> range) {
+        if (range) {
+            (*state)[symbol] = *range;
+        } else {
+            state->erase(symbol);
+        }
+    };
+
+    switch (node.kind) {
+        case Node::Kind::StatementBlock:
+            analyzeBlock(static_cast<StatementsBlock&>(node), state);
+            break;
+        case Node::Kind::Assign: {
+            auto& assign = static_cast<Assign&>(node);
+            store(assign.symbolRef, evaluate(*assign.value, *state));
+            break;
+        }
+        case Node::Kind::LocalVarDeclaration: {
+            auto& declaration = static_cast<LocalVariableDeclaration&>(node);
+            store(declaration.symbolRef, evaluate(*declaration.value, *state));
+            break;
+        }
+        case Node::Kind::Print:
+            evaluate(*static_cast<Print&>(node).expression, *state);
+            break;
+        case Node::Kind::Return:
+            evaluate(*static_cast<Return&>(node).returnExpression, *state);
+            state.reset();
+            break;
+        case Node::Kind::Break:
+            join(_breakStates[static_cast<Break&>(node).breakedStmt], state);
+            state.reset();
+            break;
+        case Node::Kind::If: {
+            auto& ifNode = static_cast<If&>(node);
+            decide(*ifNode.condition, *state);
+
+            auto thenState = refine(*ifNode.condition, *state, true);
+            auto elseState = refine(*ifNode.condition, *state, false);
+            if (thenState) {
+                analyzeBlock(*ifNode.then, thenState);
+            }
+            if (elseState && ifNode.elseThen != nullptr) {
+                analyzeStatement(*ifNode.elseThen, elseState);
+            }
+
+            state = std::move(thenState);
+            join(state, elseState);
+            break;
+        }
+        case Node::Kind::While:
+            analyzeLoop(static_cast<While&>(node), state);
+            break;
+        default:
+            break;
+    }
+}
+void RangeAnalysis::analyzeLoop(While& loop, std::optional<State>& state) {
+    stackGuard();
+
+    auto head = state;
+    _breakStates[&loop].reset();
+
+    // The counter passed the condition before every step, so it ends one step past the limit at most
+    auto counted = analyzeCountedLoop(loop, nullptr);
+    auto bound = counted ? evaluate(*counted->bound, *head) : std::nullopt;
+    if (bound) {
+        auto full = *ValueRange::getFull(getType(counted->variable));
+        auto entry = head->contains(counted->variable) ? head->at(counted->variable) : full;
+        if (counted->step > 0) {
+            auto limit = (counted->comparison == LexemType::Less ? bound->max - 1 : bound->max) + counted->step;
+            if (limit <= full.max) {
+                (*head)[counted->variable] = {entry.min, std::max(entry.max, limit)};
+            }
+        } else {
+            auto limit = (counted->comparison == LexemType::Greater ? bound->min + 1 : bound->min) + counted->step;
+            if (limit >= full.min) {
+                (*head)[counted->variable] = {std::min(entry.min, limit), entry.max};
+            }
+        }
+    }
+
+    while (true) {
+        decide(*loop.condition, *head);
+
+        auto body = refine(*loop.condition, *head, true);
+        if (body) {
+            analyzeBlock(*loop.body, body);
+        }
+
+        auto next = head;
+        join(next, body);
+        if (next == head) {
+            break;
+        }
+        widen(*head, *next);
+    }
+
+    state = refine(*loop.condition, *head, false);
+    join(state, _breakStates[&loop]);
+}
+
+std::optional<ValueRange> RangeAnalysis::evaluate(Expression& node, const State& state) {
+    stackGuard();
+
+    auto full = ValueRange::getFull(node.exprType);
+    switch (node.kind) {
+        case Node::Kind::Number: {
+            auto constant = getConstantValue(node);
+            if (!full || !constant) {
+                return full;
+            }
+            return ValueRange{*constant, *constant};
+        }
+        case Node::Kind::Identifier: {
+            auto local = state.find(static_cast<Identifier&>(node).symbolRef);
+            return full && local != state.end() ? std::optional(local->second) : full;
+        }
+        case Node::Kind::PrefixOperation: {
+            auto& operation = static_cast<PrefixOperation&>(node);
+            if (!full) {
+                decide(node, state);
+                return std::nullopt;
+            }
+            auto right = evaluate(*operation.right, state);
+            return right ? getPrefixOperationRange(operation.operationType, *right, node.exprType) : full;
+        }
+        case Node::Kind::BinaryOperation: {
+            auto& operation = static_cast<BinaryOperation&>(node);
+            if (!full) {
+                decide(node, state);
+                return std::nullopt;
+            }
+
+            auto left = evaluate(*operation.left, state);
+            auto right = evaluate(*operation.right, state);
+            if (operation.operationToken == LexemType::Divide || operation.operationToken == LexemType::Remainder) {
+                auto& isNonNegative = _nonNegativeDividends.try_emplace(&operation, true).first->second;
+                isNonNegative = isNonNegative && left && left->min >= 0;
+            }
+            if (!left || !right) {
+                return full;
+            }
+            return getBinaryOperationRange(operation.operationToken, *left, *right, node.exprType);
+        }
+        default:
+            forEachChild(node, [&](Node& child) {
+                evaluate(static_cast<Expression&>(child), state);
+            });
+            return full;
+    }
+}
+std::optional<bool> RangeAnalysis::decide(Expression& node, const State& state) {
+    stackGuard();
+
+    std::optional<bool> result;
+    if (node.kind == Node::Kind::BinaryOperation) {
+        auto& operation = static_cast<BinaryOperation&>(node);
+        if (isComparison(operation.operationToken)) {
+            auto left = evaluate(*operation.left, state);
+            auto right = evaluate(*operation.right, state);
+            if (left && right) {
+                result = compareRanges(operation.operationToken, *left, *right);
+            }
+        } else if (operation.operationToken == LexemType::LogicAnd || operation.operationToken == LexemType::LogicOr) {
+            // Both operands are always evaluated
+            auto left = decide(*operation.left, state);
+            auto right = decide(*operation.right, state);
+            auto isAnd = operation.operationToken == LexemType::LogicAnd;
+            if (left == !isAnd || right == !isAnd) {
+                result = !isAnd;
+            } else if (left && right) {
+                result = isAnd;
+            }
+        } else {
+            evaluate(*operation.left, state);
+            evaluate(*operation.right, state);
+        }
+    } else if (node.kind == Node::Kind::PrefixOperation && static_cast<PrefixOperation&>(node).operationType == LexemType::Not) {
+        auto right = decide(*static_cast<PrefixOperation&>(node).right, state);
+        if (right) {
+            result = !*right;
+        }
+    } else {
+        evaluate(node, state);
+    }
+
+    auto decision = !result ? Decision::Unknown : *result ? Decision::True : Decision::False;
+    auto [previous, isFirst] = _decisions.try_emplace(&node, decision);
+    if (!isFirst && previous->second != decision) {
+        previous->second = Decision::Unknown;
+    }
+    return result;
+}
+std::optional<RangeAnalysis::State> RangeAnalysis::refine(Expression& condition, const State& state, bool isTrue) {
+    stackGuard();
+
+    if (condition.kind == Node::Kind::PrefixOperation &&
+        static_cast<PrefixOperation&>(condition).operationType == LexemType::Not) {
+        return refine(*static_cast<PrefixOperation&>(condition).right, state, !isTrue);
+    }
+    if (condition.kind != Node::Kind::BinaryOperation) {
+        return state;
+    }
+
+    auto& operation = static_cast<BinaryOperation&>(condition);
+    if (isComparison(operation.operationToken)) {
+        return refineComparison(isTrue ? operation.operationToken : negate(operation.operationToken),
+                                *operation.left,
+                                *operation.right,
+                                state);
+    }
+
+    auto isAnd = operation.operationToken == LexemType::LogicAnd;
+    if (!isAnd && operation.operationToken != LexemType::LogicOr) {
+        return state;
+    }
+    // A true `&&` or a false `||` narrows by both operands, otherwise by either of them
+    if (isAnd == isTrue) {
+        auto left = refine(*operation.left, state, isTrue);
+        return left ? refine(*operation.right, *left, isTrue) : std::nullopt;
+    }
+    auto result = refine(*operation.left, state, isTrue);
+    join(result, refine(*operation.right, state, isTrue));
+    return result;
+}
+std::optional<RangeAnalysis::State> RangeAnalysis::refineComparison(LexemType operation,
+                                                                    Expression& left,
+                                                                    Expression& right,
+                                                                    const State& state) {
+    stackGuard();
+
+    auto leftRange = evaluate(left, state);
+    auto rightRange = evaluate(right, state);
+    if (!leftRange || !rightRange) {
+        return state;
+    }
+    if (compareRanges(operation, *leftRange, *rightRange) == false) {
+        return std::nullopt;
+    }
+
+    auto result = state;
+    if (left.kind == Node::Kind::Identifier) {
+        auto narrowed = narrow(operation, *leftRange, *rightRange);
+        if (!narrowed) {
+            return std::nullopt;
+        }
+        result[static_cast<Identifier&>(left).symbolRef] = *narrowed;
+    }
+    if (right.kind == Node::Kind::Identifier) {
+        auto narrowed = narrow(mirror(operation), *rightRange, *leftRange);
+        if (!narrowed) {
+            return std::nullopt;
+        }
+        result[static_cast<Identifier&>(right).symbolRef] = *narrowed;
+    }
+    return result;
+}
+
+void RangeAnalysis::rewriteBlock(StatementsBlock& node) {
+    stackGuard();
+
+    auto statement = node.statements.begin();
+    while (statement != node.statements.end()) {
+        rewriteStatement(*statement);
+        if (*statement == nullptr) {
+            statement = node.statements.erase(statement);
+        } else {
+            ++statement;
+        }
+    }
+}
+void RangeAnalysis::rewriteStatement(NodePtr<Statement>& node) {
+    stackGuard();
+
+    switch (node->kind) {
+        case Node::Kind::StatementBlock:
+            rewriteBlock(static_cast<StatementsBlock&>(*node));
+            break;
+        case Node::Kind::Assign:
+            rewriteExpression(*static_cast<Assign&>(*node).value);
+            break;
+        case Node::Kind::LocalVarDeclaration:
+            rewriteExpression(*static_cast<LocalVariableDeclaration&>(*node).value);
+            break;
+        case Node::Kind::Print:
+            rewriteExpression(*static_cast<Print&>(*node).expression);
+            break;
+        case Node::Kind::Return:
+            rewriteExpression(*static_cast<Return&>(*node).returnExpression);
+            break;
+        case Node::Kind::If: {
+            auto& ifNode = static_cast<If&>(*node);
+            auto decision = getDecision(*ifNode.condition);
+            if (decision != Decision::Unknown && isSpeculatable(*ifNode.condition)) {
+                ++_removed;
+                node = decision == Decision::True ? std::move(ifNode.then) : std::move(ifNode.elseThen);
+                if (node != nullptr) {
+                    rewriteStatement(node);
+                }
+                break;
+            }
+
+            rewriteCondition(ifNode.condition);
+            rewriteBlock(*ifNode.then);
+            if (ifNode.elseThen != nullptr) {
+                rewriteStatement(ifNode.elseThen);
+            }
+            break;
+        }
+        case Node::Kind::While: {
+            auto& loop = static_cast<While&>(*node);
+            if (getDecision(*loop.condition) == Decision::False && isSpeculatable(*loop.condition)) {
+                ++_removed;
+                node = nullptr;
+                break;
+            }
+
+            rewriteCondition(loop.condition);
+            rewriteBlock(*loop.body);
+            break;
+        }
+        default:
+            break;
+    }
+}
+void RangeAnalysis::rewriteCondition(NodePtr<Expression>& node) {
+    stackGuard();
+
+    if (node->kind == Node::Kind::BinaryOperation) {
+        auto& operation = static_cast<BinaryOperation&>(*node);
+        auto isAnd = operation.operationToken == LexemType::LogicAnd;
+        if (isAnd || operation.operationToken == LexemType::LogicOr) {
+            // An operand that always has the neutral value goes, the evaluator computes both anyway
+            auto neutral = isAnd ? Decision::True : Decision::False;
+            if (getDecision(*operation.left) == neutral && isSpeculatable(*operation.left)) {
+                ++_removed;
+                node = std::move(operation.right);
+                rewriteCondition(node);
+                return;
+            }
+            if (getDecision(*operation.right) == neutral && isSpeculatable(*operation.right)) {
+                ++_removed;
+                node = std::move(operation.left);
+                rewriteCondition(node);
+                return;
+            }
+
+            rewriteCondition(operation.left);
+            rewriteCondition(operation.right);
+            return;
+        }
+    }
+    rewriteExpression(*node);
+}
+void RangeAnalysis::rewriteExpression(Expression& node) {
+    stackGuard();
+
+    if (node.kind == Node::Kind::BinaryOperation) {
+        auto& operation = static_cast<BinaryOperation&>(node);
+        auto isNonNegative = _nonNegativeDividends.find(&operation);
+        auto divisor = getConstantValue(*operation.right);
+        if (isNonNegative != _nonNegativeDividends.end() && isNonNegative->second && !operation.isLeftNonNegative) {
+            operation.isLeftNonNegative = true;
+            // Only constant divisors change the generated code
+            if (divisor && *divisor > 1) {
+                ++_narrowed;
+            }
+        }
+    }
+
+    forEachChild(node, [this](Node& child) {
+        rewriteExpression(static_cast<Expression&>(child));
+    });
+}
+RangeAnalysis::Decision RangeAnalysis::getDecision(const Expression& node) const {
+    auto decision = _decisions.find(&node);
+    return decision != _decisions.end() ? decision->second : Decision::Unknown;
+}
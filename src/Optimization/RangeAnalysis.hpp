@@ -0,0 +1,106 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_RANGEANALYSIS_HPP
+#define VUG_RANGEANALYSIS_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+#include "AST/ASTArena.hpp"
+#include "AST/ASTNodesForward.hpp"
+#include "Lexing/Token.hpp"
+#include "Misc/PassProperty.hpp"
+
+class DiagnosticManager;
+class LocalVariableSymbol;
+class Type;
+
+// Interval of the values an integer of at most 32 bits can hold, both ends included
+struct ValueRange {
+    int64_t min;
+    int64_t max;
+
+    // Every value of the type, nullopt for types without ranges
+    static std::optional<ValueRange> getFull(const Type* type);
+
+    [[nodiscard]] bool isConstant() const {
+        return min == max;
+    }
+    [[nodiscard]] ValueRange join(const ValueRange& other) const;
+    // Nullopt when they don't overlap
+    [[nodiscard]] std::optional<ValueRange> intersect(const ValueRange& other) const;
+    bool operator==(const ValueRange& other) const = default;
+};
+
+// Arithmetic on ranges as the evaluator does it: the full range of the type when the result may wrap
+ValueRange getBinaryOperationRange(LexemType operation, const ValueRange& left, const ValueRange& right, const Type* type);
+ValueRange getPrefixOperationRange(LexemType operation, const ValueRange& right, const Type* type);
+// Whether `left operation right` holds for all, none or only some of the values in the ranges
+std::optional<bool> compareRanges(LexemType operation, const ValueRange& left, const ValueRange& right);
+
+// Intraprocedural value-range analysis along the structured control flow. Literals and assignments
+// give ranges, conditions of ifs and loops narrow them on each branch, and loops iterate to a fixpoint,
+// widening any bound that still moves. The counter of a counted loop is bounded by its limit plus the
+// step from the start, when that sum doesn't wrap.
+// Conditions (and operands of `&&` and `||`) decided on every path are removed, so are loops that
+// never run; divisions of operands that are never negative are marked for the code generators.
+class RangeAnalysis {
+public:
+    static constexpr std::string_view name = "range-analysis";
+    static constexpr auto required = PassProperty::LocalsResolved | PassProperty::ConstantsPropagated;
+    static constexpr auto provided = PassProperty::None;
+    static constexpr auto invalidated = PassProperty::None;
+
+    RangeAnalysis(Node& ast,
+                  DiagnosticManager& diagnosticManager)
+        : _ast(ast),
+          _diagnosticManager(diagnosticManager) {}
+
+    void run();
+
+protected:
+    // Ranges of locals on one path, locals without a range may hold any value of their type,
+    // no state means the path never gets there
+    using State = std::unordered_map<const LocalVariableSymbol*, ValueRange>;
+    enum class Decision {
+        True,
+        False,
+        Unknown,
+    };
+
+    Node& _ast;
+    DiagnosticManager& _diagnosticManager;
+
+    // Meet over every evaluation
+    std::unordered_map<const Expression*, Decision> _decisions;
+    std::unordered_map<const BinaryOperation*, bool> _nonNegativeDividends;
+    std::unordered_map<const Statement*, std::optional<State>> _breakStates;
+
+    size_t _removed{0};
+    size_t _narrowed{0};
+
+    static void join(std::optional<State>& state, const std::optional<State>& other);
+    // Moves every bound that grew from `head` to `next` to the end of its type
+    static void widen(State& head, const State& next);
+
+    void analyzeBlock(StatementsBlock& node, std::optional<State>& state);
+    void analyzeStatement(Statement& node, std::optional<State>& state);
+    void analyzeLoop(While& loop, std::optional<State>& state);
+    std::optional<ValueRange> evaluate(Expression& node, const State& state);
+    std::optional<bool> decide(Expression& node, const State& state);
+    // State on the path where the condition has the value `isTrue`
+    std::optional<State> refine(Expression& condition, const State& state, bool isTrue);
+    std::optional<State> refineComparison(LexemType operation, Expression& left, Expression& right, const State& state);
+
+    void rewriteBlock(StatementsBlock& node);
+    // Resets the statement when it is deleted
+    void rewriteStatement(NodePtr<Statement>& node);
+    void rewriteCondition(NodePtr<Expression>& node);
+    void rewriteExpression(Expression& node);
+    [[nodiscard]] Decision getDecision(const Expression& node) const;
+};
+
+#endif//VUG_RANGEANALYSIS_HPP
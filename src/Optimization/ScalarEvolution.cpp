@@ -0,0 +1,391 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ScalarEvolution.hpp"
+
+#include <format>
+
+#include "AST/ASTTraversal.hpp"
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/ASTCloner.hpp"
+#include "Optimization/CallGraph.hpp"
+#include "Optimization/ConstantFolding.hpp"
+
+void ScalarEvolution::run() {
+    stackGuard();
+
+    auto callGraph = CallGraph(_ast);
+    for (auto function: callGraph.getBottomUpOrder()) {
+        replaceLoops(*function->declaration->definition);
+    }
+}
+
+void ScalarEvolution::replaceLoops(Node& node) {
+    stackGuard();
+
+    forEachChild(node, [this](Node& child) {
+        if (child.isStatement()) {
+            replaceLoops(child);
+        }
+    });
+
+    if (node.kind != Node::Kind::StatementBlock) {
+        return;
+    }
+    auto& statements = static_cast<StatementsBlock&>(node).statements;
+    size_t index = 0;
+    while (index < statements.size()) {
+        if (statements[index]->kind != Node::Kind::While) {
+            ++index;
+            continue;
+        }
+
+        auto counted = analyzeCountedLoop(static_cast<While&>(*statements[index]),
+                                          index > 0 ? statements[index - 1].get() : nullptr);
+        auto replacement = counted && !counted->hasBreak ? replaceLoop(*counted) : std::nullopt;
+        if (!replacement) {
+            ++index;
+            continue;
+        }
+
+        auto diagnostic = Diagnostic();
+        diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Info,
+                                                counted->tripCount
+                                                        ? std::format("replaced loop with trip count {} by its closed form",
+                                                                      *counted->tripCount)
+                                                        : std::string("replaced loop by its closed form"),
+                                                {counted->loop->sourceLocation}));
+        _diagnosticManager.report(diagnostic);
+
+        auto count = replacement->size();
+        statements.erase(statements.begin() + static_cast<ptrdiff_t>(index));
+        statements.insert(statements.begin() + static_cast<ptrdiff_t>(index),
+                          std::make_move_iterator(replacement->begin()),
+                          std::make_move_iterator(replacement->end()));
+        index += count;
+    }
+}
+std::optional<NodeList<Statement>> ScalarEvolution::replaceLoop(const CountedLoop& counted) {
+    stackGuard();
+
+    _type = counted.variable->getTypeSymbol()->getType();
+    _sourceLocation = counted.loop->sourceLocation;
+
+    // Without a trip count the loop runs `bound - i` or `i - bound` times once it's entered
+    auto isUp = counted.step == 1 && counted.comparison == LexemType::Less;
+    auto isDown = counted.step == -1 && counted.comparison == LexemType::Greater;
+    if (!counted.tripCount) {
+        auto largest = isUp ? counted.boundValue.value_or(INT32_MAX) - counted.initialValue.value_or(INT32_MIN)
+                            : counted.initialValue.value_or(INT32_MAX) - counted.boundValue.value_or(INT32_MIN);
+        if ((!isUp && !isDown) || largest > INT32_MAX) {
+            return std::nullopt;
+        }
+    }
+
+    std::unordered_set<const LocalVariableSymbol*> assigned;
+    collectAssigned(*counted.loop->body, assigned);
+
+    // Recurrences at the start of an iteration, and the values after the accumulations done so far
+    std::vector<std::pair<LocalVariableSymbol*, Recurrence>> evolutions;
+    Recurrences values;
+    auto& statements = counted.loop->body->statements;
+    for (size_t index = 0; index + 1 < statements.size(); ++index) {
+        if (statements[index]->kind != Node::Kind::Assign) {
+            return std::nullopt;
+        }
+        auto& assign = static_cast<Assign&>(*statements[index]);
+        if (values.contains(assign.symbolRef) || assign.value->kind != Node::Kind::BinaryOperation ||
+            assign.symbolRef->getTypeSymbol()->getType() != _type) {
+            return std::nullopt;
+        }
+
+        auto& operation = static_cast<BinaryOperation&>(*assign.value);
+        auto isVariable = [&assign](const Expression& expression) {
+            return expression.kind == Node::Kind::Identifier &&
+                   static_cast<const Identifier&>(expression).symbolRef == assign.symbolRef;
+        };
+        Expression* increment;
+        if (operation.operationToken == LexemType::Plus && isVariable(*operation.left)) {
+            increment = operation.right.get();
+        } else if (operation.operationToken == LexemType::Plus && isVariable(*operation.right)) {
+            increment = operation.left.get();
+        } else if (operation.operationToken == LexemType::Minus && isVariable(*operation.left)) {
+            increment = operation.right.get();
+        } else {
+            return std::nullopt;
+        }
+
+        // The increment can't read the local, it isn't in `values` yet
+        auto difference = evaluate(*increment, counted, values, assigned);
+        if (!difference || difference->size() >= maxCoefficients) {
+            return std::nullopt;
+        }
+        if (operation.operationToken == LexemType::Minus) {
+            difference = negate(*difference);
+        }
+
+        auto recurrence = Recurrence();
+        recurrence.push_back(_builder.identifier(*assign.symbolRef, _sourceLocation));
+        for (auto& coefficient: *difference) {
+            recurrence.push_back(std::move(coefficient));
+        }
+        values[assign.symbolRef] = shift(recurrence);
+        evolutions.emplace_back(assign.symbolRef, std::move(recurrence));
+    }
+
+    auto induction = Recurrence();
+    induction.push_back(_builder.identifier(*counted.variable, _sourceLocation));
+    induction.push_back(_builder.constant(counted.step, _type, _sourceLocation));
+    evolutions.emplace_back(counted.variable, std::move(induction));
+
+    size_t degree = 0;
+    for (auto& [variable, recurrence]: evolutions) {
+        degree = std::max(degree, recurrence.size());
+    }
+
+    NodeList<Statement> replacement;
+    Recurrence binomials;
+    binomials.push_back(_builder.constant(1, _type, _sourceLocation));
+    if (counted.tripCount) {
+        if (*counted.tripCount == 0) {
+            return replacement;
+        }
+        auto count = *counted.tripCount;
+        binomials.push_back(_builder.constant(wrapValue(static_cast<int64_t>(count), _type), _type, _sourceLocation));
+        binomials.push_back(_builder.constant(wrapValue(static_cast<int64_t>(count * (count - 1) / 2), _type),
+                                              _type,
+                                              _sourceLocation));
+    } else {
+        auto cloner = ASTCloner(_context);
+        auto count = _builder.createVariable("count", _type);
+        replacement.push_back(_builder.declaration(*count,
+                                                   _builder.binaryOperation(LexemType::Minus,
+                                                                            isUp ? cloner.clone(*counted.bound)
+                                                                                 : _builder.identifier(*counted.variable, _sourceLocation),
+                                                                            isUp ? _builder.identifier(*counted.variable, _sourceLocation)
+                                                                                 : cloner.clone(*counted.bound),
+                                                                            _sourceLocation),
+                                                   _sourceLocation));
+        binomials.push_back(_builder.identifier(*count, _sourceLocation));
+
+        if (degree == maxCoefficients) {
+            // C(n, 2) halving the even one of n and n - 1, n isn't negative here
+            auto pairs = _builder.createVariable("pairs", _type);
+            auto half = _builder.binaryOperation(LexemType::Divide,
+                                                 _builder.identifier(*count, _sourceLocation),
+                                                 _builder.constant(2, _type, _sourceLocation),
+                                                 _sourceLocation);
+            auto odd = _builder.binaryOperation(LexemType::Remainder,
+                                                _builder.identifier(*count, _sourceLocation),
+                                                _builder.constant(2, _type, _sourceLocation),
+                                                _sourceLocation);
+            auto other = _builder.binaryOperation(LexemType::Plus,
+                                                  _builder.binaryOperation(LexemType::Minus,
+                                                                           _builder.identifier(*count, _sourceLocation),
+                                                                           _builder.constant(1, _type, _sourceLocation),
+                                                                           _sourceLocation),
+                                                  std::move(odd),
+                                                  _sourceLocation);
+            replacement.push_back(_builder.declaration(*pairs,
+                                                       _builder.binaryOperation(LexemType::Multiply,
+                                                                                std::move(half),
+                                                                                std::move(other),
+                                                                                _sourceLocation),
+                                                       _sourceLocation));
+            binomials.push_back(_builder.identifier(*pairs, _sourceLocation));
+        }
+    }
+
+    // Every final value reads the values on entry, they are all computed before any is stored
+    NodeList<Statement> stores;
+    for (auto& [variable, recurrence]: evolutions) {
+        auto final = _builder.createVariable(variable->getName(), _type);
+        replacement.push_back(_builder.declaration(*final, getFinalValue(recurrence, binomials), _sourceLocation));
+        stores.push_back(_builder.assign(*variable, _builder.identifier(*final, _sourceLocation), _sourceLocation));
+    }
+    for (auto& store: stores) {
+        replacement.push_back(std::move(store));
+    }
+
+    if (counted.tripCount) {
+        return replacement;
+    }
+    // The condition is speculatable, checking it once on entry tells whether the loop runs
+    auto cloner = ASTCloner(_context);
+    NodeList<Statement> guarded;
+    guarded.push_back(makeNode<If>(cloner.clone(*counted.loop->condition),
+                                   makeNode<StatementsBlock>(std::move(replacement), _sourceLocation),
+                                   nullptr,
+                                   _sourceLocation));
+    return guarded;
+}
+
+std::optional<ScalarEvolution::Recurrence> ScalarEvolution::evaluate(Expression& expression,
+                                                                     const CountedLoop& counted,
+                                                                     const Recurrences& values,
+                                                                     const std::unordered_set<const LocalVariableSymbol*>& assigned) {
+    stackGuard();
+
+    if (expression.exprType != _type) {
+        return std::nullopt;
+    }
+    if (auto value = getConstantValue(expression)) {
+        auto recurrence = Recurrence();
+        recurrence.push_back(_builder.constant(wrapValue(*value, _type), _type, _sourceLocation));
+        return recurrence;
+    }
+
+    switch (expression.kind) {
+        case Node::Kind::Identifier: {
+            auto symbol = static_cast<Identifier&>(expression).symbolRef;
+            auto recurrence = Recurrence();
+            if (symbol == counted.variable) {
+                recurrence.push_back(_builder.identifier(*symbol, _sourceLocation));
+                recurrence.push_back(_builder.constant(counted.step, _type, _sourceLocation));
+                return recurrence;
+            }
+            if (auto value = values.find(symbol); value != values.end()) {
+                return copy(value->second);
+            }
+            // Locals the loop assigns later in the iteration change under this read
+            if (assigned.contains(symbol)) {
+                return std::nullopt;
+            }
+            recurrence.push_back(_builder.identifier(*symbol, _sourceLocation));
+            return recurrence;
+        }
+        case Node::Kind::PrefixOperation: {
+            auto& operation = static_cast<PrefixOperation&>(expression);
+            if (operation.operationType != LexemType::Minus) {
+                return std::nullopt;
+            }
+            auto right = evaluate(*operation.right, counted, values, assigned);
+            return right ? std::optional(negate(*right)) : std::nullopt;
+        }
+        case Node::Kind::BinaryOperation: {
+            auto& operation = static_cast<BinaryOperation&>(expression);
+            auto left = evaluate(*operation.left, counted, values, assigned);
+            auto right = evaluate(*operation.right, counted, values, assigned);
+            if (!left || !right) {
+                return std::nullopt;
+            }
+
+            switch (operation.operationToken) {
+                case LexemType::Plus:
+                    return add(*left, *right);
+                case LexemType::Minus:
+                    return add(*left, negate(*right));
+                case LexemType::Multiply: {
+                    // The product of two recurrences is only one if a factor doesn't change
+                    if (left->size() > 1 && right->size() > 1) {
+                        return std::nullopt;
+                    }
+                    auto& factor = left->size() == 1 ? *left : *right;
+                    auto& other = left->size() == 1 ? *right : *left;
+                    auto recurrence = Recurrence();
+                    for (auto& coefficient: other) {
+                        recurrence.push_back(product(copy(*factor.front()), std::move(coefficient)));
+                    }
+                    return recurrence;
+                }
+                default:
+                    return std::nullopt;
+            }
+        }
+        default:
+            return std::nullopt;
+    }
+}
+NodePtr<Expression> ScalarEvolution::getFinalValue(const Recurrence& recurrence, const Recurrence& binomials) {
+    stackGuard();
+
+    auto value = _builder.constant(0, _type, _sourceLocation);
+    for (size_t index = 0; index < recurrence.size(); ++index) {
+        value = sum(std::move(value), product(copy(*recurrence[index]), copy(*binomials[index])));
+    }
+    return value;
+}
+
+ScalarEvolution::Recurrence ScalarEvolution::copy(const Recurrence& recurrence) {
+    auto result = Recurrence();
+    for (auto& coefficient: recurrence) {
+        result.push_back(copy(*coefficient));
+    }
+    return result;
+}
+ScalarEvolution::Recurrence ScalarEvolution::add(const Recurrence& left, const Recurrence& right) {
+    auto result = Recurrence();
+    for (size_t index = 0; index < std::max(left.size(), right.size()); ++index) {
+        auto coefficient = _builder.constant(0, _type, _sourceLocation);
+        if (index < left.size()) {
+            coefficient = sum(std::move(coefficient), copy(*left[index]));
+        }
+        if (index < right.size()) {
+            coefficient = sum(std::move(coefficient), copy(*right[index]));
+        }
+        result.push_back(std::move(coefficient));
+    }
+
+    // Cancelled terms lower the degree
+    while (result.size() > 1 && getConstantValue(*result.back()) == 0) {
+        result.pop_back();
+    }
+    return result;
+}
+ScalarEvolution::Recurrence ScalarEvolution::negate(const Recurrence& recurrence) {
+    auto result = Recurrence();
+    for (auto& coefficient: recurrence) {
+        result.push_back(product(_builder.constant(-1, _type, _sourceLocation), copy(*coefficient)));
+    }
+    return result;
+}
+ScalarEvolution::Recurrence ScalarEvolution::shift(const Recurrence& recurrence) {
+    // C(k + 1, j) = C(k, j) + C(k, j - 1)
+    auto result = Recurrence();
+    for (size_t index = 0; index < recurrence.size(); ++index) {
+        auto coefficient = copy(*recurrence[index]);
+        if (index + 1 < recurrence.size()) {
+            coefficient = sum(std::move(coefficient), copy(*recurrence[index + 1]));
+        }
+        result.push_back(std::move(coefficient));
+    }
+    return result;
+}
+
+NodePtr<Expression> ScalarEvolution::sum(NodePtr<Expression> left, NodePtr<Expression> right) {
+    auto leftValue = getConstantValue(*left);
+    auto rightValue = getConstantValue(*right);
+    if (leftValue && rightValue) {
+        return _builder.constant(wrapValue(*leftValue + *rightValue, _type), _type, _sourceLocation);
+    }
+    if (leftValue == 0) {
+        return right;
+    }
+    if (rightValue == 0) {
+        return left;
+    }
+    return _builder.binaryOperation(LexemType::Plus, std::move(left), std::move(right), _sourceLocation);
+}
+NodePtr<Expression> ScalarEvolution::product(NodePtr<Expression> left, NodePtr<Expression> right) {
+    auto leftValue = getConstantValue(*left);
+    auto rightValue = getConstantValue(*right);
+    if (leftValue && rightValue) {
+        auto value = static_cast<int64_t>(static_cast<uint64_t>(*leftValue) * static_cast<uint64_t>(*rightValue));
+        return _builder.constant(wrapValue(value, _type), _type, _sourceLocation);
+    }
+    if (leftValue == 0 || rightValue == 0) {
+        return _builder.constant(0, _type, _sourceLocation);
+    }
+    if (leftValue == 1) {
+        return right;
+    }
+    if (rightValue == 1) {
+        return left;
+    }
+    return _builder.binaryOperation(LexemType::Multiply, std::move(left), std::move(right), _sourceLocation);
+}
+NodePtr<Expression> ScalarEvolution::copy(Expression& expression) {
+    auto cloner = ASTCloner(_context);
+    return cloner.clone(expression);
+}
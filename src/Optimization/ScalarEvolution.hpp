@@ -0,0 +1,84 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_SCALAREVOLUTION_HPP
+#define VUG_SCALAREVOLUTION_HPP
+
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "AST/ASTArena.hpp"
+#include "AST/ASTNodesForward.hpp"
+#include "Misc/PassProperty.hpp"
+#include "Optimization/ASTBuilder.hpp"
+#include "Optimization/LoopAnalysis.hpp"
+
+class DiagnosticManager;
+class SymbolContext;
+
+// Replaces counted loops whose body only accumulates, `s = s + e` or `s = s - e` with `e` built by `+`, `-`
+// and `*` from the induction variable, loop invariants and the locals accumulated before it, by the final
+// values of those locals. After k iterations such a local is a polynomial in k of degree 2 at most, kept
+// as coefficients of the binomials C(k, j) so it stays exact when integers wrap.
+// A loop with an unknown trip count needs a step of 1 or -1, `<` or `>`, and a count that fits in int32.
+class ScalarEvolution {
+public:
+    static constexpr std::string_view name = "scalar-evolution";
+    static constexpr auto required = PassProperty::LocalsResolved;
+    static constexpr auto provided = PassProperty::None;
+    static constexpr auto invalidated = PassProperty::ConstantsPropagated;
+
+    ScalarEvolution(Node& ast,
+                    SymbolContext& context,
+                    DiagnosticManager& diagnosticManager)
+        : _ast(ast),
+          _context(context),
+          _builder(context),
+          _diagnosticManager(diagnosticManager) {}
+
+    void run();
+
+protected:
+    // Value in iteration k, counting from 0, is the sum of `coefficients[j] * C(k, j)`
+    using Recurrence = NodeList<Expression>;
+    using Recurrences = std::unordered_map<const LocalVariableSymbol*, Recurrence>;
+    static constexpr size_t maxCoefficients = 3;
+
+    Node& _ast;
+    SymbolContext& _context;
+    ASTBuilder _builder;
+    DiagnosticManager& _diagnosticManager;
+
+    // Of the loop being replaced
+    const Type* _type{nullptr};
+    SourceLocation _sourceLocation;
+
+    void replaceLoops(Node& node);
+    // Returns the statements replacing the loop
+    std::optional<NodeList<Statement>> replaceLoop(const CountedLoop& counted);
+
+    // Recurrence of the expression's value, `values` holds the locals accumulated so far in the iteration
+    std::optional<Recurrence> evaluate(Expression& expression,
+                                       const CountedLoop& counted,
+                                       const Recurrences& values,
+                                       const std::unordered_set<const LocalVariableSymbol*>& assigned);
+    // `binomials` are C(n, j) for the trip count n
+    NodePtr<Expression> getFinalValue(const Recurrence& recurrence, const Recurrence& binomials);
+
+    Recurrence copy(const Recurrence& recurrence);
+    Recurrence add(const Recurrence& left, const Recurrence& right);
+    Recurrence negate(const Recurrence& recurrence);
+    // Value in the next iteration
+    Recurrence shift(const Recurrence& recurrence);
+
+    // Folding constants on the way
+    NodePtr<Expression> sum(NodePtr<Expression> left, NodePtr<Expression> right);
+    NodePtr<Expression> product(NodePtr<Expression> left, NodePtr<Expression> right);
+    NodePtr<Expression> copy(Expression& expression);
+};
+
+#endif//VUG_SCALAREVOLUTION_HPP
@@ -0,0 +1,201 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "StrengthReduction.hpp"
+
+#include <algorithm>
+
+#include "AST/ASTTraversal.hpp"
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/CallGraph.hpp"
+#include "Optimization/ConstantFolding.hpp"
+#include "Optimization/LoopAnalysis.hpp"
+
+void StrengthReduction::run() {
+    stackGuard();
+
+    auto callGraph = CallGraph(_ast);
+    for (auto function: callGraph.getBottomUpOrder()) {
+        _replaced = 0;
+        reduceLoops(*function->declaration->definition);
+
+        if (_replaced > 0) {
+            auto diagnostic = Diagnostic();
+            diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Info,
+                                                    std::format("strength reduction replaced {} multiplications in '{}'",
+                                                                _replaced,
+                                                                function->declaration->name),
+                                                    {function->declaration->sourceLocation}));
+            _diagnosticManager.report(diagnostic);
+        }
+    }
+}
+
+void StrengthReduction::reduceLoops(Node& node) {
+    stackGuard();
+
+    // Inner loops first, their declarations may hold products of the outer ones
+    forEachChild(node, [this](Node& child) {
+        if (child.isStatement()) {
+            reduceLoops(child);
+        }
+    });
+
+    if (node.kind != Node::Kind::StatementBlock) {
+        return;
+    }
+    auto& block = static_cast<StatementsBlock&>(node);
+    for (size_t index = 0; index < block.statements.size(); ++index) {
+        if (block.statements[index]->kind != Node::Kind::While) {
+            continue;
+        }
+
+        auto declarations = reduceLoop(static_cast<While&>(*block.statements[index]));
+        auto count = declarations.size();
+        block.statements.insert(block.statements.begin() + static_cast<ptrdiff_t>(index),
+                                std::make_move_iterator(declarations.begin()),
+                                std::make_move_iterator(declarations.end()));
+        index += count;
+    }
+}
+NodeList<Statement> StrengthReduction::reduceLoop(While& loop) {
+    stackGuard();
+
+    Inductions inductions;
+    collectInductions(*loop.body, inductions);
+    std::erase_if(inductions, [](const auto& induction) {
+        return !induction.second.isInduction;
+    });
+    if (inductions.empty()) {
+        return {};
+    }
+
+    std::vector<Product> products;
+    collectProducts(loop, inductions, products);
+
+    NodeList<Statement> declarations;
+    std::unordered_map<const Assign*, NodeList<Statement>> updates;
+    for (auto& product: products) {
+        auto sourceLocation = (*product.uses.front())->sourceLocation;
+        auto type = (*product.uses.front())->exprType;
+        auto reduced = _builder.createVariable(product.symbol->getName(), type);
+
+        declarations.push_back(_builder.declaration(*reduced,
+                                                    _builder.binaryOperation(LexemType::Multiply,
+                                                                             _builder.identifier(*product.symbol, sourceLocation),
+                                                                             _builder.constant(product.factor, type, sourceLocation),
+                                                                             sourceLocation),
+                                                    sourceLocation));
+        for (auto use: product.uses) {
+            *use = _builder.identifier(*reduced, (*use)->sourceLocation);
+        }
+        _replaced += product.uses.size();
+
+        for (auto [assign, step]: inductions[product.symbol].steps) {
+            auto increment = wrapValue(static_cast<int64_t>(static_cast<uint64_t>(step) * static_cast<uint64_t>(product.factor)),
+                                       type);
+            updates[assign].push_back(_builder.assign(*reduced,
+                                                      _builder.binaryOperation(LexemType::Plus,
+                                                                               _builder.identifier(*reduced, assign->sourceLocation),
+                                                                               _builder.constant(increment, type, assign->sourceLocation),
+                                                                               assign->sourceLocation),
+                                                      assign->sourceLocation));
+        }
+    }
+
+    if (!updates.empty()) {
+        insertUpdates(*loop.body, updates);
+    }
+    return declarations;
+}
+
+void StrengthReduction::collectInductions(Node& node, Inductions& inductions) {
+    stackGuard();
+
+    if (node.kind == Node::Kind::Assign) {
+        auto& assign = static_cast<Assign&>(node);
+        auto& induction = inductions[assign.symbolRef];
+        auto step = getInductionStep(assign);
+
+        if (step && ASTBuilder::canMaterialize(assign.value->exprType) && assign.value->exprType->isInteger()) {
+            induction.steps.emplace_back(&assign, *step);
+        } else {
+            induction.isInduction = false;
+        }
+    } else if (node.kind == Node::Kind::LocalVarDeclaration) {
+        // Declared in the loop, there is no value in front of it
+        inductions[static_cast<LocalVariableDeclaration&>(node).symbolRef].isInduction = false;
+    }
+
+    forEachChild(node, [&inductions](Node& child) {
+        if (child.isStatement()) {
+            collectInductions(child, inductions);
+        }
+    });
+}
+void StrengthReduction::collectProducts(Node& node, const Inductions& inductions, std::vector<Product>& products) {
+    stackGuard();
+
+    forEachExpressionSlot(node, [&](NodePtr<Expression>& expression) {
+        if (expression->kind == Node::Kind::BinaryOperation &&
+            static_cast<BinaryOperation&>(*expression).operationToken == LexemType::Multiply &&
+            ASTBuilder::canMaterialize(expression->exprType)) {
+            auto& operation = static_cast<BinaryOperation&>(*expression);
+            auto isIdentifier = operation.left->kind == Node::Kind::Identifier;
+            auto& variable = isIdentifier ? operation.left : operation.right;
+            auto factor = getConstantValue(isIdentifier ? *operation.right : *operation.left);
+
+            if (variable->kind == Node::Kind::Identifier && factor) {
+                auto symbol = static_cast<Identifier&>(*variable).symbolRef;
+                if (inductions.contains(symbol)) {
+                    auto product = std::find_if(products.begin(), products.end(), [&](const Product& other) {
+                        return other.symbol == symbol && other.factor == *factor;
+                    });
+                    if (product == products.end()) {
+                        products.push_back({symbol, *factor, {}});
+                        product = products.end() - 1;
+                    }
+                    product->uses.push_back(&expression);
+                    return;
+                }
+            }
+        }
+        collectProducts(*expression, inductions, products);
+    });
+
+    forEachChild(node, [&](Node& child) {
+        if (child.isStatement()) {
+            collectProducts(child, inductions, products);
+        }
+    });
+}
+void StrengthReduction::insertUpdates(Node& node, std::unordered_map<const Assign*, NodeList<Statement>>& updates) {
+    stackGuard();
+
+    forEachChild(node, [&](Node& child) {
+        if (child.isStatement()) {
+            insertUpdates(child, updates);
+        }
+    });
+
+    if (node.kind != Node::Kind::StatementBlock) {
+        return;
+    }
+    auto& statements = static_cast<StatementsBlock&>(node).statements;
+    for (size_t index = 0; index < statements.size(); ++index) {
+        if (statements[index]->kind != Node::Kind::Assign) {
+            continue;
+        }
+        auto update = updates.find(static_cast<const Assign*>(statements[index].get()));
+        if (update == updates.end()) {
+            continue;
+        }
+
+        auto count = update->second.size();
+        statements.insert(statements.begin() + static_cast<ptrdiff_t>(index) + 1,
+                          std::make_move_iterator(update->second.begin()),
+                          std::make_move_iterator(update->second.end()));
+        index += count;
+    }
+}
@@ -0,0 +1,68 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_STRENGTHREDUCTION_HPP
+#define VUG_STRENGTHREDUCTION_HPP
+
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "AST/ASTArena.hpp"
+#include "AST/ASTNodesForward.hpp"
+#include "Misc/PassProperty.hpp"
+#include "Optimization/ASTBuilder.hpp"
+
+class DiagnosticManager;
+class SymbolContext;
+
+// Replaces `i * k` inside a loop, where every assignment of `i` in the loop adds a constant to it,
+// by a local declared as `i * k` in front of the loop and advanced by that constant times `k` right
+// after each of those assignments. Integers wrap, so the local equals `i * k` everywhere in the loop.
+// Multiplications and divisions by constants are left to the code generators.
+class StrengthReduction {
+public:
+    static constexpr std::string_view name = "strength-reduction";
+    static constexpr auto required = PassProperty::LocalsResolved;
+    static constexpr auto provided = PassProperty::None;
+    static constexpr auto invalidated = PassProperty::None;
+
+    StrengthReduction(Node& ast,
+                      SymbolContext& context,
+                      DiagnosticManager& diagnosticManager)
+        : _ast(ast),
+          _builder(context),
+          _diagnosticManager(diagnosticManager) {}
+
+    void run();
+
+protected:
+    struct Induction {
+        // Assignments adding a constant, no others are allowed
+        std::vector<std::pair<Assign*, int64_t>> steps;
+        bool isInduction{true};
+    };
+    using Inductions = std::unordered_map<const LocalVariableSymbol*, Induction>;
+    struct Product {
+        LocalVariableSymbol* symbol;
+        int64_t factor;
+        std::vector<NodePtr<Expression>*> uses;
+    };
+
+    Node& _ast;
+    ASTBuilder _builder;
+    DiagnosticManager& _diagnosticManager;
+
+    size_t _replaced{0};
+
+    void reduceLoops(Node& node);
+    // Returns the declarations to put in front of the loop
+    NodeList<Statement> reduceLoop(While& loop);
+
+    static void collectInductions(Node& node, Inductions& inductions);
+    static void collectProducts(Node& node, const Inductions& inductions, std::vector<Product>& products);
+    void insertUpdates(Node& node, std::unordered_map<const Assign*, NodeList<Statement>>& updates);
+};
+
+#endif//VUG_STRENGTHREDUCTION_HPP
@@ -0,0 +1,288 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ValueNumbering.hpp"
+
+#include "AST/ASTTraversal.hpp"
+#include "Diagnostic/DiagnosticManager.hpp"
+#include "Misc/Stack.hpp"
+#include "Optimization/CallGraph.hpp"
+#include "Optimization/ConstantFolding.hpp"
+
+namespace {
+    bool isCommutative(LexemType operation) {
+        switch (operation) {
+            case LexemType::Plus:
+            case LexemType::Multiply:
+            case LexemType::Equal:
+            case LexemType::Unequal:
+            case LexemType::LogicAnd:
+            case LexemType::LogicOr:
+                return true;
+            default:
+                return false;
+        }
+    }
+    bool hasIdentifier(Node& node) {
+        stackGuard();
+
+        bool result = node.kind == Node::Kind::Identifier;
+        forEachChild(node, [&result](Node& child) {
+            result = result || hasIdentifier(child);
+        });
+        return result;
+    }
+}// namespace
+
+void ValueNumbering::run() {
+    stackGuard();
+
+    auto callGraph = CallGraph(_ast);
+    for (auto function: callGraph.getBottomUpOrder()) {
+        numberFunction(*function->declaration);
+    }
+}
+
+void ValueNumbering::numberFunction(FunctionDeclaration& function) {
+    stackGuard();
+
+    _versions.clear();
+    _candidates.clear();
+    _available.clear();
+
+    numberBlock(*function.definition);
+
+    auto eliminated = eliminate(*function.definition);
+    if (eliminated > 0) {
+        auto diagnostic = Diagnostic();
+        diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Info,
+                                                std::format("value numbering eliminated {} expressions in '{}'",
+                                                            eliminated,
+                                                            function.name),
+                                                {function.sourceLocation}));
+        _diagnosticManager.report(diagnostic);
+    }
+}
+void ValueNumbering::numberBlock(StatementsBlock& node) {
+    stackGuard();
+
+    _scopes.emplace_back();
+    for (auto& statement: node.statements) {
+        _statement = statement.get();
+        numberStatement(*statement);
+    }
+
+    for (auto number: _scopes.back()) {
+        _available.erase(number);
+    }
+    _scopes.pop_back();
+}
+void ValueNumbering::numberStatement(Statement& node) {
+    stackGuard();
+
+    switch (node.kind) {
+        case Node::Kind::StatementBlock:
+            numberBlock(static_cast<StatementsBlock&>(node));
+            break;
+        case Node::Kind::Assign: {
+            auto& assign = static_cast<Assign&>(node);
+            _versions[assign.symbolRef] = numberExpression(assign.value, true);
+            break;
+        }
+        case Node::Kind::LocalVarDeclaration: {
+            auto& declaration = static_cast<LocalVariableDeclaration&>(node);
+            _versions[declaration.symbolRef] = numberExpression(declaration.value, true);
+            break;
+        }
+        case Node::Kind::Print:
+            numberExpression(static_cast<Print&>(node).expression, true);
+            break;
+        case Node::Kind::Return:
+            numberExpression(static_cast<Return&>(node).returnExpression, true);
+            break;
+        case Node::Kind::If: {
+            // Conditions of else-if branches only run when the ones before them are false
+            auto ifNode = &static_cast<If&>(node);
+            numberExpression(ifNode->condition, true);
+
+            auto versions = _versions;
+            while (ifNode != nullptr) {
+                numberBlock(*ifNode->then);
+                _versions = versions;
+
+                auto elseThen = ifNode->elseThen.get();
+                ifNode = nullptr;
+                if (elseThen != nullptr && elseThen->kind == Node::Kind::If) {
+                    ifNode = static_cast<If*>(elseThen);
+                    numberExpression(ifNode->condition, false);
+                } else if (elseThen != nullptr) {
+                    numberStatement(*elseThen);
+                    _versions = versions;
+                }
+            }
+            killAssigned(node);
+            break;
+        }
+        case Node::Kind::While: {
+            // The condition and the body see the values of every iteration
+            auto& loop = static_cast<While&>(node);
+            killAssigned(loop);
+            numberExpression(loop.condition, false);
+            numberBlock(*loop.body);
+            killAssigned(loop);
+            break;
+        }
+        default:
+            break;
+    }
+}
+ValueNumbering::Number ValueNumbering::numberExpression(NodePtr<Expression>& node, bool isHoistable) {
+    stackGuard();
+
+    auto number = getNumber(*node);
+    auto isValue = isCandidate(*node);
+
+    if (isValue) {
+        auto leader = _available.find(number);
+        if (leader != _available.end()) {
+            leader->second->users.push_back(&node);
+            return number;
+        }
+    }
+
+    forEachExpressionSlot(*node, [this, isHoistable](NodePtr<Expression>& expression) {
+        numberExpression(expression, isHoistable);
+    });
+
+    if (isValue && isHoistable) {
+        _candidates.push_back(std::make_unique<Candidate>(Candidate{&node, _statement, {}}));
+        _available[number] = _candidates.back().get();
+        _scopes.back().push_back(number);
+    }
+    return number;
+}
+ValueNumbering::Number ValueNumbering::getNumber(const Expression& node) {
+    stackGuard();
+
+    switch (node.kind) {
+        case Node::Kind::Number: {
+            auto value = getConstantValue(node);
+            if (!value) {
+                return _nextNumber++;
+            }
+            auto [constant, isInserted] = _constants.try_emplace(*value, _nextNumber);
+            _nextNumber += isInserted ? 1 : 0;
+            return constant->second;
+        }
+        case Node::Kind::Identifier:
+            return getVersion(static_cast<const Identifier&>(node).symbolRef);
+        case Node::Kind::BinaryOperation: {
+            const auto& operation = static_cast<const BinaryOperation&>(node);
+            auto left = getNumber(*operation.left);
+            auto right = getNumber(*operation.right);
+            if (isCommutative(operation.operationToken) && right < left) {
+                std::swap(left, right);
+            }
+
+            auto key = Key(node.kind, operation.operationToken, operation.left->exprType, left, right);
+            auto [number, isInserted] = _numbers.try_emplace(key, _nextNumber);
+            _nextNumber += isInserted ? 1 : 0;
+            return number->second;
+        }
+        case Node::Kind::PrefixOperation: {
+            const auto& operation = static_cast<const PrefixOperation&>(node);
+            auto right = getNumber(*operation.right);
+
+            auto key = Key(node.kind, operation.operationType, operation.right->exprType, right, 0);
+            auto [number, isInserted] = _numbers.try_emplace(key, _nextNumber);
+            _nextNumber += isInserted ? 1 : 0;
+            return number->second;
+        }
+        default:
+            // Calls may print, every one computes a value of its own
+            return _nextNumber++;
+    }
+}
+ValueNumbering::Number ValueNumbering::getVersion(const LocalVariableSymbol* symbol) {
+    auto [version, isInserted] = _versions.try_emplace(symbol, _nextNumber);
+    _nextNumber += isInserted ? 1 : 0;
+    return version->second;
+}
+void ValueNumbering::killAssigned(Node& node) {
+    stackGuard();
+
+    if (node.kind == Node::Kind::Assign) {
+        _versions[static_cast<Assign&>(node).symbolRef] = _nextNumber++;
+    } else if (node.kind == Node::Kind::LocalVarDeclaration) {
+        _versions[static_cast<LocalVariableDeclaration&>(node).symbolRef] = _nextNumber++;
+    }
+
+    forEachChild(node, [this](Node& child) {
+        if (child.isStatement()) {
+            killAssigned(child);
+        }
+    });
+}
+
+size_t ValueNumbering::eliminate(StatementsBlock& definition) {
+    stackGuard();
+
+    std::unordered_map<const Statement*, NodeList<Statement>> hoisted;
+    size_t eliminated = 0;
+
+    // Leaders were recorded operands first, so a leader inside another one is replaced before it moves
+    for (auto& candidate: _candidates) {
+        if (candidate->users.empty()) {
+            continue;
+        }
+
+        auto& slot = *candidate->slot;
+        auto sourceLocation = slot->sourceLocation;
+        auto temporary = _builder.createVariable("value", slot->exprType);
+
+        for (auto user: candidate->users) {
+            *user = _builder.identifier(*temporary, (*user)->sourceLocation);
+        }
+        eliminated += candidate->users.size();
+
+        hoisted[candidate->statement].push_back(_builder.declaration(*temporary, std::move(slot), sourceLocation));
+        slot = _builder.identifier(*temporary, sourceLocation);
+    }
+
+    if (!hoisted.empty()) {
+        insertHoisted(definition, hoisted);
+    }
+    return eliminated;
+}
+void ValueNumbering::insertHoisted(Node& node,
+                                   std::unordered_map<const Statement*, NodeList<Statement>>& hoisted) {
+    stackGuard();
+
+    if (node.kind == Node::Kind::StatementBlock) {
+        auto& block = static_cast<StatementsBlock&>(node);
+        NodeList<Statement> statements;
+        for (auto& statement: block.statements) {
+            auto declarations = hoisted.find(statement.get());
+            if (declarations != hoisted.end()) {
+                for (auto& declaration: declarations->second) {
+                    statements.push_back(std::move(declaration));
+                }
+            }
+            statements.push_back(std::move(statement));
+        }
+        block.statements = std::move(statements);
+    }
+
+    forEachChild(node, [this, &hoisted](Node& child) {
+        if (child.isStatement()) {
+            insertHoisted(child, hoisted);
+        }
+    });
+}
+
+bool ValueNumbering::isCandidate(const Expression& node) {
+    return (node.kind == Node::Kind::BinaryOperation || node.kind == Node::Kind::PrefixOperation) &&
+           ASTBuilder::canMaterialize(node.exprType) &&
+           isSpeculatable(node) &&
+           hasIdentifier(const_cast<Expression&>(node));
+}
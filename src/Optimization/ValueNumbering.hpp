@@ -0,0 +1,86 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_VALUENUMBERING_HPP
+#define VUG_VALUENUMBERING_HPP
+
+#include <map>
+#include <memory>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "AST/ASTArena.hpp"
+#include "AST/ASTNodesForward.hpp"
+#include "Lexing/Token.hpp"
+#include "Misc/PassProperty.hpp"
+#include "Optimization/ASTBuilder.hpp"
+
+class DiagnosticManager;
+class SymbolContext;
+class Type;
+
+// Global value numbering over the dominator tree of structured control flow.
+// Expressions of locals, literals and operators that can't trap get a number equal for equal values;
+// an assignment gives its local a new number, so expressions reading the old value stop matching.
+// A repeated expression is replaced by a temporary declared in front of the statement that first
+// computes it, as long as that statement dominates the repetition.
+class ValueNumbering {
+public:
+    static constexpr std::string_view name = "value-numbering";
+    static constexpr auto required = PassProperty::LocalsResolved;
+    static constexpr auto provided = PassProperty::None;
+    static constexpr auto invalidated = PassProperty::None;
+
+    ValueNumbering(Node& ast,
+                   SymbolContext& context,
+                   DiagnosticManager& diagnosticManager)
+        : _ast(ast),
+          _builder(context),
+          _diagnosticManager(diagnosticManager) {}
+
+    void run();
+
+protected:
+    using Number = size_t;
+    // Kind, operation, operand type and the numbers of the operands
+    using Key = std::tuple<Node::Kind, LexemType, const Type*, Number, Number>;
+
+    struct Candidate {
+        NodePtr<Expression>* slot;
+        const Statement* statement;
+        std::vector<NodePtr<Expression>*> users;
+    };
+
+    Node& _ast;
+    ASTBuilder _builder;
+    DiagnosticManager& _diagnosticManager;
+
+    Number _nextNumber{0};
+    std::map<Key, Number> _numbers;
+    std::unordered_map<int64_t, Number> _constants;
+    std::unordered_map<const LocalVariableSymbol*, Number> _versions;
+
+    // Leaders of the values computed on every path to the current statement, undone per block
+    std::vector<std::unique_ptr<Candidate>> _candidates;
+    std::unordered_map<Number, Candidate*> _available;
+    std::vector<std::vector<Number>> _scopes;
+    const Statement* _statement{nullptr};
+
+    void numberFunction(FunctionDeclaration& function);
+    void numberBlock(StatementsBlock& node);
+    void numberStatement(Statement& node);
+    // Leaders are only taken from expressions that can be evaluated in front of their statement
+    Number numberExpression(NodePtr<Expression>& node, bool isHoistable);
+    Number getNumber(const Expression& node);
+    Number getVersion(const LocalVariableSymbol* symbol);
+    void killAssigned(Node& node);
+
+    size_t eliminate(StatementsBlock& definition);
+    void insertHoisted(Node& node, std::unordered_map<const Statement*, NodeList<Statement>>& hoisted);
+
+    [[nodiscard]] static bool isCandidate(const Expression& node);
+};
+
+#endif//VUG_VALUENUMBERING_HPP
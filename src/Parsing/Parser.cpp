@@ -2,6 +2,9 @@
 // If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <Diagnostic/DiagnosticManager.hpp>
+#include <algorithm>
+#include <array>
+#include <iterator>
 #include <memory>
 
 #include "Parser.hpp"
@@ -10,26 +13,82 @@
 #include "Misc/Stack.hpp"
 #include "Diagnostic/DiagnosticManager.hpp"
 
-std::unique_ptr<Node> Parser::program() {
+namespace {
+enum class Associativity {
+    Left,
+    // a < b < c is a < (b < c)
+    Right,
+    // a == b == c ends after a == b
+    None,
+};
+
+struct BinaryOperator {
+    // Higher binds tighter, 0 for tokens that aren't binary operators. Prefix operators bind tighter
+    // than all of them.
+    uint8_t precedence{0};
+    Associativity associativity{Associativity::Left};
+};
+
+// Indexed by LexemType
+constexpr auto binaryOperators = [] {
+    std::array<BinaryOperator, static_cast<size_t>(LexemType::EndOfFile) + 1> table{};
+    auto set = [&table](LexemType type, uint8_t precedence, Associativity associativity) {
+        table[static_cast<size_t>(type)] = {precedence, associativity};
+    };
+    set(LexemType::LogicOr, 1, Associativity::Left);
+    set(LexemType::LogicAnd, 2, Associativity::Left);
+    set(LexemType::BitOr, 3, Associativity::Left);
+    set(LexemType::BitXor, 4, Associativity::Left);
+    set(LexemType::BitAnd, 5, Associativity::Left);
+    set(LexemType::Equal, 6, Associativity::None);
+    set(LexemType::Unequal, 6, Associativity::None);
+    set(LexemType::Less, 7, Associativity::Right);
+    set(LexemType::LessEqual, 7, Associativity::Right);
+    set(LexemType::Greater, 7, Associativity::Right);
+    set(LexemType::GreaterEqual, 7, Associativity::Right);
+    set(LexemType::Plus, 8, Associativity::Left);
+    set(LexemType::Minus, 8, Associativity::Left);
+    set(LexemType::Multiply, 9, Associativity::Left);
+    set(LexemType::Divide, 9, Associativity::Left);
+    set(LexemType::Remainder, 9, Associativity::Left);
+    return table;
+}();
+
+const BinaryOperator& getBinaryOperator(LexemType type) {
+    return binaryOperators[static_cast<size_t>(type)];
+}
+}
+
+Parser::Parser(TokenQueue& queue,
+               DiagnosticManager& diagnosticManager,
+               SingleProducerQueue<FunctionDeclaration*>* completedFunctions)
+    : _tokens(*queue.pop()),
+      _queue(&queue),
+      _diagnosticManager(diagnosticManager),
+      _completedFunctions(completedFunctions) {}
+
+Parser::~Parser() = default;
+
+NodePtr<Node> Parser::program() {
     stackGuard();
 
     auto program = declaration();
-    if (_current != LexemType::EndOfFile) {
+    if (current() != LexemType::EndOfFile) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "unexpected token",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         _diagnosticManager.report(diagnostic);
     }
 
     return program;
 }
 
-std::unique_ptr<Declaration> Parser::declaration() {
+NodePtr<Declaration> Parser::declaration() {
     stackGuard();
 
     try {
-        switch (_current.getType()) {
+        switch (current().getType()) {
             case LexemType::Mod:
                 return moduleDeclaration();
             case LexemType::Func:
@@ -42,9 +101,9 @@ std::unique_ptr<Declaration> Parser::declaration() {
 
         int64_t level = 0;
         while (true) {
-            if (_current == LexemType::LeftCurlyBracket) {
+            if (current() == LexemType::LeftCurlyBracket) {
                 level++;
-            } else if (_current == LexemType::RightCurlyBracket) {
+            } else if (current() == LexemType::RightCurlyBracket) {
                 level--;
                 if (level == 0) {
                     advance();
@@ -52,201 +111,205 @@ std::unique_ptr<Declaration> Parser::declaration() {
                 }
             }
 
-            if (level < 0) {
+            if (level < 0 || current() == LexemType::EndOfFile) {
                 break;
             }
-            if (level == 0 && _current == LexemType::Semicolon) {
+            if (level == 0 && current() == LexemType::Semicolon) {
                 advance();
                 break;
             }
             advance();
         }
-        return std::make_unique<BadDeclaration>();
+        return makeNode<BadDeclaration>();
     }
 }
-std::unique_ptr<DeclarationsBlock> Parser::declarationsBlock() {
+NodePtr<DeclarationsBlock> Parser::declarationsBlock() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    if (_current != LexemType::LeftCurlyBracket) {
+    if (current() != LexemType::LeftCurlyBracket) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected '{'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
-    std::vector<std::unique_ptr<Declaration>> declarations;
-    while (_current != LexemType::RightCurlyBracket) {
-        if (_current == LexemType::EndOfFile) {
+    NodeList<Declaration> declarations;
+    while (current() != LexemType::RightCurlyBracket) {
+        if (current() == LexemType::EndOfFile) {
             auto diagnostic = Diagnostic();
             diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                     "expected '}'",
-                                                    {_previous.getSourceLocation()}));
+                                                    {previous().getSourceLocation()}));
             throw ParsingException(std::move(diagnostic));
         }
 
         declarations.push_back(declaration());
     }
 
-    if (_current != LexemType::RightCurlyBracket) {
+    if (current() != LexemType::RightCurlyBracket) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected '}'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
     advance();
 
-    return std::make_unique<DeclarationsBlock>(std::move(declarations),
-                                               SourceLocation(startLocation,
-                                                              _previous.getSourceLocation()));
+    return makeNode<DeclarationsBlock>(std::move(declarations),
+                                       SourceLocation(startLocation,
+                                                      previous().getSourceLocation()));
 }
-std::unique_ptr<ModuleDeclaration> Parser::moduleDeclaration() {
+NodePtr<ModuleDeclaration> Parser::moduleDeclaration() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    if (_current.getType() != LexemType::Mod) {
+    if (current().getType() != LexemType::Mod) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected 'mod'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
-    if (_current.getType() != LexemType::Identifier) {
+    if (current().getType() != LexemType::Identifier) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected module name",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
-    auto name = _current.getValue();
+    auto name = current().getValue();
     advance();
     auto body = declarationsBlock();
 
-    return std::make_unique<ModuleDeclaration>(std::move(name),
-                                               std::move(body),
-                                               SourceLocation(startLocation,
-                                                              _previous.getSourceLocation()));
+    return makeNode<ModuleDeclaration>(std::move(name),
+                                       std::move(body),
+                                       SourceLocation(startLocation,
+                                                      previous().getSourceLocation()));
 }
-std::unique_ptr<FunctionDeclaration> Parser::functionDeclaration() {
+NodePtr<FunctionDeclaration> Parser::functionDeclaration() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    if (_current != LexemType::Func) {
+    if (current() != LexemType::Func) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected 'func'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
-    if (_current != LexemType::Identifier) {
+    if (current() != LexemType::Identifier) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected function name",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
-    auto name = _current.getValue();
+    auto name = current().getValue();
 
     advance();
-    if (_current != LexemType::LeftRoundBracket) {
+    if (current() != LexemType::LeftRoundBracket) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected '('",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
-    std::vector<std::unique_ptr<FunctionParameter>> parameters;
-    while (_current != LexemType::RightRoundBracket) {
+    NodeList<FunctionParameter> parameters;
+    while (current() != LexemType::RightRoundBracket) {
         auto parameter = functionParameter();
         parameters.push_back(std::move(parameter));
 
-        if (_current == LexemType::Comma) {
+        if (current() == LexemType::Comma) {
             advance();
-        } else if (_current != LexemType::RightRoundBracket) {
+        } else if (current() != LexemType::RightRoundBracket) {
             auto diagnostic = Diagnostic();
             diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                     "expected ',' or ')'",
-                                                    {_previous.getSourceLocation()}));
+                                                    {previous().getSourceLocation()}));
             throw ParsingException(std::move(diagnostic));
         }
     }
 
     advance();
-    if (_current != LexemType::Arrow) {
+    if (current() != LexemType::Arrow) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected '->' before function type",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
-    if (_current != LexemType::Identifier) {
+    if (current() != LexemType::Identifier) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected function type name",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
-    auto returnType = _current.getValue();
+    auto returnType = current().getValue();
 
     advance();
     auto functionBody = stmtBlock();
 
-    return std::make_unique<FunctionDeclaration>(std::move(name),
-                                                 std::move(returnType),
-                                                 std::move(parameters),
-                                                 std::move(functionBody),
-                                                 SourceLocation(startLocation,
-                                                                _previous.getSourceLocation()));
+    auto function = makeNode<FunctionDeclaration>(std::move(name),
+                                                  std::move(returnType),
+                                                  std::move(parameters),
+                                                  std::move(functionBody),
+                                                  SourceLocation(startLocation,
+                                                                 previous().getSourceLocation()));
+    if (_completedFunctions != nullptr) {
+        _completedFunctions->push(function.get());
+    }
+    return function;
 }
-std::unique_ptr<FunctionParameter> Parser::functionParameter() {
+NodePtr<FunctionParameter> Parser::functionParameter() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    if (_current != LexemType::Identifier) {
+    if (current() != LexemType::Identifier) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected parameter type name",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
-    auto type = _current.getValue();
+    auto type = current().getValue();
 
     advance();
-    if (_current != LexemType::Identifier) {
+    if (current() != LexemType::Identifier) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected parameter name",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
-    auto name = _current.getValue();
+    auto name = current().getValue();
 
     advance();
-    return std::make_unique<FunctionParameter>(std::move(type),
-                                               std::move(name),
-                                               SourceLocation(startLocation,
-                                                              _previous.getSourceLocation()));
+    return makeNode<FunctionParameter>(std::move(type),
+                                       std::move(name),
+                                       SourceLocation(startLocation,
+                                                      previous().getSourceLocation()));
 }
 
-std::unique_ptr<Statement> Parser::stmt() {
+NodePtr<Statement> Parser::stmt() {
     try {
         stackGuard();
-        auto startLocation = _current.getSourceLocation();
+        auto startLocation = current().getSourceLocation();
 
-        std::unique_ptr<Statement> node;
-        switch (_current.getType()) {
+        NodePtr<Statement> node;
+        switch (current().getType()) {
             case LexemType::LeftCurlyBracket:
                 node = stmtBlock();
                 break;
@@ -266,13 +329,13 @@ std::unique_ptr<Statement> Parser::stmt() {
                 node = returnStmt();
                 break;
             case LexemType::Identifier:
-                if (_current.getValue() == "print") {
+                if (current().getValue() == "print") {
                     advance();
                     auto printExpression = expr();
 
-                    node = std::make_unique<Print>(std::move(printExpression),
-                                                   SourceLocation(startLocation,
-                                                                  _previous.getSourceLocation()));
+                    node = makeNode<Print>(std::move(printExpression),
+                                           SourceLocation(startLocation,
+                                                          previous().getSourceLocation()));
                     break;
                 }
 
@@ -282,7 +345,7 @@ std::unique_ptr<Statement> Parser::stmt() {
                 auto diagnostic = Diagnostic();
                 diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                         "unexpected token",
-                                                        {_previous.getSourceLocation()}));
+                                                        {previous().getSourceLocation()}));
                 throw ParsingException(std::move(diagnostic));
             }
         }
@@ -290,18 +353,18 @@ std::unique_ptr<Statement> Parser::stmt() {
         if (node->kind != Node::Kind::If &&
             node->kind != Node::Kind::While &&
             node->kind != Node::Kind::StatementBlock) {
-            if (_current != LexemType::Semicolon) {
+            if (current() != LexemType::Semicolon) {
                 auto diagnostic = Diagnostic();
 
-                const auto errorLine = _previous.getSourceLocation().getSourceFile()->getLine(_previous.getSourceLocation().getEndLine());
+                const auto errorLine = previous().getSourceLocation().getSourceFile()->getLine(previous().getSourceLocation().getEndLine());
                 auto fixLine = std::string(errorLine.begin(), errorLine.end());
-                fixLine.insert(fixLine.begin() + _previous.getSourceLocation().getEndColumn(), ';');
+                fixLine.insert(fixLine.begin() + previous().getSourceLocation().getEndColumn(), ';');
 
                 diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                         "expected semicolon",
-                                                        {_previous.getSourceLocation()})
-                                              .addFix(DiagnosticFix().addDiff(*_previous.getSourceLocation().getSourceFile(),
-                                                                              _previous.getSourceLocation().getEndLine(), fixLine)));
+                                                        {previous().getSourceLocation()})
+                                              .addFix(DiagnosticFix().addDiff(*previous().getSourceLocation().getSourceFile(),
+                                                                              previous().getSourceLocation().getEndLine(), fixLine)));
                 throw ParsingException(std::move(diagnostic));
             }
             advance();
@@ -313,108 +376,108 @@ std::unique_ptr<Statement> Parser::stmt() {
 
         int64_t level = 0;
         while (true) {
-            if (_current == LexemType::LeftCurlyBracket) {
+            if (current() == LexemType::LeftCurlyBracket) {
                 level++;
-            } else if (_current == LexemType::RightCurlyBracket) {
+            } else if (current() == LexemType::RightCurlyBracket) {
                 level--;
             }
 
-            if (level < 0) {
+            if (level < 0 || current() == LexemType::EndOfFile) {
                 break;
             }
-            if (level == 0 && _current == LexemType::Semicolon) {
+            if (level == 0 && current() == LexemType::Semicolon) {
                 advance();
                 break;
             }
             advance();
         }
-        return std::make_unique<BadStatement>();
+        return makeNode<BadStatement>();
     }
 }
-std::unique_ptr<If> Parser::ifStmt() {
+NodePtr<If> Parser::ifStmt() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    if (_current != LexemType::If) {
+    if (current() != LexemType::If) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected 'if'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
-    if (_current != LexemType::LeftRoundBracket) {
+    if (current() != LexemType::LeftRoundBracket) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected '(' after 'if'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
     auto condition = expr();
-    if (_current != LexemType::RightRoundBracket) {
+    if (current() != LexemType::RightRoundBracket) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected ')'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
     auto then = stmtBlock();
-    if (_current == LexemType::Else) {
+    if (current() == LexemType::Else) {
         advance();
 
-        std::unique_ptr<Statement> elseThen;
-        if (_current == LexemType::If) {
+        NodePtr<Statement> elseThen;
+        if (current() == LexemType::If) {
             elseThen = ifStmt();
         } else {
             elseThen = stmtBlock();
         }
 
-        return std::make_unique<If>(std::move(condition),
-                                    std::move(then),
-                                    std::move(elseThen),
-                                    SourceLocation(startLocation,
-                                                   _previous.getSourceLocation()));
+        return makeNode<If>(std::move(condition),
+                            std::move(then),
+                            std::move(elseThen),
+                            SourceLocation(startLocation,
+                                           previous().getSourceLocation()));
     } else {
-        return std::make_unique<If>(std::move(condition),
-                                    std::move(then),
-                                    nullptr,
-                                    SourceLocation(startLocation,
-                                                   _previous.getSourceLocation()));
+        return makeNode<If>(std::move(condition),
+                            std::move(then),
+                            nullptr,
+                            SourceLocation(startLocation,
+                                           previous().getSourceLocation()));
     }
 }
-std::unique_ptr<While> Parser::whileStmt() {
+NodePtr<While> Parser::whileStmt() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    if (_current != LexemType::While) {
+    if (current() != LexemType::While) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected 'while'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
-    if (_current != LexemType::LeftRoundBracket) {
+    if (current() != LexemType::LeftRoundBracket) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected '(' after 'while'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
     auto condition = expr();
-    if (_current != LexemType::RightRoundBracket) {
+    if (current() != LexemType::RightRoundBracket) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected ')'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
@@ -424,431 +487,319 @@ std::unique_ptr<While> Parser::whileStmt() {
     auto body = stmtBlock();
     --_loopNestingDepth;
 
-    return std::make_unique<While>(std::move(condition),
-                                   std::move(body),
-                                   SourceLocation(startLocation,
-                                                  _previous.getSourceLocation()));
+    return makeNode<While>(std::move(condition),
+                           std::move(body),
+                           SourceLocation(startLocation,
+                                          previous().getSourceLocation()));
 }
-std::unique_ptr<Break> Parser::breakStmt() {
+NodePtr<Break> Parser::breakStmt() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    if (_current != LexemType::Break) {
+    if (current() != LexemType::Break) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected 'break'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
     if (_loopNestingDepth > 0) {
-        return std::make_unique<Break>(SourceLocation(startLocation,
-                                                      _previous.getSourceLocation()));
+        return makeNode<Break>(SourceLocation(startLocation,
+                                              previous().getSourceLocation()));
     } else {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "break operator outside loop body",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 }
-std::unique_ptr<Return> Parser::returnStmt() {
+NodePtr<Return> Parser::returnStmt() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    if (_current != LexemType::Return) {
+    if (current() != LexemType::Return) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected 'return'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
     auto returnExpression = expr();
 
-    return std::make_unique<Return>(std::move(returnExpression),
-                                    SourceLocation(startLocation,
-                                                   _previous.getSourceLocation()));
+    return makeNode<Return>(std::move(returnExpression),
+                            SourceLocation(startLocation,
+                                           previous().getSourceLocation()));
 }
-std::unique_ptr<LocalVariableDeclaration> Parser::localVariableDeclaration() {
+NodePtr<LocalVariableDeclaration> Parser::localVariableDeclaration() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    if (_current != LexemType::Var) {
+    if (current() != LexemType::Var) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected 'var'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
-    if (_current != LexemType::Identifier) {
+    if (current() != LexemType::Identifier) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected type name in var declaration",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
-    auto type = _current.getValue();
+    auto type = current().getValue();
 
     advance();
-    if (_current != LexemType::Identifier) {
+    if (current() != LexemType::Identifier) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected variable name in var declaration",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
-    auto name = _current.getValue();
+    auto name = current().getValue();
 
     advance();
-    if (_current != LexemType::Assign) {
+    if (current() != LexemType::Assign) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected '=' after var declaration",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
     auto value = expr();
 
-    return std::make_unique<LocalVariableDeclaration>(std::move(type),
-                                                      std::move(name),
-                                                      std::move(value),
-                                                      SourceLocation(startLocation,
-                                                                     _previous.getSourceLocation()));
+    return makeNode<LocalVariableDeclaration>(std::move(type),
+                                              std::move(name),
+                                              std::move(value),
+                                              SourceLocation(startLocation,
+                                                             previous().getSourceLocation()));
 }
-std::unique_ptr<Statement> Parser::varAssign() {
+NodePtr<Statement> Parser::varAssign() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    if (_current != LexemType::Identifier) {
+    if (current() != LexemType::Identifier) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected variable name",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
-    auto name = _current.getValue();
+    auto name = current().getValue();
 
     advance();
-    if (_current != LexemType::Assign) {
+    if (current() != LexemType::Assign) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected '='",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
     auto value = expr();
 
-    return std::make_unique<Assign>(name,
-                                    std::move(value),
-                                    SourceLocation(startLocation,
-                                                   _previous.getSourceLocation()));
+    return makeNode<Assign>(name,
+                            std::move(value),
+                            SourceLocation(startLocation,
+                                           previous().getSourceLocation()));
 }
-std::unique_ptr<StatementsBlock> Parser::stmtBlock() {
+NodePtr<StatementsBlock> Parser::stmtBlock() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    if (_current != LexemType::LeftCurlyBracket) {
+    if (current() != LexemType::LeftCurlyBracket) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected '{'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
 
     advance();
-    std::vector<std::unique_ptr<Statement>> statements;
-    while (_current != LexemType::RightCurlyBracket) {
-        if (_current == LexemType::EndOfFile) {
+    NodeList<Statement> statements;
+    while (current() != LexemType::RightCurlyBracket) {
+        if (current() == LexemType::EndOfFile) {
             auto diagnostic = Diagnostic();
             diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                     "expected '}'",
-                                                    {_previous.getSourceLocation()}));
+                                                    {previous().getSourceLocation()}));
             throw ParsingException(std::move(diagnostic));
         }
 
         statements.push_back(stmt());
     }
 
-    if (_current != LexemType::RightCurlyBracket) {
+    if (current() != LexemType::RightCurlyBracket) {
         auto diagnostic = Diagnostic();
         diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                                 "expected '}'",
-                                                {_previous.getSourceLocation()}));
+                                                {previous().getSourceLocation()}));
         throw ParsingException(std::move(diagnostic));
     }
     advance();
 
-    return std::make_unique<StatementsBlock>(std::move(statements),
-                                             SourceLocation(startLocation,
-                                                            _previous.getSourceLocation()));
-}
-
-std::unique_ptr<Expression> Parser::expr() {
-    stackGuard();
-
-    return logicOr();
-}
-std::unique_ptr<Expression> Parser::logicOr() {
-    stackGuard();
-    auto startLocation = _current.getSourceLocation();
-
-    auto node = logicAnd();
-
-    while (_current == LexemType::LogicOr) {
-        auto type = _current.getType();
-        advance();
-        auto right = logicAnd();
-        node = std::make_unique<BinaryOperation>(type,
-                                                 std::move(node),
-                                                 std::move(right),
-                                                 SourceLocation(startLocation,
-                                                                _previous.getSourceLocation()));
-    }
-
-    return node;
+    return makeNode<StatementsBlock>(std::move(statements),
+                                     SourceLocation(startLocation,
+                                                    previous().getSourceLocation()));
 }
-std::unique_ptr<Expression> Parser::logicAnd() {
-    stackGuard();
-    auto startLocation = _current.getSourceLocation();
-
-    auto node = bitOr();
 
-    while (_current == LexemType::LogicAnd) {
-        auto type = _current.getType();
-        advance();
-        auto right = bitOr();
-        node = std::make_unique<BinaryOperation>(type,
-                                                 std::move(node),
-                                                 std::move(right),
-                                                 SourceLocation(startLocation,
-                                                                _previous.getSourceLocation()));
-    }
-
-    return node;
-}
-std::unique_ptr<Expression> Parser::bitOr() {
+NodePtr<Expression> Parser::expr() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
-
-    auto node = bitXor();
 
-    while (_current == LexemType::BitOr) {
-        auto type = _current.getType();
-        advance();
-        auto right = bitXor();
-        node = std::make_unique<BinaryOperation>(type,
-                                                 std::move(node),
-                                                 std::move(right),
-                                                 SourceLocation(startLocation,
-                                                                _previous.getSourceLocation()));
-    }
-
-    return node;
-}
-std::unique_ptr<Expression> Parser::bitXor() {
-    stackGuard();
-    auto startLocation = _current.getSourceLocation();
-
-    auto node = bitAnd();
-
-    while (_current == LexemType::BitXor) {
-        auto type = _current.getType();
-        advance();
-        auto right = bitAnd();
-        node = std::make_unique<BinaryOperation>(type,
-                                                 std::move(node),
-                                                 std::move(right),
-                                                 SourceLocation(startLocation,
-                                                                _previous.getSourceLocation()));
-    }
-
-    return node;
-}
-std::unique_ptr<Expression> Parser::bitAnd() {
-    stackGuard();
-    auto startLocation = _current.getSourceLocation();
-
-    auto node = equal();
-
-    while (_current == LexemType::BitAnd) {
-        auto type = _current.getType();
-        advance();
-        auto right = equal();
-        node = std::make_unique<BinaryOperation>(type,
-                                                 std::move(node),
-                                                 std::move(right),
-                                                 SourceLocation(startLocation,
-                                                                _previous.getSourceLocation()));
-    }
-
-    return node;
-}
-std::unique_ptr<Expression> Parser::equal() {
-    stackGuard();
-    auto startLocation = _current.getSourceLocation();
-
-    auto node = relat();
+    auto operatorsBase = _operators.size();
+    auto operandsBase = _operands.size();
+    size_t openBrackets = 0;
+    try {
+        while (true) {
+            while (current() == LexemType::Minus ||
+                   current() == LexemType::Not ||
+                   current() == LexemType::LeftRoundBracket) {
+                auto kind = current() == LexemType::LeftRoundBracket ? PendingOperator::Kind::Bracket
+                                                                      : PendingOperator::Kind::Prefix;
+                openBrackets += kind == PendingOperator::Kind::Bracket;
+                _operators.push_back({kind, current().getType(), current().getSourceLocation()});
+                advance();
+            }
+            auto start = current().getSourceLocation();
+            _operands.push_back({primary(), start});
 
-    if (_current == LexemType::Equal ||
-        _current == LexemType::Unequal) {
-        auto type = _current.getType();
-        advance();
-        auto right = relat();
-        node = std::make_unique<BinaryOperation>(type,
-                                                 std::move(node),
-                                                 std::move(right),
-                                                 SourceLocation(startLocation,
-                                                                _previous.getSourceLocation()));
-    }
+            while (openBrackets > 0 && current() == LexemType::RightRoundBracket) {
+                while (_operators.back().kind != PendingOperator::Kind::Bracket) {
+                    reduceOperator();
+                }
+                // The bracketed expression keeps its location, operations on it start at the bracket
+                _operands.back().start = _operators.back().location;
+                _operators.pop_back();
+                --openBrackets;
+                advance();
+            }
 
-    return node;
-}
-std::unique_ptr<Expression> Parser::relat() {
-    stackGuard();
-    auto startLocation = _current.getSourceLocation();
+            const auto& binary = getBinaryOperator(current().getType());
+            if (binary.precedence == 0) {
+                break;
+            }
+            while (_operators.size() > operatorsBase) {
+                const auto& pending = _operators.back();
+                if (pending.kind == PendingOperator::Kind::Bracket) {
+                    break;
+                }
+                if (pending.kind == PendingOperator::Kind::Binary) {
+                    const auto& pendingBinary = getBinaryOperator(pending.type);
+                    if (pendingBinary.precedence < binary.precedence ||
+                        (pendingBinary.precedence == binary.precedence &&
+                         binary.associativity != Associativity::Left)) {
+                        break;
+                    }
+                }
+                reduceOperator();
+            }
+            // The operator is left to whatever follows the expression
+            if (binary.associativity == Associativity::None &&
+                _operators.size() > operatorsBase &&
+                _operators.back().kind == PendingOperator::Kind::Binary &&
+                getBinaryOperator(_operators.back().type).precedence == binary.precedence) {
+                break;
+            }
 
-    auto node = term();
+            _operators.push_back({PendingOperator::Kind::Binary, current().getType(), SourceLocation()});
+            advance();
+        }
 
-    if (_current == LexemType::Less ||
-        _current == LexemType::LessEqual ||
-        _current == LexemType::Greater ||
-        _current == LexemType::GreaterEqual) {
-        auto type = _current.getType();
-        advance();
-        auto right = relat();
-        node = std::make_unique<BinaryOperation>(type,
-                                                 std::move(node),
-                                                 std::move(right),
-                                                 SourceLocation(startLocation,
-                                                                _previous.getSourceLocation()));
+        if (openBrackets > 0) {
+            auto diagnostic = Diagnostic();
+            diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
+                                                    "expected '}",
+                                                    {previous().getSourceLocation()}));
+            throw ParsingException(std::move(diagnostic));
+        }
+    } catch (...) {
+        _operators.erase(_operators.begin() + static_cast<std::ptrdiff_t>(operatorsBase), _operators.end());
+        _operands.erase(_operands.begin() + static_cast<std::ptrdiff_t>(operandsBase), _operands.end());
+        throw;
     }
 
-    return node;
-}
-std::unique_ptr<Expression> Parser::term() {
-    stackGuard();
-    auto startLocation = _current.getSourceLocation();
-
-    auto node = fact();
-
-    while (_current == LexemType::Plus ||
-           _current == LexemType::Minus) {
-        auto type = _current.getType();
-        advance();
-        auto right = fact();
-        node = std::make_unique<BinaryOperation>(type,
-                                                 std::move(node),
-                                                 std::move(right),
-                                                 SourceLocation(startLocation,
-                                                                _previous.getSourceLocation()));
+    while (_operators.size() > operatorsBase) {
+        reduceOperator();
     }
-
-    return node;
+    auto expression = std::move(_operands.back().expression);
+    _operands.pop_back();
+    return expression;
 }
-std::unique_ptr<Expression> Parser::fact() {
-    stackGuard();
-    auto startLocation = _current.getSourceLocation();
-
-    auto node = unary();
-
-    while (_current == LexemType::Multiply ||
-           _current == LexemType::Divide ||
-           _current == LexemType::Remainder) {
-        auto type = _current.getType();
-        advance();
-        auto right = unary();
-        node = std::make_unique<BinaryOperation>(type,
-                                                 std::move(node),
-                                                 std::move(right),
-                                                 SourceLocation(startLocation,
-                                                                _previous.getSourceLocation()));
-    }
-
-    return node;
+void Parser::reduceOperator() {
+    auto pending = _operators.back();
+    _operators.pop_back();
+    auto right = std::move(_operands.back());
+    _operands.pop_back();
+
+    // Every operand ends at the token before the one that made the parser reduce it
+    if (pending.kind == PendingOperator::Kind::Prefix) {
+        _operands.push_back({makeNode<PrefixOperation>(pending.type,
+                                                       std::move(right.expression),
+                                                       SourceLocation(pending.location,
+                                                                      previous().getSourceLocation())),
+                             pending.location});
+        return;
+    }
+
+    auto& left = _operands.back();
+    left.expression = makeNode<BinaryOperation>(pending.type,
+                                                std::move(left.expression),
+                                                std::move(right.expression),
+                                                SourceLocation(left.start,
+                                                               previous().getSourceLocation()));
 }
-std::unique_ptr<Expression> Parser::unary() {
+NodePtr<Expression> Parser::primary() {
     stackGuard();
-    auto startLocation = _current.getSourceLocation();
+    auto startLocation = current().getSourceLocation();
 
-    std::unique_ptr<Expression> node;
-
-    if (_current == LexemType::Minus ||
-        _current == LexemType::Not) {
-        auto type = _current.getType();
+    if (current() == LexemType::Number) {
+        auto value = current().getValue();
         advance();
-        node = std::make_unique<PrefixOperation>(type,
-                                                 unary(),
-                                                 SourceLocation(startLocation,
-                                                                _previous.getSourceLocation()));
-    } else {
-        node = primary();
-    }
-
-    return node;
-}
-std::unique_ptr<Expression> Parser::primary() {
-    stackGuard();
-    auto startLocation = _current.getSourceLocation();
-
-    if (_current == LexemType::Number) {
-        auto value = _current.getValue();
+        return makeNode<Number>(std::move(value),
+                                SourceLocation(startLocation,
+                                               previous().getSourceLocation()));
+    } else if (current() == LexemType::Identifier) {
+        auto name = current().getValue();
         advance();
-        return std::make_unique<Number>(std::move(value),
+        if (current() != LexemType::LeftRoundBracket) {
+            return makeNode<Identifier>(std::move(name),
                                         SourceLocation(startLocation,
-                                                       _previous.getSourceLocation()));
-    } else if (_current == LexemType::Identifier) {
-        auto name = _current.getValue();
-        advance();
-        if (_current != LexemType::LeftRoundBracket) {
-            return std::make_unique<Identifier>(std::move(name),
-                                                SourceLocation(startLocation,
-                                                               _previous.getSourceLocation()));
+                                                       previous().getSourceLocation()));
         } else {
             advance();
-            std::vector<std::unique_ptr<Expression>> arguments;
-            while (_current != LexemType::RightRoundBracket) {
+            NodeList<Expression> arguments;
+            while (current() != LexemType::RightRoundBracket) {
                 auto expression = expr();
                 arguments.push_back(std::move(expression));
 
-                if (_current == LexemType::Comma) {
+                if (current() == LexemType::Comma) {
                     advance();
                 }
             }
             advance();
 
-            return std::make_unique<CallFunction>(std::move(name),
-                                                  std::move(arguments),
-                                                  SourceLocation(startLocation,
-                                                                 _previous.getSourceLocation()));
-        }
-    } else if (_current == LexemType::LeftRoundBracket) {
-        advance();
-        auto expression = expr();
-
-        if (_current.getType() == LexemType::RightRoundBracket) {
-            advance();
-            return expression;
-        } else {
-            auto diagnostic = Diagnostic();
-            diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
-                                                    "expected '}",
-                                                    {_previous.getSourceLocation()}));
-            throw ParsingException(std::move(diagnostic));
+            return makeNode<CallFunction>(std::move(name),
+                                          std::move(arguments),
+                                          SourceLocation(startLocation,
+                                                         previous().getSourceLocation()));
         }
     }
 
     auto diagnostic = Diagnostic();
     diagnostic.addMessage(DiagnosticMessage(DiagnosticMessage::Severity::Error,
                                             "unexpected token",
-                                            {_previous.getSourceLocation()}));
+                                            {previous().getSourceLocation()}));
     throw ParsingException(std::move(diagnostic));
 }
@@ -5,61 +5,115 @@
 #define VUG_PARSER_HPP
 
 #include <memory>
+#include <span>
 #include <utility>
+#include <vector>
 
+#include "AST/ASTArena.hpp"
 #include "AST/ASTNodesForward.hpp"
+#include "Diagnostic/Diagnostic.hpp"
 #include "Lexing/Lexer.hpp"
+#include "Lexing/Token.hpp"
+#include "Misc/SingleProducerQueue.hpp"
 
 class DiagnosticManager;
 
 class Parser {
 public:
-    explicit Parser(Lexer& lexer, DiagnosticManager& diagnosticManager)
-        : _lexer(lexer), _diagnosticManager(diagnosticManager) { advance(); }
-
-    Token advance() {
-        _previous = _current;
-        return (_current = _lexer.getToken());
+    // `tokens` is the whole file as Lexer::getTokens leaves it, ending with EndOfFile
+    explicit Parser(const std::vector<Token>& tokens, DiagnosticManager& diagnosticManager)
+        : _tokens(tokens), _diagnosticManager(diagnosticManager) {}
+    // Parses the batches another thread lexes into `queue` as they come. Each function declaration
+    // parsed is pushed to `completedFunctions`, when given, for another thread to analyze while parsing
+    // goes on; being in the arena, it stays valid even when a syntax error discards its enclosing block.
+    Parser(TokenQueue& queue,
+           DiagnosticManager& diagnosticManager,
+           SingleProducerQueue<FunctionDeclaration*>* completedFunctions = nullptr);
+    ~Parser();
+
+    // Stays on EndOfFile once there
+    const Token& advance() {
+        if (current() == LexemType::EndOfFile) {
+            return current();
+        }
+        _previous = &current();
+        if (++_position == _tokens.size()) {
+            _tokens = *_queue->pop();
+            _position = 0;
+        }
+        return current();
     }
 
-    std::unique_ptr<Node> program();
-
-    std::unique_ptr<Declaration> declaration();
-    std::unique_ptr<ModuleDeclaration> moduleDeclaration();
-    std::unique_ptr<FunctionDeclaration> functionDeclaration();
-    std::unique_ptr<FunctionParameter> functionParameter();
-    std::unique_ptr<DeclarationsBlock> declarationsBlock();
-
-    std::unique_ptr<Statement> stmt();
-    std::unique_ptr<If> ifStmt();
-    std::unique_ptr<While> whileStmt();
-    std::unique_ptr<Break> breakStmt();
-    std::unique_ptr<Return> returnStmt();
-    std::unique_ptr<LocalVariableDeclaration> localVariableDeclaration();
-    std::unique_ptr<Statement> varAssign();
-    std::unique_ptr<StatementsBlock> stmtBlock();
-
-    std::unique_ptr<Expression> expr();
-    std::unique_ptr<Expression> logicOr();
-    std::unique_ptr<Expression> logicAnd();
-    std::unique_ptr<Expression> bitOr();
-    std::unique_ptr<Expression> bitXor();
-    std::unique_ptr<Expression> bitAnd();
-    std::unique_ptr<Expression> equal();
-    std::unique_ptr<Expression> relat();
-    std::unique_ptr<Expression> term();
-    std::unique_ptr<Expression> fact();
-    std::unique_ptr<Expression> unary();
-    std::unique_ptr<Expression> primary();
+    NodePtr<Node> program();
+
+    NodePtr<Declaration> declaration();
+    NodePtr<ModuleDeclaration> moduleDeclaration();
+    NodePtr<FunctionDeclaration> functionDeclaration();
+    NodePtr<FunctionParameter> functionParameter();
+    NodePtr<DeclarationsBlock> declarationsBlock();
+
+    NodePtr<Statement> stmt();
+    NodePtr<If> ifStmt();
+    NodePtr<While> whileStmt();
+    NodePtr<Break> breakStmt();
+    NodePtr<Return> returnStmt();
+    NodePtr<LocalVariableDeclaration> localVariableDeclaration();
+    NodePtr<Statement> varAssign();
+    NodePtr<StatementsBlock> stmtBlock();
+
+    // Operators by the precedence table in Parser.cpp, on explicit stacks rather than one call per
+    // precedence level, so only call arguments nest native calls
+    NodePtr<Expression> expr();
+    // Number, identifier or call
+    NodePtr<Expression> primary();
 
 protected:
-    Lexer& _lexer;
+    // The whole file, or the batch being parsed when the tokens come from a queue
+    std::span<const Token> _tokens;
+    TokenQueue* _queue{nullptr};
     DiagnosticManager& _diagnosticManager;
 
-    Token _current{LexemType::EndOfFile, SourceLocation()};
-    Token _previous{LexemType::EndOfFile, SourceLocation()};
+    SingleProducerQueue<FunctionDeclaration*>* _completedFunctions{nullptr};
+
+    size_t _position{0};
+    // Previous token before the first one
+    const Token _start{LexemType::EndOfFile, SourceLocation()};
+    // May be in the batch before the current one, which the queue keeps until the next pop
+    const Token* _previous{&_start};
 
     uint32_t _loopNestingDepth = 0;
+
+    // An operator waiting for its right operand, or an open bracket
+    struct PendingOperator {
+        enum class Kind {
+            Binary,
+            Prefix,
+            Bracket,
+        };
+
+        Kind kind;
+        LexemType type;
+        // Location of a prefix operator or bracket
+        SourceLocation location;
+    };
+    struct Operand {
+        NodePtr<Expression> expression;
+        // First token, prefix operators and brackets in front of the expression included
+        SourceLocation start;
+    };
+    // Shared by the expressions being parsed, each one uses the part above what it found there
+    std::vector<PendingOperator> _operators;
+    std::vector<Operand> _operands;
+
+    // Replaces the top operator and its operands by the operation
+    void reduceOperator();
+
+    [[nodiscard]] const Token& current() const {
+        return _tokens[_position];
+    }
+    [[nodiscard]] const Token& previous() const {
+        return *_previous;
+    }
 };
 
 class ParsingException : public std::exception {
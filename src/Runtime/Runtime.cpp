@@ -0,0 +1,19 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Runtime.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+
+void vug_print_int64(int64_t value) {
+    std::printf("%" PRId64 "\n", value);
+}
+void vug_print_uint64(uint64_t value) {
+    std::printf("%" PRIu64 "\n", value);
+}
+
+int main() {
+    vug_main();
+    return 0;
+}
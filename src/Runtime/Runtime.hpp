@@ -0,0 +1,17 @@
+// This Source Code Form is subject to the terms of the Mozilla Public License, v. 2.0.
+// If a copy of the MPL was not distributed with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef VUG_RUNTIME_HPP
+#define VUG_RUNTIME_HPP
+
+#include <cstdint>
+
+// Entry points shared with objects produced by `Vug --emit-obj`
+extern "C" {
+    int64_t vug_main();
+
+    void vug_print_int64(int64_t value);
+    void vug_print_uint64(uint64_t value);
+}
+
+#endif//VUG_RUNTIME_HPP
@@ -51,7 +51,7 @@ void GlobalScopePass::visit(FunctionDeclaration& node) {
 
     node.symbolRef->startDefinition();
     for (const auto& parameter: node.parameters) {
-        auto parameterSymbol = _context.addSymbol<LocalVariableSymbol>(parameter->name);
+        auto parameterSymbol = _context.addSymbol<LocalVariableSymbol>(std::string(parameter->name));
 
         parameterSymbol->startDefinition();
         auto parameterTypeRecord = _context.getSymbolTable().findSymbol(parameter->type);
@@ -4,7 +4,10 @@
 #ifndef VUG_GLOBALSCOPEPASS_HPP
 #define VUG_GLOBALSCOPEPASS_HPP
 
+#include <string_view>
+
 #include "AST/ASTWalker.hpp"
+#include "Misc/PassProperty.hpp"
 
 
 class DiagnosticManager;
@@ -12,6 +15,11 @@ class SymbolContext;
 
 class GlobalScopePass : public ASTWalker {
 public:
+    static constexpr std::string_view name = "global-scope";
+    static constexpr auto required = PassProperty::ModulesDefined;
+    static constexpr auto provided = PassProperty::GlobalsResolved;
+    static constexpr auto invalidated = PassProperty::None;
+
     GlobalScopePass(Node& ast,
                     SymbolContext& context,
                     DiagnosticManager& diagnosticManager)
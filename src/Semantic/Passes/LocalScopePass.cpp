@@ -257,7 +257,7 @@ void LocalScopePass::visit(LocalVariableDeclaration& node) {
         return;
     }
 
-    auto symbol = _context.addSymbol<LocalVariableSymbol>(node.name);
+    auto symbol = _context.addSymbol<LocalVariableSymbol>(std::string(node.name));
     symbol->setTypeSymbol(static_cast<TypeSymbol*>(&typeFindResult.record->symbol));
     node.symbolRef = symbol;
 
@@ -5,8 +5,10 @@
 #define VUG_LOCALSCOPEPASS_HPP
 
 #include <stack>
+#include <string_view>
 
 #include "AST/ASTWalker.hpp"
+#include "Misc/PassProperty.hpp"
 
 
 class DiagnosticManager;
@@ -14,6 +16,11 @@ class SymbolContext;
 
 class LocalScopePass : public ASTWalker {
 public:
+    static constexpr std::string_view name = "local-scope";
+    static constexpr auto required = PassProperty::GlobalsResolved;
+    static constexpr auto provided = PassProperty::LocalsResolved;
+    static constexpr auto invalidated = PassProperty::None;
+
     LocalScopePass(Node& ast,
                    SymbolContext& context,
                    DiagnosticManager& diagnosticManager)
@@ -25,7 +25,7 @@ void ModuleDefinitionPass::visit(Node& node) {
 void ModuleDefinitionPass::visit(ModuleDeclaration& node) {
     stackGuard();
 
-    auto module = _context.addSymbol<ModuleSymbol>(node.name);
+    auto module = _context.addSymbol<ModuleSymbol>(std::string(node.name));
     node.symbolRef = module;
 
     module->startDefinition();
@@ -47,6 +47,12 @@ void ModuleDefinitionPass::visit(DeclarationsBlock& node) {
 void ModuleDefinitionPass::visit(FunctionDeclaration& node) {
     stackGuard();
 
-    auto function = _context.addSymbol<FunctionSymbol>(node.name);
+    if (node.symbolRef == nullptr) {
+        defineFunction(node, _context);
+    }
+}
+
+void ModuleDefinitionPass::defineFunction(FunctionDeclaration& node, SymbolContext& context) {
+    auto function = context.addSymbol<FunctionSymbol>(std::string(node.name));
     node.symbolRef = function;
 }
\ No newline at end of file
@@ -4,13 +4,21 @@
 #ifndef VUG_MODULEDEFINITIONPASS_HPP
 #define VUG_MODULEDEFINITIONPASS_HPP
 
+#include <string_view>
+
 #include "AST/ASTWalker.hpp"
+#include "Misc/PassProperty.hpp"
 
 class DiagnosticManager;
 class SymbolContext;
 
 class ModuleDefinitionPass : public ASTWalker {
 public:
+    static constexpr std::string_view name = "module-definition";
+    static constexpr auto required = PassProperty::None;
+    static constexpr auto provided = PassProperty::ModulesDefined;
+    static constexpr auto invalidated = PassProperty::None;
+
     ModuleDefinitionPass(Node& ast,
                          SymbolContext& context,
                          DiagnosticManager& diagnosticManager)
@@ -19,6 +27,9 @@ public:
           _diagnosticManager(diagnosticManager) {}
 
     void analyze();
+    // Declares the function's symbol, which needs nothing from the declarations around it, so that
+    // functions can be defined as they are parsed. The pass skips functions defined before it.
+    static void defineFunction(FunctionDeclaration& node, SymbolContext& context);
 
     void visit(ModuleDeclaration& node) override;
     void visit(DeclarationsBlock& node) override;
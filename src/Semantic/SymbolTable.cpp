@@ -26,7 +26,7 @@ SymbolTable::InsertResult SymbolTable::insertSymbol(Symbol& symbol, bool canShad
 
     return {InsertResult::Kind::Successful};
 }
-SymbolTable::FindResult SymbolTable::findSymbol(const std::string& name) {
+SymbolTable::FindResult SymbolTable::findSymbol(std::string_view name) {
     auto it = _names.find(name);
 
     if (it == _names.end()) {
@@ -7,6 +7,8 @@
 #include <cstdint>
 #include <list>
 #include <stack>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include "Symbol.hpp"
@@ -57,7 +59,7 @@ public:
             : kind(kind),
               record(record) {}
     };
-    FindResult findSymbol(const std::string& name);
+    FindResult findSymbol(std::string_view name);
 
     [[nodiscard]] inline size_t getDepth() const {
         return _scopes.size();
@@ -81,10 +83,19 @@ public:
     }
 
 protected:
+    // Lets names be looked up by views without building a string
+    struct NameHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view name) const {
+            return std::hash<std::string_view>()(name);
+        }
+    };
+
     std::stack<std::list<SymbolTableRecord>,
                std::list<std::list<SymbolTableRecord>>>
             _scopes;
-    std::unordered_map<std::string, const SymbolTableRecord*> _names;
+    std::unordered_map<std::string, const SymbolTableRecord*, NameHash, std::equal_to<>> _names;
 };
 
 #endif//VUG_SYMBOLTABLE_HPP